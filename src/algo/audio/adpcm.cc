@@ -0,0 +1,276 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/audio/adpcm.h"
+#include <algorithm>
+#include "algo/lazy.h"
+#include "algo/range.h"
+#include "err.h"
+#include "io/memory_byte_stream.h"
+
+using namespace au;
+using namespace au::algo::audio;
+
+namespace
+{
+    struct MsAdpcmCoefficients final
+    {
+        int first;
+        int second;
+    };
+
+    struct MsAdpcmChannel final
+    {
+        MsAdpcmCoefficients coefficients;
+        int delta;
+        int sample1;
+        int sample2;
+    };
+
+    struct ImaAdpcmTables final
+    {
+        int diff[89][16];
+        u8 next_index[89][16];
+    };
+}
+
+static const int ms_adaptation_table[16] =
+{
+    230, 230, 230, 230, 307, 409, 512, 614,
+    768, 614, 512, 409, 307, 230, 230, 230,
+};
+
+static const MsAdpcmCoefficients ms_default_coefficients[] =
+{
+    {256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208},
+    {392, -232},
+};
+
+static const int ima_step_table[89] =
+{
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int ima_index_table[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static const algo::Lazy<ImaAdpcmTables> ima_tables([]()
+{
+    ImaAdpcmTables tables;
+    for (const auto index : algo::range(89))
+    for (const auto nibble : algo::range(16))
+    {
+        const auto step = ima_step_table[index];
+        auto diff = step >> 3;
+        if (nibble & 4) diff += step;
+        if (nibble & 2) diff += step >> 1;
+        if (nibble & 1) diff += step >> 2;
+        tables.diff[index][nibble] = nibble & 8 ? -diff : diff;
+        tables.next_index[index][nibble] = std::max(
+            0, std::min(88, index + ima_index_table[nibble & 7]));
+    }
+    return tables;
+});
+
+static inline int clamp_s16(const int sample)
+{
+    return std::max(-0x8000, std::min(0x7FFF, sample));
+}
+
+static inline s16 read_s16(const u8 *input)
+{
+    return static_cast<s16>(input[0] | (input[1] << 8));
+}
+
+static inline s16 expand_ms_nibble(MsAdpcmChannel &channel, const u8 nibble)
+{
+    const auto signed_nibble = static_cast<s8>(nibble << 4) >> 4;
+    const auto prediction = (channel.sample1 * channel.coefficients.first
+        + channel.sample2 * channel.coefficients.second) >> 8;
+    const auto sample
+        = clamp_s16(prediction + signed_nibble * channel.delta);
+    channel.sample2 = channel.sample1;
+    channel.sample1 = sample;
+    channel.delta = std::max(
+        16, (ms_adaptation_table[nibble] * channel.delta) >> 8);
+    return sample;
+}
+
+static std::vector<MsAdpcmCoefficients> read_ms_coefficients(
+    const bstr &extra_codec_headers)
+{
+    if (extra_codec_headers.size() < 4)
+    {
+        return std::vector<MsAdpcmCoefficients>(
+            std::begin(ms_default_coefficients),
+            std::end(ms_default_coefficients));
+    }
+    io::MemoryByteStream header_stream(extra_codec_headers);
+    header_stream.skip(2); // samples per block, implied by block align
+    const auto coefficient_count = header_stream.read_le<u16>();
+    if (!coefficient_count)
+        throw err::CorruptDataError("Missing MS ADPCM coefficients");
+    std::vector<MsAdpcmCoefficients> coefficients(coefficient_count);
+    for (auto &pair : coefficients)
+    {
+        pair.first = static_cast<s16>(header_stream.read_le<u16>());
+        pair.second = static_cast<s16>(header_stream.read_le<u16>());
+    }
+    return coefficients;
+}
+
+bstr algo::audio::decode_ms_adpcm(
+    const bstr &input,
+    const size_t channel_count,
+    const size_t block_align,
+    const bstr &extra_codec_headers)
+{
+    const auto header_size = 7 * channel_count;
+    if (!channel_count || block_align <= header_size)
+        throw err::CorruptDataError("Invalid MS ADPCM block alignment");
+
+    const auto coefficients = read_ms_coefficients(extra_codec_headers);
+
+    const auto block_frames = [&](const size_t block_size)
+    {
+        return block_size < header_size
+            ? 0
+            : 2 + (block_size - header_size) * 2 / channel_count;
+    };
+    const auto full_block_count = input.size() / block_align;
+    const auto frame_count = full_block_count * block_frames(block_align)
+        + block_frames(input.size() % block_align);
+
+    bstr output(frame_count * channel_count * 2);
+    auto output_ptr = output.get<s16>();
+    std::vector<MsAdpcmChannel> channels(channel_count);
+
+    for (size_t offset = 0; offset < input.size(); offset += block_align)
+    {
+        const auto block_size = std::min(block_align, input.size() - offset);
+        if (block_size < header_size)
+            break;
+
+        const auto block = input.get<u8>() + offset;
+        for (const auto i : algo::range(channel_count))
+        {
+            auto &channel = channels[i];
+            const auto predictor = block[i];
+            if (predictor >= coefficients.size())
+                throw err::CorruptDataError("Invalid MS ADPCM predictor");
+            channel.coefficients = coefficients[predictor];
+            channel.delta = read_s16(block + channel_count + 2 * i);
+            channel.sample1 = read_s16(block + channel_count * 3 + 2 * i);
+            channel.sample2 = read_s16(block + channel_count * 5 + 2 * i);
+        }
+        for (const auto &channel : channels)
+            *output_ptr++ = channel.sample2;
+        for (const auto &channel : channels)
+            *output_ptr++ = channel.sample1;
+
+        // nibbles are interleaved across channels, high nibble first
+        const auto nibble_count
+            = (block_frames(block_size) - 2) * channel_count;
+        const auto data = block + header_size;
+        size_t channel_index = 0;
+        for (const auto i : algo::range(nibble_count))
+        {
+            const auto nibble = (data[i >> 1] >> (i & 1 ? 0 : 4)) & 0x0F;
+            *output_ptr++ = expand_ms_nibble(channels[channel_index], nibble);
+            if (++channel_index == channel_count)
+                channel_index = 0;
+        }
+    }
+
+    return output;
+}
+
+bstr algo::audio::decode_ima_adpcm(
+    const bstr &input,
+    const size_t channel_count,
+    const size_t block_align)
+{
+    const auto header_size = 4 * channel_count;
+    if (!channel_count || block_align <= header_size)
+        throw err::CorruptDataError("Invalid IMA ADPCM block alignment");
+
+    // after the header each channel contributes 4 bytes = 8 frames at a time
+    const auto group_size = 4 * channel_count;
+    const auto block_frames = [&](const size_t block_size)
+    {
+        return block_size < header_size
+            ? 0
+            : 1 + (block_size - header_size) / group_size * 8;
+    };
+    const auto full_block_count = input.size() / block_align;
+    const auto frame_count = full_block_count * block_frames(block_align)
+        + block_frames(input.size() % block_align);
+
+    bstr output(frame_count * channel_count * 2);
+    auto output_ptr = output.get<s16>();
+    const auto &tables = *ima_tables;
+    std::vector<int> samples(channel_count);
+    std::vector<size_t> indices(channel_count);
+
+    for (size_t offset = 0; offset < input.size(); offset += block_align)
+    {
+        const auto block_size = std::min(block_align, input.size() - offset);
+        if (block_size < header_size)
+            break;
+
+        const auto block = input.get<u8>() + offset;
+        for (const auto i : algo::range(channel_count))
+        {
+            samples[i] = read_s16(block + 4 * i);
+            indices[i] = block[4 * i + 2];
+            if (indices[i] > 88)
+                throw err::CorruptDataError("Invalid IMA ADPCM step index");
+            *output_ptr++ = samples[i];
+        }
+
+        const auto group_count = (block_size - header_size) / group_size;
+        auto data = block + header_size;
+        for (const auto group : algo::range(group_count))
+        {
+            for (const auto i : algo::range(channel_count))
+            {
+                auto sample = samples[i];
+                auto index = indices[i];
+                for (const auto j : algo::range(8))
+                {
+                    const auto nibble = (data[j >> 1] >> (j & 1 ? 4 : 0)) & 15;
+                    sample = clamp_s16(sample + tables.diff[index][nibble]);
+                    index = tables.next_index[index][nibble];
+                    output_ptr[j * channel_count + i] = sample;
+                }
+                samples[i] = sample;
+                indices[i] = index;
+                data += 4;
+            }
+            output_ptr += 8 * channel_count;
+        }
+    }
+
+    return output;
+}
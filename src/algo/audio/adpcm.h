@@ -0,0 +1,41 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace audio {
+
+    // Both decoders take the raw contents of a WAV data chunk and return
+    // interleaved 16-bit PCM. A trailing partial block is decoded as far as
+    // it goes.
+
+    bstr decode_ms_adpcm(
+        const bstr &input,
+        const size_t channel_count,
+        const size_t block_align,
+        const bstr &extra_codec_headers);
+
+    bstr decode_ima_adpcm(
+        const bstr &input,
+        const size_t channel_count,
+        const size_t block_align);
+
+} } }
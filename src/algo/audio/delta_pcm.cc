@@ -0,0 +1,113 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/audio/delta_pcm.h"
+#include <algorithm>
+#include <vector>
+#include "algo/range.h"
+
+using namespace au;
+using namespace au::algo::audio;
+
+static const u16 delta_table[64] =
+{
+    0,    2,    4,    6,    8,    10,   12,   15,
+    18,   21,   24,   28,   32,   36,   40,   44,
+    49,   54,   59,   64,   70,   76,   82,   88,
+    95,   102,  109,  116,  124,  132,  140,  148,
+    160,  170,  180,  190,  200,  210,  220,  230,
+    240,  255,  270,  285,  300,  320,  340,  360,
+    380,  400,  425,  450,  475,  500,  525,  550,
+    580,  610,  650,  700,  750,  800,  900,  1000,
+};
+
+struct DeltaPcmDecoder::Priv final
+{
+    Priv(const size_t channel_count, const int multiplier);
+
+    size_t channel_count;
+    u16 keep[0x100];
+    u16 add[0x100];
+    std::vector<u16> previous;
+};
+
+DeltaPcmDecoder::Priv::Priv(const size_t channel_count, const int multiplier)
+    : channel_count(channel_count), previous(channel_count)
+{
+    // every byte maps to "sample = (sample & keep) + add", which turns the
+    // reset and the signed step into the same branchless update
+    for (const auto b : algo::range(0x100))
+    {
+        if (b & 0x80)
+        {
+            keep[b] = 0;
+            add[b] = b << 9;
+        }
+        else
+        {
+            const auto step = delta_table[b & 0x3F] * multiplier;
+            keep[b] = 0xFFFF;
+            add[b] = b & 0x40 ? -step : step;
+        }
+    }
+}
+
+DeltaPcmDecoder::DeltaPcmDecoder(
+    const size_t channel_count, const int multiplier)
+    : p(new Priv(channel_count, multiplier))
+{
+}
+
+DeltaPcmDecoder::~DeltaPcmDecoder()
+{
+}
+
+bstr DeltaPcmDecoder::decode(const bstr &input)
+{
+    if (!p->channel_count)
+        return ""_b;
+    const auto frame_count = input.size() / p->channel_count;
+    bstr output(frame_count * p->channel_count * 2);
+    auto input_ptr = input.get<u8>();
+    auto output_ptr = output.get<u16>();
+    for (const auto i : algo::range(frame_count))
+    for (const auto j : algo::range(p->channel_count))
+    {
+        const auto b = *input_ptr++;
+        p->previous[j] = (p->previous[j] & p->keep[b]) + p->add[b];
+        *output_ptr++ = p->previous[j];
+    }
+    return output;
+}
+
+bstr algo::audio::decode_delta_pcm(
+    const bstr &input,
+    const size_t channel_count,
+    const size_t sample_count,
+    const int multiplier)
+{
+    bstr output(sample_count * channel_count * 2);
+    if (!channel_count)
+        return output;
+    const auto frame_count
+        = std::min(sample_count, input.size() / channel_count);
+    DeltaPcmDecoder decoder(channel_count, multiplier);
+    const auto samples
+        = decoder.decode(input.substr(0, frame_count * channel_count));
+    std::copy(samples.begin(), samples.end(), output.begin());
+    return output;
+}
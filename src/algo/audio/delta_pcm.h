@@ -0,0 +1,54 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace audio {
+
+    // 8-bit delta coding used by WADY files: a byte with the top bit set
+    // resets the channel to its lower 7 bits shifted into the sample's high
+    // bits, anything else adds or subtracts (bit 6) a step from a fixed
+    // 64-entry table scaled by the multiplier. Decodes at most sample_count
+    // frames of interleaved channels; frames past the end of input are left
+    // silent.
+    bstr decode_delta_pcm(
+        const bstr &input,
+        const size_t channel_count,
+        const size_t sample_count,
+        const int multiplier);
+
+    // Same as above, but keeps the channels' state between calls so that
+    // long inputs can be decoded piece by piece. Trailing bytes that don't
+    // make up a whole frame are ignored.
+    class DeltaPcmDecoder final
+    {
+    public:
+        DeltaPcmDecoder(const size_t channel_count, const int multiplier);
+        ~DeltaPcmDecoder();
+        bstr decode(const bstr &input);
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} } }
@@ -16,10 +16,13 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/crypt/sha1.h"
+#include <algorithm>
 #include <openssl/sha.h>
 
 using namespace au;
 
+static const size_t chunk_size = 64 * 1024;
+
 bstr algo::crypt::sha1(const bstr &input)
 {
     SHA_CTX ctx;
@@ -29,3 +32,18 @@ bstr algo::crypt::sha1(const bstr &input)
     SHA1_Final(output, &ctx);
     return bstr(output, SHA_DIGEST_LENGTH);
 }
+
+bstr algo::crypt::sha1(io::BaseByteStream &input_stream)
+{
+    SHA_CTX ctx;
+    SHA1_Init(&ctx);
+    u8 output[SHA_DIGEST_LENGTH];
+    while (input_stream.left())
+    {
+        const auto chunk = input_stream.read(
+            std::min(chunk_size, input_stream.left()));
+        SHA1_Update(&ctx, chunk.get<const u8>(), chunk.size());
+    }
+    SHA1_Final(output, &ctx);
+    return bstr(output, SHA_DIGEST_LENGTH);
+}
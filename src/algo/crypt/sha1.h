@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "io/base_byte_stream.h"
 #include "types.h"
 
 namespace au {
@@ -25,4 +26,7 @@ namespace crypt {
 
     bstr sha1(const bstr &input);
 
+    // hashes from the current position to the end, one chunk at a time
+    bstr sha1(io::BaseByteStream &input_stream);
+
 } } }
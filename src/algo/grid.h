@@ -34,11 +34,11 @@ namespace algo {
                 throw err::BadDataSizeError();
         }
 
-        Grid(const Grid &other) : Grid(other.width(), other.height())
+        Grid(const Grid &other)
+            : content(other.content),
+                _width(other._width),
+                _height(other._height)
         {
-            for (const auto y : algo::range(_height))
-            for (const auto x : algo::range(_width))
-                at(x, y) = other.at(x, y);
         }
 
         virtual ~Grid()
@@ -0,0 +1,61 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace au {
+namespace algo {
+
+    // A value, typically a lookup table, that is computed on first use.
+    // Safe to access from several threads at once: the factory runs exactly
+    // once and everyone else waits for it to finish.
+    template<typename T> class Lazy final
+    {
+    public:
+        Lazy(const std::function<T()> &factory) : factory(factory)
+        {
+        }
+
+        const T &get() const
+        {
+            std::call_once(
+                flag,
+                [&]() { value = std::make_unique<const T>(factory()); });
+            return *value;
+        }
+
+        const T &operator*() const
+        {
+            return get();
+        }
+
+        const T *operator->() const
+        {
+            return &get();
+        }
+
+    private:
+        const std::function<T()> factory;
+        mutable std::once_flag flag;
+        mutable std::unique_ptr<const T> value;
+    };
+
+} }
@@ -0,0 +1,203 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "algo/range.h"
+
+using namespace au;
+
+namespace
+{
+    class ThreadPool final
+    {
+    public:
+        ThreadPool(const size_t thread_count);
+        ~ThreadPool();
+
+        size_t get_thread_count() const;
+        void post(const std::function<void()> &job);
+
+    private:
+        void work();
+
+        std::mutex mutex;
+        std::condition_variable job_available;
+        std::deque<std::function<void()>> jobs;
+        std::vector<std::thread> threads;
+        bool stopping;
+    };
+
+    struct ParallelForState final
+    {
+        ParallelForState(
+            const size_t count, const std::function<void(size_t)> &func);
+
+        void run();
+
+        const size_t count;
+        const std::function<void(size_t)> &func;
+        std::atomic<size_t> next_index;
+
+        std::mutex mutex;
+        std::condition_variable helpers_finished;
+        size_t active_helpers;
+        bool finished;
+        std::exception_ptr exception;
+    };
+}
+
+ThreadPool::ThreadPool(const size_t thread_count) : stopping(false)
+{
+    for (const auto i : algo::range(thread_count))
+        threads.emplace_back([this]() { work(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+size_t ThreadPool::get_thread_count() const
+{
+    return threads.size();
+}
+
+void ThreadPool::post(const std::function<void()> &job)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    job_available.notify_one();
+}
+
+void ThreadPool::work()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(
+                lock, [&]() { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+static ThreadPool &get_thread_pool()
+{
+    static ThreadPool thread_pool(
+        std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1);
+    return thread_pool;
+}
+
+ParallelForState::ParallelForState(
+    const size_t count, const std::function<void(size_t)> &func) :
+        count(count),
+        func(func),
+        next_index(0),
+        active_helpers(0),
+        finished(false)
+{
+}
+
+void ParallelForState::run()
+{
+    while (true)
+    {
+        const size_t i = next_index++;
+        if (i >= count)
+            break;
+        try
+        {
+            func(i);
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!exception)
+                exception = std::current_exception();
+            next_index = count;
+            break;
+        }
+    }
+}
+
+void algo::parallel_for(
+    const size_t count, const std::function<void(size_t)> &func)
+{
+    auto &thread_pool = get_thread_pool();
+    const auto helper_count
+        = std::min(thread_pool.get_thread_count(), count ? count - 1 : 0);
+    if (!helper_count)
+    {
+        for (const auto i : algo::range(count))
+            func(i);
+        return;
+    }
+
+    // helpers that get picked up only after the work is done must not touch
+    // func, which lives on this thread's stack
+    const auto state = std::make_shared<ParallelForState>(count, func);
+    for (const auto i : algo::range(helper_count))
+    {
+        thread_pool.post([state]()
+        {
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (state->finished)
+                    return;
+                state->active_helpers++;
+            }
+            state->run();
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->active_helpers--;
+            }
+            state->helpers_finished.notify_all();
+        });
+    }
+
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished = true;
+    state->helpers_finished.wait(
+        lock, [&]() { return state->active_helpers == 0; });
+    if (state->exception)
+        std::rethrow_exception(state->exception);
+}
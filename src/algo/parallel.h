@@ -0,0 +1,34 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <functional>
+#include "types.h"
+
+namespace au {
+namespace algo {
+
+    // Calls func(i) for every i in [0, count) in the calling thread, helped by
+    // a process-wide pool of hardware_concurrency() - 1 threads that is shared
+    // by all concurrent callers, so nested use from many tasks doesn't
+    // multiply the thread count. The first exception thrown by any of the
+    // calls is rethrown in the calling thread once all the helpers are done.
+    void parallel_for(
+        const size_t count, const std::function<void(size_t)> &func);
+
+} }
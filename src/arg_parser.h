@@ -66,6 +66,8 @@ namespace au {
         bool has_switch(const std::string &name) const;
 
         const std::string get_switch(const std::string &name) const;
+        const std::vector<std::string> get_switch_values(
+            const std::string &name) const;
         const std::vector<std::string> get_stray() const;
 
     private:
@@ -18,7 +18,6 @@
 #include "dec/alice_soft/ajp_image_decoder.h"
 #include "algo/range.h"
 #include "dec/alice_soft/pms_image_decoder.h"
-#include "dec/jpeg/jpeg_image_decoder.h"
 
 using namespace au;
 using namespace au::dec::alice_soft;
@@ -33,6 +32,13 @@ static void decrypt(bstr &input)
         input[i] ^= key[i];
 }
 
+AjpImageDecoder::AjpImageDecoder()
+{
+    // --jpeg-fast and --jpeg-scale apply to the embedded JPEG image
+    for (const auto &decorator : jpeg_image_decoder.get_arg_parser_decorators())
+        add_arg_parser_decorator(decorator);
+}
+
 bool AjpImageDecoder::is_recognized_impl(io::File &input_file) const
 {
     return input_file.stream.read(magic.size()) == magic;
@@ -58,7 +64,6 @@ res::Image AjpImageDecoder::decode_impl(
     auto mask_data = input_file.stream.read(mask_size);
     decrypt(mask_data);
 
-    const auto jpeg_image_decoder = dec::jpeg::JpegImageDecoder();
     io::File jpeg_file;
     jpeg_file.stream.write(jpeg_data);
     auto image = jpeg_image_decoder.decode(logger, jpeg_file);
@@ -69,7 +74,24 @@ res::Image AjpImageDecoder::decode_impl(
         io::File mask_file;
         mask_file.stream.write(mask_data);
         const auto mask_image = pms_image_decoder.decode(logger, mask_file);
-        image.apply_mask(mask_image);
+        if (mask_image.width() == image.width()
+            && mask_image.height() == image.height())
+        {
+            image.apply_mask(mask_image);
+        }
+        else
+        {
+            // the JPEG part was downscaled with --jpeg-scale
+            res::Image scaled_mask_image(image.width(), image.height());
+            for (const auto y : algo::range(image.height()))
+            for (const auto x : algo::range(image.width()))
+            {
+                scaled_mask_image.at(x, y) = mask_image.at(
+                    x * mask_image.width() / image.width(),
+                    y * mask_image.height() / image.height());
+            }
+            image.apply_mask(scaled_mask_image);
+        }
     }
 
     return image;
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "dec/base_image_decoder.h"
+#include "dec/jpeg/jpeg_image_decoder.h"
 
 namespace au {
 namespace dec {
@@ -25,10 +26,16 @@ namespace alice_soft {
 
     class AjpImageDecoder final : public BaseImageDecoder
     {
+    public:
+        AjpImageDecoder();
+
     protected:
         bool is_recognized_impl(io::File &input_file) const override;
         res::Image decode_impl(
             const Logger &logger, io::File &input_file) const override;
+
+    private:
+        jpeg::JpegImageDecoder jpeg_image_decoder;
     };
 
 } } }
@@ -25,6 +25,28 @@
 using namespace au;
 using namespace au::dec;
 
+bool dec::get_entry_range(const ArchiveEntry &entry, ArchiveEntryRange &range)
+{
+    if (const auto plain_entry = dynamic_cast<const PlainArchiveEntry*>(&entry))
+    {
+        range.offset = plain_entry->offset;
+        range.size_stored = plain_entry->size;
+        range.size_orig = plain_entry->size;
+        range.compressed = false;
+        return true;
+    }
+    if (const auto compressed_entry
+        = dynamic_cast<const CompressedArchiveEntry*>(&entry))
+    {
+        range.offset = compressed_entry->offset;
+        range.size_stored = compressed_entry->size_comp;
+        range.size_orig = compressed_entry->size_orig;
+        range.compressed = true;
+        return true;
+    }
+    return false;
+}
+
 algo::NamingStrategy BaseArchiveDecoder::naming_strategy() const
 {
     return algo::NamingStrategy::Child;
@@ -42,6 +42,18 @@ namespace dec {
         size_t size_orig, size_comp;
     };
 
+    // Where an entry's data lies in its archive and how large it is.
+    struct ArchiveEntryRange final
+    {
+        uoff_t offset;
+        size_t size_stored;
+        size_t size_orig;
+        bool compressed;
+    };
+
+    // Returns false for entries that do not say where they are stored.
+    bool get_entry_range(const ArchiveEntry &entry, ArchiveEntryRange &range);
+
     struct ArchiveMeta
     {
         virtual ~ArchiveMeta() {}
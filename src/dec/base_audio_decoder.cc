@@ -16,12 +16,151 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/base_audio_decoder.h"
+#include "algo/audio/adpcm.h"
+#include "arg_parser.h"
 #include "dec/idecoder_visitor.h"
 #include "err.h"
 
 using namespace au;
 using namespace au::dec;
 
+namespace
+{
+    class AudioCollector final : public res::IAudioSink
+    {
+    public:
+        void begin(const res::Audio &audio) override;
+        void write(const bstr &samples) override;
+        void end() override;
+
+        res::Audio audio;
+    };
+
+    // Turns MS and IMA ADPCM into plain 16-bit PCM on its way to another
+    // sink, decoding whole blocks as soon as they arrive.
+    class AdpcmDecodingSink final : public res::IAudioSink
+    {
+    public:
+        AdpcmDecodingSink(res::IAudioSink &output_sink);
+        void begin(const res::Audio &audio) override;
+        void write(const bstr &samples) override;
+        void end() override;
+
+    private:
+        bstr decode(const bstr &samples) const;
+
+        res::IAudioSink &output_sink;
+        res::Audio input_audio;
+        bool active;
+        bstr pending;
+    };
+}
+
+static const int ms_adpcm_codec = 2;
+static const int ima_adpcm_codec = 0x11;
+
+void AudioCollector::begin(const res::Audio &audio)
+{
+    this->audio = audio;
+    this->audio.samples.resize(0);
+}
+
+void AudioCollector::write(const bstr &samples)
+{
+    audio.samples += samples;
+}
+
+void AudioCollector::end()
+{
+}
+
+AdpcmDecodingSink::AdpcmDecodingSink(res::IAudioSink &output_sink)
+    : output_sink(output_sink), active(false)
+{
+}
+
+void AdpcmDecodingSink::begin(const res::Audio &audio)
+{
+    active = audio.codec == ms_adpcm_codec || audio.codec == ima_adpcm_codec;
+    if (!active)
+    {
+        output_sink.begin(audio);
+        return;
+    }
+    if (!audio.block_align)
+        throw err::CorruptDataError("Unknown ADPCM block alignment");
+
+    input_audio = audio;
+    input_audio.samples.resize(0);
+    pending.resize(0);
+
+    auto output_audio = input_audio;
+    output_audio.codec = 1;
+    output_audio.extra_codec_headers = ""_b;
+    output_audio.bits_per_sample = 16;
+    output_audio.block_align = 0;
+    output_audio.byte_rate = 0;
+    output_sink.begin(output_audio);
+}
+
+void AdpcmDecodingSink::write(const bstr &samples)
+{
+    if (!active)
+    {
+        output_sink.write(samples);
+        return;
+    }
+    pending += samples;
+    const auto block_align = input_audio.block_align;
+    const auto ready_size = pending.size() / block_align * block_align;
+    if (!ready_size)
+        return;
+    output_sink.write(decode(pending.substr(0, ready_size)));
+    pending = pending.substr(ready_size);
+}
+
+void AdpcmDecodingSink::end()
+{
+    if (active && !pending.empty())
+        output_sink.write(decode(pending));
+    output_sink.end();
+}
+
+bstr AdpcmDecodingSink::decode(const bstr &samples) const
+{
+    if (input_audio.codec == ima_adpcm_codec)
+    {
+        return algo::audio::decode_ima_adpcm(
+            samples, input_audio.channel_count, input_audio.block_align);
+    }
+    return algo::audio::decode_ms_adpcm(
+        samples,
+        input_audio.channel_count,
+        input_audio.block_align,
+        input_audio.extra_codec_headers);
+}
+
+BaseAudioDecoder::BaseAudioDecoder() : adpcm_decoding(false)
+{
+    add_arg_parser_decorator(
+        [](ArgParser &arg_parser)
+        {
+            arg_parser.register_flag({"--decode-adpcm"})
+                ->set_description(
+                    "Decodes MS and IMA ADPCM audio to 16-bit PCM "
+                    "instead of extracting it as is.");
+        },
+        [&](const ArgParser &arg_parser)
+        {
+            set_adpcm_decoding(arg_parser.has_flag("decode-adpcm"));
+        });
+}
+
+void BaseAudioDecoder::set_adpcm_decoding(const bool adpcm_decoding)
+{
+    this->adpcm_decoding = adpcm_decoding;
+}
+
 algo::NamingStrategy BaseAudioDecoder::naming_strategy() const
 {
     return algo::NamingStrategy::FlatSibling;
@@ -37,5 +176,45 @@ res::Audio BaseAudioDecoder::decode(const Logger &logger, io::File &file) const
     if (!is_recognized(file))
         throw err::RecognitionError();
     file.stream.seek(0);
-    return decode_impl(logger, file);
+    if (!adpcm_decoding)
+        return decode_impl(logger, file);
+    const auto audio = decode_impl(logger, file);
+    AudioCollector collector;
+    AdpcmDecodingSink adpcm_sink(collector);
+    adpcm_sink.begin(audio);
+    adpcm_sink.write(audio.samples);
+    adpcm_sink.end();
+    return collector.audio;
+}
+
+void BaseAudioDecoder::decode(
+    const Logger &logger, io::File &file, res::IAudioSink &sink) const
+{
+    if (!is_recognized(file))
+        throw err::RecognitionError();
+    file.stream.seek(0);
+    if (!adpcm_decoding)
+    {
+        decode_stream_impl(logger, file, sink);
+        return;
+    }
+    AdpcmDecodingSink adpcm_sink(sink);
+    decode_stream_impl(logger, file, adpcm_sink);
+}
+
+void BaseAudioDecoder::decode_stream_impl(
+    const Logger &logger, io::File &input_file, res::IAudioSink &sink) const
+{
+    const auto audio = decode_impl(logger, input_file);
+    sink.begin(audio);
+    sink.write(audio.samples);
+    sink.end();
+}
+
+res::Audio BaseAudioDecoder::collect_stream(
+    const Logger &logger, io::File &input_file) const
+{
+    AudioCollector collector;
+    decode_stream_impl(logger, input_file, collector);
+    return collector.audio;
 }
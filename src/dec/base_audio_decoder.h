@@ -19,6 +19,7 @@
 
 #include "base_decoder.h"
 #include "res/audio.h"
+#include "res/iaudio_sink.h"
 
 namespace au {
 namespace dec {
@@ -26,17 +27,38 @@ namespace dec {
     class BaseAudioDecoder : public BaseDecoder
     {
     public:
+        BaseAudioDecoder();
         virtual ~BaseAudioDecoder() {}
 
+        void set_adpcm_decoding(const bool adpcm_decoding);
+
         algo::NamingStrategy naming_strategy() const override;
 
         void accept(IDecoderVisitor &visitor) const override;
 
         res::Audio decode(const Logger &logger, io::File &input_file) const;
 
+        void decode(
+            const Logger &logger,
+            io::File &input_file,
+            res::IAudioSink &sink) const;
+
     protected:
         virtual res::Audio decode_impl(
             const Logger &logger, io::File &input_file) const = 0;
+
+        // Decoders that can produce their samples piece by piece override
+        // this and implement decode_impl with collect_stream.
+        virtual void decode_stream_impl(
+            const Logger &logger,
+            io::File &input_file,
+            res::IAudioSink &sink) const;
+
+        res::Audio collect_stream(
+            const Logger &logger, io::File &input_file) const;
+
+    private:
+        bool adpcm_decoding;
     };
 
 } }
@@ -17,37 +17,15 @@
 
 #include "dec/cri/cpk_archive_decoder.h"
 #include <map>
-#include "algo/any.h"
 #include "algo/range.h"
-#include "algo/str.h"
+#include "dec/cri/layla.h"
+#include "dec/cri/utf_table.h"
 #include "err.h"
-#include "io/memory_byte_stream.h"
-#include "io/msb_bit_stream.h"
 
 using namespace au;
 using namespace au::dec::cri;
 
 static const bstr magic = "CPK\x20"_b;
-static const bstr layla_magic = "CRILAYLA"_b;
-
-static const u32 storage_mask    = 0xF0;
-static const u32 storage_none    = 0x00;
-static const u32 storage_zero    = 0x10;
-static const u32 storage_const   = 0x30;
-static const u32 storage_per_row = 0x50;
-
-static const u32 type_mask = 0x0F;
-static const u32 type_u8a  = 0x00;
-static const u32 type_u8b  = 0x01;
-static const u32 type_u16a = 0x02;
-static const u32 type_u16b = 0x03;
-static const u32 type_u32a = 0x04;
-static const u32 type_u32b = 0x05;
-static const u32 type_u64a = 0x06;
-static const u32 type_u64b = 0x07;
-static const u32 type_f32  = 0x08;
-static const u32 type_str  = 0x0A;
-static const u32 type_data = 0x0B;
 
 namespace
 {
@@ -65,15 +43,7 @@ namespace
         u64 mtime;
     };
 
-    using Cell = algo::any;
-    using Row = std::map<std::string, Cell>;
     using Toc = std::map<u32, TocEntry>;
-
-    struct Column final
-    {
-        u32 flags;
-        std::string name;
-    };
 }
 
 static bstr decrypt_utf_packet(const bstr &input)
@@ -99,155 +69,6 @@ static bstr read_utf_packet(io::BaseByteStream &input_stream)
         : decrypt_utf_packet(utf_packet);
 }
 
-static bstr decompress_layla(const bstr &input)
-{
-    io::MemoryByteStream input_stream(input);
-    input_stream.seek(layla_magic.size());
-    const auto size_orig = input_stream.read_le<u32>();
-    const auto size_comp = input_stream.read_le<u32>();
-    const auto data_comp = algo::reverse(input_stream.read(size_comp));
-    const auto prefix = input_stream.read_to_eof();
-
-    io::MsbBitStream bit_stream(data_comp);
-    bstr output;
-    output.reserve(size_orig);
-    while (output.size() < size_orig)
-    {
-        if (bit_stream.read(1))
-        {
-            auto repetitions = 3;
-            auto look_behind = bit_stream.read(13) + 3;
-
-            std::vector<size_t> sizes = {5, 3, 2};
-            while (true)
-            {
-                size_t size = 8;
-                if (!sizes.empty())
-                {
-                    size = sizes.back();
-                    sizes.pop_back();
-                }
-                const auto marker = bit_stream.read(size);
-                repetitions += marker;
-                if (marker != (1u << size) - 1)
-                    break;
-            }
-
-            while (repetitions--)
-                output += output.at(output.size() - look_behind);
-        }
-        else
-            output += static_cast<u8>(bit_stream.read(8));
-    }
-
-    return prefix + algo::reverse(output);
-}
-
-static std::vector<Row> parse_utf_packet(const bstr &utf_packet)
-{
-    io::MemoryByteStream utf_stream(utf_packet);
-    if (utf_stream.read(4) != "@UTF"_b)
-        throw err::CorruptDataError("Expected UTF packet");
-    const auto table_size = utf_stream.read_be<u32>();
-    const auto rows_offset_base = utf_stream.read_be<u32>() + 8;
-    const auto text_offset_base = utf_stream.read_be<u32>() + 8;
-    const auto data_offset_base = utf_stream.read_be<u32>() + 8;
-    const auto table_name_offset = utf_stream.read_be<u32>();
-    const auto column_count = utf_stream.read_be<u16>();
-    const auto row_size = utf_stream.read_be<u16>();
-    const auto row_count = utf_stream.read_be<u32>();
-
-    std::string table_name;
-    utf_stream.peek(
-        text_offset_base + table_name_offset,
-        [&]() { table_name = utf_stream.read_to_zero().str(); });
-
-    std::vector<Column> columns(column_count);
-    for (auto &column : columns)
-    {
-        column.flags = utf_stream.read<u8>();
-        if (column.flags == 0)
-            column.flags = utf_stream.read_be<u32>();
-
-        const auto column_name_offset = utf_stream.read_be<u32>();
-        utf_stream.peek(
-            text_offset_base + column_name_offset,
-            [&]() { column.name = utf_stream.read_to_zero().str(); });
-    }
-
-    std::vector<Row> rows(row_count);
-    for (const auto y : algo::range(row_count))
-    {
-        auto &row = rows[y];
-        utf_stream.seek(rows_offset_base + y * row_size);
-        for (const auto &column : columns)
-        {
-            auto &cell = row[column.name];
-
-            const auto storage_type = column.flags & storage_mask;
-            if (storage_type == storage_none
-                || storage_type == storage_zero
-                || storage_type == storage_const)
-            {
-                continue;
-            }
-
-            const auto type = column.flags & type_mask;
-            switch (type)
-            {
-                case type_u8a:
-                case type_u8b:
-                    cell = utf_stream.read<u8>();
-                    break;
-
-                case type_u16a:
-                case type_u16b:
-                    cell = utf_stream.read_be<u16>();
-                    break;
-
-                case type_u32a:
-                case type_u32b:
-                    cell = utf_stream.read_be<u32>();
-                    break;
-
-                case type_u64a:
-                case type_u64b:
-                    cell = utf_stream.read_be<u64>();
-                    break;
-
-                case type_f32:
-                    cell = utf_stream.read_be<f32>();
-                    break;
-
-                case type_str:
-                {
-                    const auto value_offset = utf_stream.read_be<u32>();
-                    utf_stream.peek(
-                        text_offset_base + value_offset,
-                        [&]()
-                        {
-                            cell = utf_stream.read_to_zero().str();
-                        });
-                    break;
-                }
-
-                case type_data:
-                {
-                    const auto data_offset = utf_stream.read_be<u32>();
-                    const auto data_size = utf_stream.read_be<u32>();
-                    utf_stream.peek(
-                        data_offset_base + data_offset,
-                        [&]() { cell = utf_stream.read(data_size); });
-                    break;
-                }
-            }
-        }
-        rows.push_back(row);
-    }
-
-    return rows;
-}
-
 static void read_toc(
     io::BaseByteStream &input_stream,
     const uoff_t toc_offset,
@@ -260,21 +81,28 @@ static void read_toc(
     if (input_stream.read(4) != "TOC\x20"_b)
         throw err::CorruptDataError("Expected TOC packet");
 
-    const auto table = parse_utf_packet(read_utf_packet(input_stream));
-    for (const auto &row : table)
+    const UtfTable table(read_utf_packet(input_stream));
+    const auto &id_column = table.get_column("ID");
+    const auto &dir_name_column = table.get_column("DirName");
+    const auto &file_name_column = table.get_column("FileName");
+    const auto &file_offset_column = table.get_column("FileOffset");
+    const auto &file_size_column = table.get_column("FileSize");
+    const auto &extract_size_column = table.get_column("ExtractSize");
+    const auto &user_string_column = table.get_column("UserString");
+    for (const auto i : algo::range(table.get_row_count()))
     {
-        TocEntry entry;
-        entry.id = row.at("ID").get<u32>();
-        if (row.at("DirName"))
-            entry.dir_name = row.at("DirName").get<std::string>();
-        entry.file_name = row.at("FileName").get<std::string>();
-        entry.file_offset = row.at("FileOffset").get<u64>() + data_offset_base;
-        entry.file_size = row.at("FileSize").get<u32>();
-        if (row.at("ExtractSize"))
-            entry.extract_size = row.at("ExtractSize").get<u32>();
-        if (row.at("UserString"))
-            entry.user_string = row.at("UserString").get<std::string>();
-        toc[entry.id] = entry;
+        auto &entry = toc[id_column.get_integer(i)];
+        entry.id = id_column.get_integer(i);
+        if (dir_name_column.has_values())
+            entry.dir_name = dir_name_column.get_string(i);
+        entry.file_name = file_name_column.get_string(i);
+        entry.file_offset
+            = file_offset_column.get_integer(i) + data_offset_base;
+        entry.file_size = file_size_column.get_integer(i);
+        if (extract_size_column.has_values())
+            entry.extract_size = extract_size_column.get_integer(i);
+        if (user_string_column.has_values())
+            entry.user_string = user_string_column.get_string(i);
     }
 }
 
@@ -285,14 +113,29 @@ static void read_etoc(
     if (input_stream.read(4) != "ETOC"_b)
         throw err::CorruptDataError("Expected ETOC packet");
 
-    const auto table = parse_utf_packet(read_utf_packet(input_stream));
+    const UtfTable table(read_utf_packet(input_stream));
+    const auto &local_dir_column = table.get_column("LocalDir");
+    const auto &mtime_column = table.get_column("UpdateDateTime");
     for (const auto i : algo::range(toc.size()))
     {
         auto &entry = toc[i];
-        const auto &row = table.at(i);
-        if (row.at("LocalDir"))
-            entry.local_dir = row.at("LocalDir").get<std::string>();
-        entry.mtime = row.at("UpdateDateTime").get<u64>();
+        if (local_dir_column.has_values())
+            entry.local_dir = local_dir_column.get_string(i);
+        entry.mtime = mtime_column.get_integer(i);
+    }
+}
+
+static void read_itoc_sizes(const UtfTable &table, Toc &toc)
+{
+    const auto &id_column = table.get_column("ID");
+    const auto &file_size_column = table.get_column("FileSize");
+    const auto &extract_size_column = table.get_column("ExtractSize");
+    for (const auto i : algo::range(table.get_row_count()))
+    {
+        auto &entry = toc[id_column.get_integer(i)];
+        entry.file_size = file_size_column.get_integer(i);
+        if (extract_size_column.has_values())
+            entry.extract_size = extract_size_column.get_integer(i);
     }
 }
 
@@ -307,48 +150,20 @@ static void read_itoc(
     if (input_stream.read(4) != "ITOC"_b)
         throw err::CorruptDataError("Expected ITOC packet");
 
-    const auto table = parse_utf_packet(read_utf_packet(input_stream));
-    if (table.empty())
+    const UtfTable table(read_utf_packet(input_stream));
+    if (!table.get_row_count() || !table.has_column("DataL"))
         return;
 
-    if (table[0].find("DataL") != table[0].end())
+    read_itoc_sizes(UtfTable(table.get_column("DataL").get_data(0)), toc);
+    read_itoc_sizes(UtfTable(table.get_column("DataH").get_data(0)), toc);
+    uoff_t offset = content_offset;
+    for (auto &kv : toc)
     {
-        const auto data_l = parse_utf_packet(table[0].at("DataL").get<bstr>());
-        const auto data_h = parse_utf_packet(table[0].at("DataH").get<bstr>());
-        for (const auto &row : data_l)
-        {
-            const auto entry_id = row.at("ID").get<u16>();
-            toc[entry_id].file_size = row.at("FileSize").get<u16>();
-            if (row.at("ExtractSize"))
-                toc[entry_id].extract_size = row.at("ExtractSize").get<u16>();
-        }
-        for (const auto &row : data_h)
-        {
-            const auto entry_id = row.at("ID").get<u16>();
-            toc[entry_id].file_size = row.at("FileSize").get<u32>();
-            if (row.at("ExtractSize"))
-                toc[entry_id].extract_size = row.at("ExtractSize").get<u32>();
-        }
-        uoff_t offset = content_offset;
-        std::vector<u32> ids;
-        for (const auto &kv : toc)
-            ids.push_back(kv.first);
-        std::sort(ids.begin(), ids.end());
-        for (const auto id : ids)
-        {
-            const auto size = toc[id].file_size;
-            toc[id].file_offset = offset;
-            offset += size;
-            if (size % align)
-                offset += align - (size % align);
-        }
-        return;
-    }
-
-    for (const auto &row : table)
-    {
-        const auto id = row.at("ID").get<u32>();
-        const auto idx = row.at("TocIndex").get<u32>();
+        const auto size = kv.second.file_size;
+        kv.second.file_offset = offset;
+        offset += size;
+        if (size % align)
+            offset += align - (size % align);
     }
 }
 
@@ -361,33 +176,39 @@ std::unique_ptr<dec::ArchiveMeta> CpkArchiveDecoder::read_meta_impl(
     const Logger &logger, io::File &input_file) const
 {
     input_file.stream.seek(magic.size());
-    const auto header_packet = read_utf_packet(input_file.stream);
-    const auto header = parse_utf_packet(header_packet).at(0);
-    const auto content_offset = header.at("ContentOffset").get<u64>();
-    const auto align = header.at("Align").get<u16>();
+    const UtfTable header(read_utf_packet(input_file.stream));
+    const auto content_offset
+        = header.get_column("ContentOffset").get_integer(0);
+    const auto align = header.get_column("Align").get_integer(0);
+    const auto &toc_offset_column = header.get_column("TocOffset");
+    const auto &itoc_offset_column = header.get_column("ItocOffset");
+    const auto &etoc_offset_column = header.get_column("EtocOffset");
     Toc toc;
 
-    if (header.at("TocOffset"))
+    if (toc_offset_column.has_values())
     {
         read_toc(
             input_file.stream,
-            header.at("TocOffset").get<u64>(),
+            toc_offset_column.get_integer(0),
             content_offset,
             toc);
     }
 
-    if (header.at("ItocOffset"))
+    if (itoc_offset_column.has_values())
     {
         read_itoc(
             input_file.stream,
-            header.at("ItocOffset").get<u64>(),
+            itoc_offset_column.get_integer(0),
             content_offset,
             align,
             toc);
     }
 
-    if (header.at("EtocOffset"))
-        read_etoc(input_file.stream, header.at("EtocOffset").get<u64>(), toc);
+    if (etoc_offset_column.has_values())
+    {
+        read_etoc(
+            input_file.stream, etoc_offset_column.get_integer(0), toc);
+    }
 
     auto meta = std::make_unique<ArchiveMeta>();
     for (const auto &kv : toc)
@@ -413,8 +234,8 @@ std::unique_ptr<io::File> CpkArchiveDecoder::read_file_impl(
     auto data = input_file.stream
         .seek(entry->offset)
         .read(entry->size);
-    if (data.substr(0, layla_magic.size()) == layla_magic)
-        data = decompress_layla(data);
+    if (is_layla_compressed(data))
+        data = layla_decompress(data);
     return std::make_unique<io::File>(entry->path, data);
 }
 
@@ -359,7 +359,7 @@ ChannelDecoder::ChannelDecoder(const int type, const int idx, const int count)
     }
     for (const auto i : algo::range(8))
     {
-        for (const auto j : algo::range(8))
+        for (const auto j : algo::range(128))
             wave[i][j] = 0;
         value2[i] = 0;
     }
@@ -494,6 +494,11 @@ void ChannelDecoder::decode1(
         base[i] = value_f32[value[i]] * scale_f32[scale[i]];
 }
 
+bool ChannelDecoder::reuses_intensity() const
+{
+    return type == 2 && value2[0] == 15;
+}
+
 void ChannelDecoder::decode2(io::BaseBitStream &bit_stream)
 {
     static const char list1[] =
@@ -714,15 +719,16 @@ void ChannelDecoder::decode5(const int index)
         }
     };
 
-    auto s3 = reinterpret_cast<const f32*>(list3_u32[0]);
+    // Indexed rather than pointer-chasing loops so that the compiler can
+    // vectorize the windowing and overlap-add.
+    const auto w = reinterpret_cast<const f32*>(list3_u32[0]);
     auto d = wave[index];
-    f32 *s1, *s2;
-    s1 = &wav2[64];
-    s2 = wav3;
-    for (const auto i : algo::range(64)) *d++ = *s1++ * *s3++ + *s2++;
-    for (const auto i : algo::range(64)) *d++ = *s3++ * *--s1 - *s2++;
-    s1 = &wav2[64-1];
-    s2 = wav3;
-    for (const auto i : algo::range(64)) *s2++ = *s1-- * *--s3;
-    for (const auto i : algo::range(64)) *s2++ = *--s3 * *++s1;
+    for (const auto i : algo::range(64))
+        d[i] = wav2[64 + i] * w[i] + wav3[i];
+    for (const auto i : algo::range(64))
+        d[64 + i] = w[64 + i] * wav2[127 - i] - wav3[64 + i];
+    for (const auto i : algo::range(64))
+        wav3[i] = wav2[63 - i] * w[127 - i];
+    for (const auto i : algo::range(64))
+        wav3[64 + i] = w[63 - i] * wav2[i];
 }
@@ -53,6 +53,10 @@ namespace hca {
 
         void decode5(const int index);
 
+        // Whether the last decode1 kept the intensity values of an earlier
+        // block instead of reading new ones.
+        bool reuses_intensity() const;
+
         f32 wave[8][128];
 
     private:
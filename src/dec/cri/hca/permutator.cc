@@ -130,7 +130,7 @@ Permutator::~Permutator()
 {
 }
 
-bstr Permutator::permute(const bstr &input)
+bstr Permutator::permute(const bstr &input) const
 {
     bstr output(input.size());
     for (const auto i : algo::range(input.size()))
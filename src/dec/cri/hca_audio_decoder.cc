@@ -16,7 +16,9 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/cri/hca_audio_decoder.h"
+#include <algorithm>
 #include "algo/locale.h"
+#include "algo/parallel.h"
 #include "algo/range.h"
 #include "dec/cri/hca/ath_table.h"
 #include "dec/cri/hca/channel_decoder.h"
@@ -31,13 +33,16 @@ using namespace au::dec::cri::hca;
 
 static const bstr magic = "HCA\x00"_b;
 
-static inline f32 clamp(const f32 input)
+// Number of blocks decoded by a single thread. Every run of blocks needs a
+// few extra blocks to be decoded upfront to restore the channel state.
+static const size_t blocks_per_chunk = 256;
+
+// Number of chunks whose samples are held in memory before being passed on.
+static const size_t chunks_per_batch = 16;
+
+static inline s16 to_s16(const f32 input)
 {
-    if (input > 1)
-        return 1;
-    if (input < -1)
-        return -1;
-    return input;
+    return static_cast<s16>(std::min(1.0f, std::max(-1.0f, input)) * 0x7FFF);
 }
 
 static inline unsigned int ceil2(unsigned int a, unsigned int b)
@@ -138,7 +143,20 @@ static std::vector<u8> get_types(
     return types;
 }
 
-static void decode_block(
+namespace
+{
+    enum class BlockType : u8
+    {
+        // Leaves the samples of the previous block in place.
+        Silent,
+        // Reuses the intensity values of an earlier block.
+        Dependent,
+        // Depends only on the IMDCT overlap of the previous block.
+        Independent,
+    };
+}
+
+static BlockType get_block_type(
     const Meta &meta,
     const AthTable &ath_table,
     std::vector<std::shared_ptr<ChannelDecoder>> &channel_decoders,
@@ -148,6 +166,50 @@ static void decode_block(
     if (crc16(block_data) != 0)
         throw err::CorruptDataError("Block checksum failed");
 
+    io::MsbBitStream bit_stream(block_data);
+    if (bit_stream.read(16) != 0xFFFF)
+        return BlockType::Silent;
+
+    auto type = BlockType::Independent;
+    int tmp = (bit_stream.read(9) << 8) - bit_stream.read(7);
+    for (const auto i : algo::range(meta.fmt->channel_count))
+    {
+        channel_decoders[i]->decode1(bit_stream, params[8], tmp, ath_table);
+        if (channel_decoders[i]->reuses_intensity())
+            type = BlockType::Dependent;
+    }
+    return type;
+}
+
+// Returns the first block that needs to be decoded so that the channel
+// decoders are in the same state at block_start as with serial decoding.
+static size_t get_priming_start(
+    const std::vector<BlockType> &block_types, const size_t block_start)
+{
+    if (!block_start)
+        return 0;
+
+    // A silent block repeats the samples of the last non-silent one, which
+    // must then be decoded with the correct overlap state.
+    auto sample_block = block_start;
+    while (sample_block && block_types[sample_block] == BlockType::Silent)
+        sample_block--;
+
+    // Decoding an independent block restores the intensity values and the
+    // IMDCT overlap, though not its own samples.
+    for (auto b = sample_block; b > 0; b--)
+        if (block_types[b - 1] == BlockType::Independent)
+            return b - 1;
+    return 0;
+}
+
+static void decode_block(
+    const Meta &meta,
+    const AthTable &ath_table,
+    std::vector<std::shared_ptr<ChannelDecoder>> &channel_decoders,
+    const std::array<u8, 9> params,
+    const bstr &block_data)
+{
     // suspicion: I believe the last 2 bytes are used as a CRC16 manipulator
     // (so that the checksum computes to 0.)
     io::MsbBitStream bit_stream(block_data.substr(0, block_data.size()));
@@ -199,13 +261,19 @@ bool HcaAudioDecoder::is_recognized_impl(io::File &input_file) const
 
 res::Audio HcaAudioDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
+{
+    return collect_stream(logger, input_file);
+}
+
+void HcaAudioDecoder::decode_stream_impl(
+    const Logger &logger, io::File &input_file, res::IAudioSink &sink) const
 {
     // TODO when testable: this should be customizable.
     const u32 ciph_key1 = 0x30DBE1AB;
     const u32 ciph_key2 = 0xCC554639;
 
     input_file.stream.seek(6);
-    static const u16 meta_size = input_file.stream.read_be<u16>();
+    const u16 meta_size = input_file.stream.read_be<u16>();
 
     input_file.stream.seek(0);
     auto meta = read_meta(input_file.stream.read(meta_size));
@@ -237,44 +305,49 @@ res::Audio HcaAudioDecoder::decode_impl(
     params[8] = ceil2(params[4] - (params[5] + params[6]), params[7]);
 
     const auto types = get_types(meta, params);
-    std::vector<std::shared_ptr<ChannelDecoder>> channel_decoders;
-    for (const auto i : algo::range(channel_count))
+    const auto create_channel_decoders = [&]()
     {
-        auto channel_decoder = std::make_shared<ChannelDecoder>(
-            types[i],
-            params[5] + params[6],
-            params[5] + ((types[i] != 2) ? params[6] : 0));
-        channel_decoders.push_back(channel_decoder);
-    }
+        std::vector<std::shared_ptr<ChannelDecoder>> channel_decoders;
+        for (const auto i : algo::range(channel_count))
+        {
+            channel_decoders.push_back(std::make_shared<ChannelDecoder>(
+                types[i],
+                params[5] + params[6],
+                params[5] + ((types[i] != 2) ? params[6] : 0)));
+        }
+        return channel_decoders;
+    };
 
     input_file.stream.seek(meta.hca->data_offset);
-    std::vector<s16> samples;
-    samples.reserve(128 * 8 * channel_count * block_count);
-    for (const auto b : algo::range(block_count))
+    std::vector<bstr> blocks;
+    std::vector<BlockType> block_types;
     {
-        decode_block(
-            meta,
-            ath_table,
-            channel_decoders,
-            params,
-            permutator.permute(input_file.stream.read(block_size)));
-
-        for (const auto i : algo::range(8))
-        for (const auto j : algo::range(128))
-        for (const auto k : algo::range(channel_count))
+        const auto data = input_file.stream.read(block_size * block_count);
+        auto channel_decoders = create_channel_decoders();
+        for (const auto b : algo::range(block_count))
         {
-            const auto value = clamp(channel_decoders[k]->wave[i][j]);
-            samples.push_back(static_cast<s16>(value * 0x7FFF));
+            blocks.push_back(
+                permutator.permute(data.substr(b * block_size, block_size)));
+            block_types.push_back(get_block_type(
+                meta, ath_table, channel_decoders, params, blocks.back()));
         }
     }
 
+    // Intensity values can be carried over an arbitrary number of blocks, so
+    // chunks that would need too long a run-up are merged with their
+    // predecessors.
+    std::vector<size_t> chunk_starts;
+    for (size_t b = 0; b < block_count; b += blocks_per_chunk)
+        if (!b || b - get_priming_start(block_types, b) <= blocks_per_chunk)
+            chunk_starts.push_back(b);
+    const auto chunk_count = chunk_starts.size();
+    chunk_starts.push_back(block_count);
+
     res::Audio audio;
     audio.codec = 1;
     audio.channel_count = channel_count;
     audio.sample_rate = sample_rate;
     audio.bits_per_sample = 16;
-    audio.samples
-        = bstr(reinterpret_cast<const u8*>(samples.data()), samples.size() * 2);
     if (meta.loop)
     {
         audio.loops.push_back(res::AudioLoopInfo
@@ -284,7 +357,51 @@ res::Audio HcaAudioDecoder::decode_impl(
             meta.loop->repetitions == 128 ? 0 : meta.loop->repetitions,
         });
     }
-    return audio;
+    sink.begin(audio);
+
+    const auto samples_per_block = 8 * 128 * channel_count;
+    for (size_t batch_start = 0;
+        batch_start < chunk_count;
+        batch_start += chunks_per_batch)
+    {
+        const auto batch_end
+            = std::min(batch_start + chunks_per_batch, chunk_count);
+        const auto batch_block_start = chunk_starts[batch_start];
+        const auto batch_block_end = chunk_starts[batch_end];
+        bstr samples(samples_per_block
+            * (batch_block_end - batch_block_start)
+            * sizeof(s16));
+
+        algo::parallel_for(batch_end - batch_start, [&](const size_t chunk)
+        {
+            const auto block_start = chunk_starts[batch_start + chunk];
+            const auto block_end = chunk_starts[batch_start + chunk + 1];
+            auto channel_decoders = create_channel_decoders();
+            const auto priming_start
+                = get_priming_start(block_types, block_start);
+            for (const auto b : algo::range(priming_start, block_start))
+            {
+                decode_block(
+                    meta, ath_table, channel_decoders, params, blocks[b]);
+            }
+
+            auto samples_ptr = samples.get<s16>()
+                + (block_start - batch_block_start) * samples_per_block;
+            for (const auto b : algo::range(block_start, block_end))
+            {
+                decode_block(
+                    meta, ath_table, channel_decoders, params, blocks[b]);
+
+                for (const auto i : algo::range(8))
+                for (const auto j : algo::range(128))
+                for (const auto k : algo::range(channel_count))
+                    *samples_ptr++ = to_s16(channel_decoders[k]->wave[i][j]);
+            }
+        });
+
+        sink.write(samples);
+    }
+    sink.end();
 }
 
 static auto _ = dec::register_decoder<HcaAudioDecoder>("cri/hca");
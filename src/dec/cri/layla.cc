@@ -0,0 +1,156 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/cri/layla.h"
+#include <cstring>
+#include "algo/endian.h"
+#include "algo/range.h"
+#include "err.h"
+#include "io/memory_byte_stream.h"
+
+using namespace au;
+using namespace au::dec;
+
+static const bstr magic = "CRILAYLA"_b;
+static const size_t match_size_bits[] = {2, 3, 5};
+
+namespace
+{
+    // reads the compressed stream from its last byte towards its first one,
+    // most significant bits first
+    class LaylaBitReader final
+    {
+    public:
+        LaylaBitReader(const bstr &input);
+        u32 read(const size_t bits);
+
+    private:
+        void refill();
+
+        const u8 *input_start;
+        const u8 *input_ptr;
+        u64 buffer;
+        size_t bits_available;
+    };
+}
+
+LaylaBitReader::LaylaBitReader(const bstr &input) :
+    input_start(input.get<u8>()),
+    input_ptr(input.get<u8>() + input.size()),
+    buffer(0),
+    bits_available(0)
+{
+}
+
+void LaylaBitReader::refill()
+{
+    if (input_ptr - input_start >= 8)
+    {
+        u64 word;
+        std::memcpy(&word, input_ptr - 8, 8);
+        word = algo::from_little_endian(word);
+        const auto bits = (64 - bits_available) & ~7;
+        buffer |= (word >> (64 - bits)) << (64 - bits_available - bits);
+        input_ptr -= bits >> 3;
+        bits_available += bits;
+        return;
+    }
+    while (bits_available <= 56 && input_ptr > input_start)
+    {
+        buffer |= static_cast<u64>(*--input_ptr) << (56 - bits_available);
+        bits_available += 8;
+    }
+}
+
+inline u32 LaylaBitReader::read(const size_t bits)
+{
+    if (bits_available < bits)
+    {
+        refill();
+        if (bits_available < bits)
+            throw err::EofError();
+    }
+    const auto ret = static_cast<u32>(buffer >> (64 - bits));
+    buffer <<= bits;
+    bits_available -= bits;
+    return ret;
+}
+
+bool cri::is_layla_compressed(const bstr &input)
+{
+    return input.substr(0, magic.size()) == magic;
+}
+
+bstr cri::layla_decompress(const bstr &input)
+{
+    io::MemoryByteStream input_stream(input);
+    input_stream.seek(magic.size());
+    const auto size_orig = input_stream.read_le<u32>();
+    const auto size_comp = input_stream.read_le<u32>();
+    const auto data_comp = input_stream.read(size_comp);
+    const auto prefix = input_stream.read_to_eof();
+
+    // the output is produced back to front, right after the prefix
+    bstr output(prefix.size() + size_orig);
+    std::memcpy(output.get<u8>(), prefix.get<u8>(), prefix.size());
+    u8 *const output_start = output.get<u8>() + prefix.size();
+    u8 *const output_end = output_start + size_orig;
+    u8 *output_ptr = output_end;
+
+    LaylaBitReader bit_reader(data_comp);
+    while (output_ptr > output_start)
+    {
+        if (!bit_reader.read(1))
+        {
+            *--output_ptr = bit_reader.read(8);
+            continue;
+        }
+
+        const size_t look_behind = bit_reader.read(13) + 3;
+        size_t repetitions = 3;
+        size_t size_id = 0;
+        while (true)
+        {
+            const auto size = size_id < 3 ? match_size_bits[size_id++] : 8;
+            const auto marker = bit_reader.read(size);
+            repetitions += marker;
+            if (marker != (1u << size) - 1)
+                break;
+        }
+
+        if (look_behind > static_cast<size_t>(output_end - output_ptr))
+            throw err::CorruptDataError("Match exceeds decoded data");
+        if (repetitions > static_cast<size_t>(output_ptr - output_start))
+            throw err::CorruptDataError("Match exceeds output size");
+
+        output_ptr -= repetitions;
+        if (look_behind >= repetitions)
+        {
+            std::memcpy(output_ptr, output_ptr + look_behind, repetitions);
+        }
+        else
+        {
+            for (auto i : algo::range(repetitions))
+            {
+                const auto j = repetitions - 1 - i;
+                output_ptr[j] = output_ptr[j + look_behind];
+            }
+        }
+    }
+
+    return output;
+}
@@ -0,0 +1,267 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "dec/cri/utf_table.h"
+#include <cstring>
+#include <map>
+#include <vector>
+#include "algo/endian.h"
+#include "algo/range.h"
+#include "err.h"
+#include "io/memory_byte_stream.h"
+
+using namespace au;
+using namespace au::dec::cri;
+
+static const u32 storage_mask    = 0xF0;
+static const u32 storage_none    = 0x00;
+static const u32 storage_zero    = 0x10;
+static const u32 storage_const   = 0x30;
+static const u32 storage_per_row = 0x50;
+
+static const u32 type_mask = 0x0F;
+static const u32 type_u8a  = 0x00;
+static const u32 type_u8b  = 0x01;
+static const u32 type_u16a = 0x02;
+static const u32 type_u16b = 0x03;
+static const u32 type_u32a = 0x04;
+static const u32 type_u32b = 0x05;
+static const u32 type_u64a = 0x06;
+static const u32 type_u64b = 0x07;
+static const u32 type_f32  = 0x08;
+static const u32 type_str  = 0x0A;
+static const u32 type_data = 0x0B;
+
+struct UtfTable::Priv final
+{
+    const u8 *get_bytes(const size_t offset, const size_t size) const;
+    std::string get_string(const size_t offset) const;
+
+    bstr packet;
+    std::string name;
+    size_t row_count;
+    size_t row_size;
+    size_t rows_offset_base;
+    size_t text_offset_base;
+    size_t data_offset_base;
+    std::vector<UtfColumn> columns;
+    std::map<std::string, size_t> column_ids;
+};
+
+template<typename T> static T read_be(const u8 *ptr)
+{
+    T ret;
+    std::memcpy(&ret, ptr, sizeof(T));
+    return algo::from_big_endian<T>(ret);
+}
+
+static size_t get_type_size(const u32 type)
+{
+    switch (type)
+    {
+        case type_u8a:
+        case type_u8b:
+            return 1;
+
+        case type_u16a:
+        case type_u16b:
+            return 2;
+
+        case type_u32a:
+        case type_u32b:
+        case type_f32:
+        case type_str:
+            return 4;
+
+        case type_u64a:
+        case type_u64b:
+        case type_data:
+            return 8;
+    }
+    throw err::CorruptDataError("Unknown UTF column type");
+}
+
+const u8 *UtfTable::Priv::get_bytes(
+    const size_t offset, const size_t size) const
+{
+    if (offset > packet.size() || size > packet.size() - offset)
+        throw err::BadDataOffsetError();
+    return packet.get<u8>() + offset;
+}
+
+std::string UtfTable::Priv::get_string(const size_t offset) const
+{
+    const auto str = reinterpret_cast<const char*>(
+        get_bytes(text_offset_base + offset, 0));
+    const auto max_size = packet.size() - text_offset_base - offset;
+    return std::string(str, strnlen(str, max_size));
+}
+
+UtfTable::UtfTable(const bstr &utf_packet) : p(new Priv())
+{
+    p->packet = utf_packet;
+    io::MemoryByteStream utf_stream(p->packet);
+    if (utf_stream.read(4) != "@UTF"_b)
+        throw err::CorruptDataError("Expected UTF packet");
+    utf_stream.skip(4);
+    p->rows_offset_base = utf_stream.read_be<u32>() + 8;
+    p->text_offset_base = utf_stream.read_be<u32>() + 8;
+    p->data_offset_base = utf_stream.read_be<u32>() + 8;
+    const auto table_name_offset = utf_stream.read_be<u32>();
+    const auto column_count = utf_stream.read_be<u16>();
+    p->row_size = utf_stream.read_be<u16>();
+    p->row_count = utf_stream.read_be<u32>();
+    p->name = p->get_string(table_name_offset);
+
+    size_t row_offset = 0;
+    p->columns.reserve(column_count);
+    for (const auto i : algo::range(column_count))
+    {
+        u32 flags = utf_stream.read<u8>();
+        if (flags == 0)
+            flags = utf_stream.read_be<u32>();
+        const auto name = p->get_string(utf_stream.read_be<u32>());
+
+        const auto storage_type = flags & storage_mask;
+        size_t offset = 0;
+        if (storage_type == storage_const)
+        {
+            offset = utf_stream.pos();
+            utf_stream.skip(get_type_size(flags & type_mask));
+        }
+        else if (storage_type == storage_per_row)
+        {
+            offset = row_offset;
+            row_offset += get_type_size(flags & type_mask);
+        }
+
+        p->column_ids[name] = p->columns.size();
+        p->columns.emplace_back(*p, name, flags, offset);
+    }
+}
+
+UtfTable::~UtfTable()
+{
+}
+
+const std::string &UtfTable::get_name() const
+{
+    return p->name;
+}
+
+size_t UtfTable::get_row_count() const
+{
+    return p->row_count;
+}
+
+bool UtfTable::has_column(const std::string &name) const
+{
+    return p->column_ids.find(name) != p->column_ids.end();
+}
+
+const UtfColumn &UtfTable::get_column(const std::string &name) const
+{
+    const auto it = p->column_ids.find(name);
+    if (it == p->column_ids.end())
+        throw err::CorruptDataError("Missing UTF column: " + name);
+    return p->columns[it->second];
+}
+
+UtfColumn::UtfColumn(
+    const UtfTable::Priv &table,
+    const std::string &name,
+    const u32 flags,
+    const size_t offset) :
+        table(table), name(name), flags(flags), offset(offset)
+{
+}
+
+const std::string &UtfColumn::get_name() const
+{
+    return name;
+}
+
+bool UtfColumn::has_values() const
+{
+    const auto storage_type = flags & storage_mask;
+    return storage_type == storage_const || storage_type == storage_per_row;
+}
+
+const u8 *UtfColumn::get_cell(const size_t row, const u32 type) const
+{
+    if (!has_values())
+        throw err::CorruptDataError("UTF column " + name + " has no values");
+    if (row >= table.row_count)
+        throw err::BadDataOffsetError();
+    const auto size = get_type_size(type);
+    if ((flags & storage_mask) == storage_const)
+        return table.get_bytes(offset, size);
+    return table.get_bytes(
+        table.rows_offset_base + row * table.row_size + offset, size);
+}
+
+u64 UtfColumn::get_integer(const size_t row) const
+{
+    const auto type = flags & type_mask;
+    const auto cell = get_cell(row, type);
+    switch (type)
+    {
+        case type_u8a:
+        case type_u8b:
+            return *cell;
+
+        case type_u16a:
+        case type_u16b:
+            return read_be<u16>(cell);
+
+        case type_u32a:
+        case type_u32b:
+            return read_be<u32>(cell);
+
+        case type_u64a:
+        case type_u64b:
+            return read_be<u64>(cell);
+    }
+    throw err::CorruptDataError("UTF column " + name + " is not an integer");
+}
+
+f32 UtfColumn::get_float(const size_t row) const
+{
+    if ((flags & type_mask) != type_f32)
+        throw err::CorruptDataError("UTF column " + name + " is not a float");
+    return read_be<f32>(get_cell(row, type_f32));
+}
+
+std::string UtfColumn::get_string(const size_t row) const
+{
+    if ((flags & type_mask) != type_str)
+        throw err::CorruptDataError("UTF column " + name + " is not a string");
+    return table.get_string(read_be<u32>(get_cell(row, type_str)));
+}
+
+bstr UtfColumn::get_data(const size_t row) const
+{
+    if ((flags & type_mask) != type_data)
+        throw err::CorruptDataError("UTF column " + name + " is not data");
+    const auto cell = get_cell(row, type_data);
+    const auto data_offset = read_be<u32>(cell);
+    const auto data_size = read_be<u32>(cell + 4);
+    return bstr(
+        table.get_bytes(table.data_offset_base + data_offset, data_size),
+        data_size);
+}
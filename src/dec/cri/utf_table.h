@@ -0,0 +1,76 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "types.h"
+
+namespace au {
+namespace dec {
+namespace cri {
+
+    class UtfColumn;
+
+    // Columnar view of a decrypted @UTF packet. Only the schema is parsed
+    // upfront; cells are decoded straight from the packet when requested.
+    class UtfTable final
+    {
+    public:
+        UtfTable(const bstr &utf_packet);
+        ~UtfTable();
+
+        const std::string &get_name() const;
+        size_t get_row_count() const;
+        bool has_column(const std::string &name) const;
+        const UtfColumn &get_column(const std::string &name) const;
+
+    private:
+        friend class UtfColumn;
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+    class UtfColumn final
+    {
+    public:
+        UtfColumn(
+            const UtfTable::Priv &table,
+            const std::string &name,
+            const u32 flags,
+            const size_t offset);
+
+        const std::string &get_name() const;
+        bool has_values() const;
+
+        u64 get_integer(const size_t row) const;
+        f32 get_float(const size_t row) const;
+        std::string get_string(const size_t row) const;
+        bstr get_data(const size_t row) const;
+
+    private:
+        const u8 *get_cell(const size_t row, const u32 type) const;
+
+        const UtfTable::Priv &table;
+        std::string name;
+        u32 flags;
+        size_t offset;
+    };
+
+} } }
@@ -16,7 +16,10 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/entis/audio/lossy.h"
+#include <algorithm>
 #include <cmath>
+#include "algo/lazy.h"
+#include "algo/parallel.h"
 #include "algo/range.h"
 #include "dec/entis/common/gamma_decoder.h"
 #include "dec/entis/common/huffman_decoder.h"
@@ -33,34 +36,6 @@ static const f64 pi = 3.141592653589;
 static const f32 rcos_pi_4 = static_cast<f32>(std::cos(pi / 4.0));
 static const f32 r2cos_pi_4 = 2.0f * rcos_pi_4;
 
-static f32 dct_of_k2[2];       // = std::cos((2*i+1) / 8)
-static f32 dct_of_k4[4];       // = std::cos((2*i+1) / 16)
-static f32 dct_of_k8[8];       // = std::cos((2*i+1) / 32)
-static f32 dct_of_k16[16];     // = std::cos((2*i+1) / 64)
-static f32 dct_of_k32[32];     // = std::cos((2*i+1) / 128)
-static f32 dct_of_k64[64];     // = std::cos((2*i+1) / 256)
-static f32 dct_of_k128[128];   // = std::cos((2*i+1) / 512)
-static f32 dct_of_k256[256];   // = std::cos((2*i+1) / 1024)
-static f32 dct_of_k512[512];   // = std::cos((2*i+1) / 2048)
-static f32 dct_of_k1024[1024]; // = std::cos((2*i+1) / 4096)
-static f32 dct_of_k2048[2048]; // = std::cos((2*i+1) / 8192)
-
-static f32 *dct_of_k_matrix[max_dct_degree] =
-{
-    nullptr,
-    dct_of_k2,
-    dct_of_k4,
-    dct_of_k8,
-    dct_of_k16,
-    dct_of_k32,
-    dct_of_k64,
-    dct_of_k128,
-    dct_of_k256,
-    dct_of_k512,
-    dct_of_k1024,
-    dct_of_k2048
-};
-
 namespace
 {
     struct EriSinCos final
@@ -68,6 +43,48 @@ namespace
         f32 rsin;
         f32 rcos;
     };
+
+    struct Transform final
+    {
+        Transform(const size_t subband_degree, const size_t channel_count);
+
+        void initialize_with_degree(const size_t subband_degree);
+
+        void dequantumize(
+            f32 *destination,
+            const s32 *quantumized,
+            const s32 weight_code,
+            const int coefficient);
+
+        std::unique_ptr<s32[]> buffer1;
+        std::unique_ptr<f32[]> matrix_buf;
+        std::unique_ptr<f32[]> internal_buf;
+        std::unique_ptr<f32[]> work_buf;
+        std::unique_ptr<f32[]> weight_table;
+
+        size_t subband_degree;
+        size_t degree_num;
+        std::vector<EriSinCos> revolve_param;
+        size_t frequency_point[7];
+    };
+
+    enum class BlockType : u8
+    {
+        Lead,
+        Internal,
+        Post,
+    };
+
+    struct Block final
+    {
+        BlockType type;
+        size_t subband_degree;
+        s32 weight_code;
+        u32 coefficient;
+        const s32 *source;
+        s16 *output;
+        size_t samples;
+    };
 }
 
 struct LossyAudioDecoder::Priv final
@@ -75,41 +92,24 @@ struct LossyAudioDecoder::Priv final
     Priv(const MioHeader &header);
     ~Priv();
 
-    void initialize_with_degree(const size_t subband_degree);
-
     bstr decode_dct(const MioChunk &chunk);
     bstr decode_dct_mss(const MioChunk &chunk);
 
-    void decode_lead_block();
-    void decode_internal_block(s16 *output_ptr, const size_t samples);
-    void decode_post_block(s16 *output_ptr, const size_t samples);
-
     void decode_lead_block_mss();
     void decode_internal_block_mss(s16 *output_ptr, const size_t samples);
     void decode_post_block_mss(s16 *output_ptr, const size_t samples);
 
-    void dequantumize(
-        f32 *destination,
-        const s32 *quantumized,
-        const s32 weight_code,
-        const int coefficient);
-
     const MioHeader &header;
     std::unique_ptr<common::BaseDecoder> decoder;
+    std::vector<std::unique_ptr<Transform>> transforms;
 
     size_t buf_size;
-    std::unique_ptr<s32[]> buffer1;
     std::unique_ptr<s32[]> buffer2;
     std::unique_ptr<s8[]> buffer3;
     std::unique_ptr<u8[]> division_table;
     std::unique_ptr<u8[]> revolve_code_table;
     std::unique_ptr<s32[]> weight_code_table;
     std::unique_ptr<u32[]> coefficient_table;
-    std::unique_ptr<f32[]> matrix_buf;
-    std::unique_ptr<f32[]> internal_buf;
-    std::unique_ptr<f32[]> work_buf;
-    std::unique_ptr<f32[]> work_buf2;
-    std::unique_ptr<f32[]> weight_table;
     std::unique_ptr<f32[]> last_dct;
 
     u8 *division_ptr;
@@ -117,19 +117,17 @@ struct LossyAudioDecoder::Priv final
     s32 *weight_ptr;
     u32 *coefficient_ptr;
     s32 *source_ptr;
-    f32 *last_dct_buf;
-    size_t subband_degree;
-    size_t degree_num;
-    std::vector<EriSinCos> revolve_param;
-    size_t frequency_point[7];
 };
 
-static void init_dct_of_k_matrix()
+static std::vector<std::vector<f32>> create_dct_of_k_matrix()
 {
+    // dct_of_k_matrix[i][j] = std::cos((2 * j + 1) * pi / (4 << i))
+    std::vector<std::vector<f32>> dct_of_k_matrix(max_dct_degree);
     for (const auto i : algo::range(1, max_dct_degree))
     {
         int n = 1 << i;
-        f32 *dct_of_k = dct_of_k_matrix[i];
+        auto &dct_of_k = dct_of_k_matrix[i];
+        dct_of_k.resize(n);
         f64 nr = pi / (4.0 * n);
         f64 dr = nr + nr;
         f64 ir = nr;
@@ -139,28 +137,22 @@ static void init_dct_of_k_matrix()
             ir += dr;
         }
     }
+    return dct_of_k_matrix;
 }
 
-static int round32(const f32 r)
-{
-    return (r >= 0.0)
-        ? static_cast<int>(floor(r + 0.5))
-        : static_cast<int>(ceil(r - 0.5));
-}
+static const algo::Lazy<std::vector<std::vector<f32>>> dct_of_k_tables(
+    create_dct_of_k_matrix);
 
 static void round32_array(
     s16 *output, const int step, const f32 *source, const size_t size)
 {
+    // Rounds half away from zero and saturates; kept branch-free so that the
+    // loop can be vectorized.
     for (const auto i : algo::range(size))
     {
-        int value = round32(*source++);
-        if (value <= -0x8000)
-            *output = -0x8000;
-        else if (value >= 0x7FFF)
-            *output = 0x7FFF;
-        else
-            *output = value;
-        output += step;
+        const f64 value = source[i] + (source[i] >= 0 ? 0.5 : -0.5);
+        output[i * step] = static_cast<s16>(
+            std::min(32767.0, std::max(-32768.0, value)));
     }
 }
 
@@ -305,6 +297,7 @@ static void dct(
     f32 *work_buf,
     const size_t dct_degree)
 {
+    const auto &dct_of_k_matrix = *dct_of_k_tables;
     if (dct_degree < min_dct_degree || dct_degree > max_dct_degree)
         throw std::logic_error("DCT degree out of bounds");
 
@@ -317,8 +310,8 @@ static void dct(
         r32_buf[3] = input[1] - input[2];
         output[output_interval * 0] = (r32_buf[0] + r32_buf[1]) * 0.5f;
         output[output_interval * 2] = (r32_buf[0] - r32_buf[1]) *  rcos_pi_4;
-        r32_buf[2] = dct_of_k2[0] * r32_buf[2];
-        r32_buf[3] = dct_of_k2[1] * r32_buf[3];
+        r32_buf[2] = dct_of_k_matrix[1][0] * r32_buf[2];
+        r32_buf[3] = dct_of_k_matrix[1][1] * r32_buf[3];
         r32_buf[0] = (r32_buf[2] + r32_buf[3]);
         r32_buf[1] = (r32_buf[2] - r32_buf[3]) * r2cos_pi_4;
         r32_buf[1] -= r32_buf[0];
@@ -336,7 +329,7 @@ static void dct(
     }
     const auto output_step = output_interval << 1;
     dct(output, output_step, work_buf, input, dct_degree - 1);
-    const auto dct_of_k = dct_of_k_matrix[dct_degree - 1];
+    const auto dct_of_k = dct_of_k_matrix[dct_degree - 1].data();
     input = work_buf + half_degree;
     output += output_interval;
     for (const auto i : algo::range(half_degree))
@@ -355,6 +348,7 @@ static void idct(
     f32 *work_buf,
     const size_t dct_degree)
 {
+    const auto &dct_of_k_matrix = *dct_of_k_tables;
     if (dct_degree < min_dct_degree || dct_degree > max_dct_degree)
         throw std::logic_error("DCT degree out of bounds");
 
@@ -366,8 +360,8 @@ static void idct(
         r32_buf1[1] = rcos_pi_4 * input[input_interval * 2];
         r32_buf2[0] = r32_buf1[0] + r32_buf1[1];
         r32_buf2[1] = r32_buf1[0] - r32_buf1[1];
-        r32_buf1[0] = dct_of_k2[0] * input[input_interval];
-        r32_buf1[1] = dct_of_k2[1] * input[input_interval * 3];
+        r32_buf1[0] = dct_of_k_matrix[1][0] * input[input_interval];
+        r32_buf1[1] = dct_of_k_matrix[1][1] * input[input_interval * 3];
         r32_buf2[2] = r32_buf1[0] + r32_buf1[1];
         r32_buf2[3] = r2cos_pi_4 * (r32_buf1[0] - r32_buf1[1]);
         r32_buf2[3] -= r32_buf2[2];
@@ -382,7 +376,7 @@ static void idct(
     const size_t half_degree = degree_num >> 1;
     const size_t input_step = input_interval << 1;
     idct(output, input, input_step, work_buf, dct_degree - 1);
-    const f32 *dct_of_k = dct_of_k_matrix[dct_degree - 1];
+    const auto dct_of_k = dct_of_k_matrix[dct_degree - 1].data();
     const f32 *odd_input = input + input_interval;
     f32 *odd_output = output + half_degree;
     for (const auto i : algo::range(half_degree))
@@ -406,48 +400,23 @@ static void idct(
     }
 }
 
-LossyAudioDecoder::Priv::Priv(const MioHeader &header) : header(header)
+Transform::Transform(const size_t subband_degree, const size_t channel_count)
+    : subband_degree(0), degree_num(0)
 {
-    if ((header.channel_count != 1) && (header.channel_count != 2))
-        throw err::UnsupportedChannelCountError(header.channel_count);
-    if (header.bits_per_sample != 16)
-        throw err::UnsupportedBitDepthError(header.bits_per_sample);
-
-    if ((header.subband_degree < 8) || (header.subband_degree > max_dct_degree))
-        throw err::CorruptDataError("Unexpected subband degree");
-
-    if (header.lapped_degree != 1)
-        throw err::CorruptDataError("Unexpected lapped degree");
-
-    buf_size = 0;
-
-    const auto subband_size = 1 << header.subband_degree;
-    const auto subband_size_total = header.channel_count * subband_size;
+    const auto subband_size = 1 << subband_degree;
+    const auto subband_size_total = channel_count * subband_size;
     buffer1 = std::make_unique<s32[]>(subband_size_total);
     matrix_buf = std::make_unique<f32[]>(subband_size_total);
     internal_buf = std::make_unique<f32[]>(subband_size_total);
     work_buf = std::make_unique<f32[]>(subband_size);
-    work_buf2 = std::make_unique<f32[]>(subband_size);
     weight_table = std::make_unique<f32[]>(subband_size);
-
-    const auto blockset_samples = header.channel_count << header.subband_degree;
-    const auto lapped_samples = blockset_samples * header.lapped_degree;
-    if (lapped_samples > 0)
-    {
-        last_dct = std::make_unique<f32[]>(lapped_samples);
-        for (const auto i : algo::range(lapped_samples))
-            last_dct[i] = 0.0f;
-    }
-    initialize_with_degree(header.subband_degree);
-}
-
-LossyAudioDecoder::Priv::~Priv()
-{
+    initialize_with_degree(subband_degree);
 }
 
-void LossyAudioDecoder::Priv::initialize_with_degree(
-    const size_t subband_degree)
+void Transform::initialize_with_degree(const size_t subband_degree)
 {
+    if (this->subband_degree == subband_degree && !revolve_param.empty())
+        return;
     revolve_param = create_revolve_param(subband_degree);
     static const int freq_width[7] = {-6, -6, -5, -4, -3, -2, -1};
     auto j = 0;
@@ -461,7 +430,7 @@ void LossyAudioDecoder::Priv::initialize_with_degree(
     degree_num = 1 << subband_degree;
 }
 
-void LossyAudioDecoder::Priv::dequantumize(
+void Transform::dequantumize(
     f32 *destination,
     const s32 *quantumized,
     const s32 weight_code,
@@ -509,75 +478,134 @@ void LossyAudioDecoder::Priv::dequantumize(
     }
 }
 
-void LossyAudioDecoder::Priv::decode_lead_block()
+static void decode_lead_block(
+    Transform &transform, f32 *last_dct_buf, const Block &block)
 {
-    const auto weight_code = *weight_ptr++;
-    const auto coefficient = *coefficient_ptr++;
+    transform.initialize_with_degree(block.subband_degree);
+    const auto degree_num = transform.degree_num;
     const auto half_degree = degree_num / 2;
+    const auto buffer1 = transform.buffer1.get();
     for (const auto i : algo::range(half_degree))
     {
         buffer1[i * 2] = 0;
-        buffer1[i * 2 + 1] = *source_ptr++;
+        buffer1[i * 2 + 1] = block.source[i];
     }
-    dequantumize(last_dct_buf, buffer1.get(), weight_code, coefficient);
-    odd_givens_inverse_matrix(last_dct_buf, revolve_param, subband_degree);
+    transform.dequantumize(
+        last_dct_buf, buffer1, block.weight_code, block.coefficient);
+    odd_givens_inverse_matrix(
+        last_dct_buf, transform.revolve_param, block.subband_degree);
     for (const auto i : algo::range(0, degree_num, 2))
         last_dct_buf[i] = last_dct_buf[i + 1];
-    iplot(last_dct_buf, subband_degree);
+    iplot(last_dct_buf, block.subband_degree);
 }
 
-void LossyAudioDecoder::Priv::decode_internal_block(
-    s16 *output_ptr, const size_t samples)
+static void decode_internal_block(
+    Transform &transform,
+    f32 *last_dct_buf,
+    const Block &block,
+    const size_t channel_count)
 {
-    const auto weight_code = *weight_ptr++;
-    const auto coefficient = *coefficient_ptr++;
-    dequantumize(matrix_buf.get(), source_ptr, weight_code, coefficient);
-    source_ptr += degree_num;
-    odd_givens_inverse_matrix(matrix_buf.get(), revolve_param, subband_degree);
-    iplot(matrix_buf.get(), subband_degree);
-    ilot(work_buf.get(), last_dct_buf, matrix_buf.get(), subband_degree);
+    transform.initialize_with_degree(block.subband_degree);
+    const auto degree_num = transform.degree_num;
+    const auto matrix_buf = transform.matrix_buf.get();
+    const auto work_buf = transform.work_buf.get();
+    transform.dequantumize(
+        matrix_buf, block.source, block.weight_code, block.coefficient);
+    odd_givens_inverse_matrix(
+        matrix_buf, transform.revolve_param, block.subband_degree);
+    iplot(matrix_buf, block.subband_degree);
+    ilot(work_buf, last_dct_buf, matrix_buf, block.subband_degree);
     for (const auto i : algo::range(degree_num))
     {
         last_dct_buf[i] = matrix_buf[i];
         matrix_buf[i] = work_buf[i];
     }
     idct(
-        internal_buf.get(),
-        matrix_buf.get(),
+        transform.internal_buf.get(),
+        matrix_buf,
         1,
-        work_buf.get(),
-        subband_degree);
+        work_buf,
+        block.subband_degree);
     round32_array(
-        output_ptr, header.channel_count, internal_buf.get(), samples);
+        block.output,
+        channel_count,
+        transform.internal_buf.get(),
+        block.samples);
 }
 
-void LossyAudioDecoder::Priv::decode_post_block(
-    s16 * output_ptr, const size_t samples)
+static void decode_post_block(
+    Transform &transform,
+    f32 *last_dct_buf,
+    const Block &block,
+    const size_t channel_count)
 {
-    const auto weight_code = *weight_ptr++;
-    const auto coefficient = *coefficient_ptr++;
+    transform.initialize_with_degree(block.subband_degree);
+    const auto degree_num = transform.degree_num;
     const auto half_degree = degree_num / 2;
+    const auto buffer1 = transform.buffer1.get();
+    const auto matrix_buf = transform.matrix_buf.get();
+    const auto work_buf = transform.work_buf.get();
     for (const auto i : algo::range(half_degree))
     {
         buffer1[i * 2] = 0;
-        buffer1[i * 2 + 1] = *source_ptr++;
+        buffer1[i * 2 + 1] = block.source[i];
     }
-    dequantumize(matrix_buf.get(), buffer1.get(), weight_code, coefficient);
-    odd_givens_inverse_matrix(matrix_buf.get(), revolve_param, subband_degree);
+    transform.dequantumize(
+        matrix_buf, buffer1, block.weight_code, block.coefficient);
+    odd_givens_inverse_matrix(
+        matrix_buf, transform.revolve_param, block.subband_degree);
     for (const auto i : algo::range(0, degree_num, 2))
         matrix_buf[i] = -matrix_buf[i + 1];
-    iplot(matrix_buf.get(), subband_degree);
-    ilot(work_buf.get(), last_dct_buf, matrix_buf.get(), subband_degree);
+    iplot(matrix_buf, block.subband_degree);
+    ilot(work_buf, last_dct_buf, matrix_buf, block.subband_degree);
     for (const auto i : algo::range(degree_num))
         matrix_buf[i] = work_buf[i];
     idct(
-        internal_buf.get(),
-        matrix_buf.get(),
+        transform.internal_buf.get(),
+        matrix_buf,
         1,
-        work_buf.get(),
-        subband_degree);
+        work_buf,
+        block.subband_degree);
     round32_array(
-        output_ptr, header.channel_count, internal_buf.get(), samples);
+        block.output,
+        channel_count,
+        transform.internal_buf.get(),
+        block.samples);
+}
+
+LossyAudioDecoder::Priv::Priv(const MioHeader &header) : header(header)
+{
+    if ((header.channel_count != 1) && (header.channel_count != 2))
+        throw err::UnsupportedChannelCountError(header.channel_count);
+    if (header.bits_per_sample != 16)
+        throw err::UnsupportedBitDepthError(header.bits_per_sample);
+
+    if ((header.subband_degree < 8) || (header.subband_degree > max_dct_degree))
+        throw err::CorruptDataError("Unexpected subband degree");
+
+    if (header.lapped_degree != 1)
+        throw err::CorruptDataError("Unexpected lapped degree");
+
+    buf_size = 0;
+
+    for (const auto i : algo::range(header.channel_count))
+    {
+        transforms.push_back(std::make_unique<Transform>(
+            header.subband_degree, header.channel_count));
+    }
+
+    const auto blockset_samples = header.channel_count << header.subband_degree;
+    const auto lapped_samples = blockset_samples * header.lapped_degree;
+    if (lapped_samples > 0)
+    {
+        last_dct = std::make_unique<f32[]>(lapped_samples);
+        for (const auto i : algo::range(lapped_samples))
+            last_dct[i] = 0.0f;
+    }
+}
+
+LossyAudioDecoder::Priv::~Priv()
+{
 }
 
 bstr LossyAudioDecoder::Priv::decode_dct(const MioChunk &chunk)
@@ -672,7 +700,11 @@ bstr LossyAudioDecoder::Priv::decode_dct(const MioChunk &chunk)
     else
         throw err::NotSupportedError("Unsupported architecture");
 
+    // The channels only share the order in which their coefficients are
+    // stored, so lay out the blocks of every channel first and then run the
+    // transforms of the channels concurrently.
     bstr output(all_sample_count * sizeof(s16));
+    std::vector<std::vector<Block>> blocks(channel_count);
     auto output_ptrs = std::make_unique<s16*[]>(channel_count);
     auto samples_left = std::make_unique<size_t[]>(channel_count);
     division_ptr = division_table.get();
@@ -686,82 +718,92 @@ bstr LossyAudioDecoder::Priv::decode_dct(const MioChunk &chunk)
         output_ptrs[i] = output.get<s16>() + i;
     }
 
-    int current_division = -1;
+    const auto add_block = [&](
+        const size_t channel, const BlockType type, const int division_code)
+    {
+        Block block;
+        block.type = type;
+        block.subband_degree = header.subband_degree - division_code;
+        block.weight_code = *weight_ptr++;
+        block.coefficient = *coefficient_ptr++;
+        block.source = source_ptr;
+        block.output = output_ptrs[channel];
+        block.samples = 0;
+        const size_t degree_num = 1 << block.subband_degree;
+        if (type == BlockType::Internal)
+            source_ptr += degree_num;
+        else
+            source_ptr += degree_num / 2;
+        if (type != BlockType::Lead)
+        {
+            block.samples = std::min(samples_left[channel], degree_num);
+            samples_left[channel] -= block.samples;
+            output_ptrs[channel] += block.samples * channel_count;
+        }
+        blocks[channel].push_back(block);
+    };
+
     for (const auto i : algo::range(subband_count))
     for (const auto j : algo::range(channel_count))
     {
         const auto division_code = *division_ptr++;
         const auto division_count = 1 << division_code;
-        int channel_step = degree_width * header.lapped_degree * j;
-        last_dct_buf = last_dct.get() + channel_step;
         auto lead_block = false;
         if (last_division[j] != division_code)
         {
             if (i)
-            {
-                if (current_division != last_division[j])
-                {
-                    initialize_with_degree
-                        (header.subband_degree - last_division[j]);
-                    current_division = last_division[j];
-                }
-                const auto samples_to_process
-                    = std::min(samples_left[j], degree_num);
-                decode_post_block(output_ptrs[j], samples_to_process);
-                samples_left[j] -= samples_to_process;
-                output_ptrs[j] += samples_to_process * channel_count;
-            }
+                add_block(j, BlockType::Post, last_division[j]);
             last_division[j] = division_code;
             lead_block = true;
         }
-        if (current_division != division_code)
-        {
-            initialize_with_degree(header.subband_degree - division_code);
-            current_division = division_code;
-        }
         for (const auto k : algo::range(division_count))
         {
-            if (lead_block)
-            {
-                decode_lead_block();
-                lead_block = false;
-            }
-            else
-            {
-                const auto samples_to_process
-                    = std::min(samples_left[j], degree_num);
-                decode_internal_block(output_ptrs[j], samples_to_process);
-                samples_left[j] -= samples_to_process;
-                output_ptrs[j] += samples_to_process * channel_count;
-            }
+            add_block(
+                j,
+                lead_block ? BlockType::Lead : BlockType::Internal,
+                division_code);
+            lead_block = false;
         }
     }
 
     if (subband_count)
     {
         for (const auto i : algo::range(channel_count))
+            add_block(i, BlockType::Post, last_division[i]);
+    }
+
+    algo::parallel_for(channel_count, [&](const size_t i)
+    {
+        auto &transform = *transforms[i];
+        const auto last_dct_buf
+            = last_dct.get() + degree_width * header.lapped_degree * i;
+        for (const auto &block : blocks[i])
         {
-            const int channel_step = degree_width * header.lapped_degree * i;
-            last_dct_buf = last_dct.get() + channel_step;
-            if (current_division != last_division[i])
+            if (block.type == BlockType::Lead)
+                decode_lead_block(transform, last_dct_buf, block);
+            else if (block.type == BlockType::Internal)
             {
-                initialize_with_degree
-                    (header.subband_degree - last_division[i]);
-                current_division = last_division[i];
+                decode_internal_block(
+                    transform, last_dct_buf, block, channel_count);
+            }
+            else
+            {
+                decode_post_block(
+                    transform, last_dct_buf, block, channel_count);
             }
-            const auto samples_to_process
-                = std::min(samples_left[i], degree_num);
-            decode_post_block(output_ptrs[i], samples_to_process);
-            samples_left[i] -= samples_to_process;
-            output_ptrs[i] += samples_to_process * channel_count;
         }
-    }
+    });
 
     return output;
 }
 
 void LossyAudioDecoder::Priv::decode_lead_block_mss()
 {
+    auto &transform = *transforms[0];
+    const auto degree_num = transform.degree_num;
+    const auto subband_degree = transform.subband_degree;
+    const auto &revolve_param = transform.revolve_param;
+    const auto buffer1 = transform.buffer1.get();
     const auto half_degree = degree_num / 2;
     const auto weight_code = *weight_ptr++;
     const auto coefficient = *coefficient_ptr++;
@@ -773,7 +815,7 @@ void LossyAudioDecoder::Priv::decode_lead_block_mss()
             buffer1[j * 2] = 0;
             buffer1[j * 2 + 1] = *source_ptr++;
         }
-        dequantumize(lap_buf, buffer1.get(), weight_code, coefficient);
+        transform.dequantumize(lap_buf, buffer1, weight_code, coefficient);
         lap_buf += degree_num;
     }
     const auto rev_code = *rev_code_ptr++;
@@ -796,7 +838,15 @@ void LossyAudioDecoder::Priv::decode_lead_block_mss()
 void LossyAudioDecoder::Priv::decode_post_block_mss(
     s16 *output_ptr, size_t samples)
 {
-    auto matrix_ptr = matrix_buf.get();
+    auto &transform = *transforms[0];
+    const auto degree_num = transform.degree_num;
+    const auto subband_degree = transform.subband_degree;
+    const auto &revolve_param = transform.revolve_param;
+    const auto buffer1 = transform.buffer1.get();
+    const auto matrix_buf = transform.matrix_buf.get();
+    const auto internal_buf = transform.internal_buf.get();
+    const auto work_buf = transform.work_buf.get();
+    auto matrix_ptr = matrix_buf;
     auto lap_buf = last_dct.get();
     const auto half_degree = degree_num / 2;
     const auto weight_code = *weight_ptr++;
@@ -808,27 +858,27 @@ void LossyAudioDecoder::Priv::decode_post_block_mss(
             buffer1[j * 2] = 0;
             buffer1[j * 2 + 1] = *source_ptr++;
         }
-        dequantumize(matrix_ptr, buffer1.get(), weight_code, coefficient);
+        transform.dequantumize(matrix_ptr, buffer1, weight_code, coefficient);
         matrix_ptr += degree_num;
     }
     const auto rev_code = *rev_code_ptr++;
-    auto matrix_ptr1 = matrix_buf.get();
-    auto matrix_ptr2 = matrix_buf.get() + degree_num;
+    auto matrix_ptr1 = matrix_buf;
+    auto matrix_ptr2 = matrix_buf + degree_num;
     const auto rsin = static_cast<f32>(std::sin(rev_code * pi / 8));
     const auto rcos = static_cast<f32>(std::cos(rev_code * pi / 8));
     revolve_2x2(matrix_ptr1, matrix_ptr2, rsin, rcos, 1, degree_num);
-    matrix_ptr = matrix_buf.get();
+    matrix_ptr = matrix_buf;
     for (const auto i : algo::range(2))
     {
         odd_givens_inverse_matrix(matrix_ptr, revolve_param, subband_degree);
         for (const auto j : algo::range(0, degree_num, 2))
             matrix_ptr[j] = -matrix_ptr[j + 1];
         iplot(matrix_ptr, subband_degree);
-        ilot(work_buf.get(), lap_buf, matrix_ptr, subband_degree);
+        ilot(work_buf, lap_buf, matrix_ptr, subband_degree);
         for (const auto j : algo::range(degree_num))
             matrix_ptr[j] = work_buf[j];
-        idct(internal_buf.get(), matrix_ptr, 1, work_buf.get(), subband_degree);
-        round32_array(output_ptr + i, 2, internal_buf.get(), samples);
+        idct(internal_buf, matrix_ptr, 1, work_buf, subband_degree);
+        round32_array(output_ptr + i, 2, internal_buf, samples);
         lap_buf += degree_num;
         matrix_ptr += degree_num;
     }
@@ -837,13 +887,21 @@ void LossyAudioDecoder::Priv::decode_post_block_mss(
 void LossyAudioDecoder::Priv::decode_internal_block_mss(
     s16 *output_ptr, size_t samples)
 {
-    auto matrix_ptr = matrix_buf.get();
+    auto &transform = *transforms[0];
+    const auto degree_num = transform.degree_num;
+    const auto subband_degree = transform.subband_degree;
+    const auto &revolve_param = transform.revolve_param;
+    const auto matrix_buf = transform.matrix_buf.get();
+    const auto internal_buf = transform.internal_buf.get();
+    const auto work_buf = transform.work_buf.get();
+    auto matrix_ptr = matrix_buf;
     auto lap_buf = last_dct.get();
     const auto weight_code = *weight_ptr++;
     const auto coefficient = *coefficient_ptr++;
     for (const auto i : algo::range(2))
     {
-        dequantumize(matrix_ptr, source_ptr, weight_code, coefficient);
+        transform.dequantumize(
+            matrix_ptr, source_ptr, weight_code, coefficient);
         source_ptr += degree_num;
         matrix_ptr += degree_num;
     }
@@ -853,8 +911,8 @@ void LossyAudioDecoder::Priv::decode_internal_block_mss(
     const int rev_code2 = rev_code & 0x03;
 
     f32 rsin, rcos;
-    f32 *matrix_ptr1 = matrix_buf.get();
-    f32 *matrix_ptr2 = matrix_buf.get() + degree_num;
+    f32 *matrix_ptr1 = matrix_buf;
+    f32 *matrix_ptr2 = matrix_buf + degree_num;
     rsin = static_cast<f32>(std::sin(rev_code1 * pi / 8));
     rcos = static_cast<f32>(std::cos(rev_code1 * pi / 8));
     revolve_2x2(matrix_ptr1, matrix_ptr2, rsin, rcos, 2, degree_num / 2);
@@ -862,19 +920,19 @@ void LossyAudioDecoder::Priv::decode_internal_block_mss(
     rcos = static_cast<f32>(std::cos(rev_code2 * pi / 8));
     revolve_2x2(matrix_ptr1+1, matrix_ptr2+1, rsin, rcos, 2, degree_num / 2);
 
-    matrix_ptr = matrix_buf.get();
+    matrix_ptr = matrix_buf;
     for (const auto i : algo::range(2))
     {
         odd_givens_inverse_matrix(matrix_ptr, revolve_param, subband_degree);
         iplot(matrix_ptr, subband_degree);
-        ilot(work_buf.get(), lap_buf, matrix_ptr, subband_degree);
+        ilot(work_buf, lap_buf, matrix_ptr, subband_degree);
         for (const auto j : algo::range(degree_num))
         {
             lap_buf[j] = matrix_ptr[j];
             matrix_ptr[j] = work_buf[j];
         }
-        idct(internal_buf.get(), matrix_ptr, 1, work_buf.get(), subband_degree);
-        round32_array(output_ptr + i, 2, internal_buf.get(), samples);
+        idct(internal_buf, matrix_ptr, 1, work_buf, subband_degree);
+        round32_array(output_ptr + i, 2, internal_buf, samples);
         matrix_ptr += degree_num;
         lap_buf += degree_num;
     }
@@ -882,6 +940,7 @@ void LossyAudioDecoder::Priv::decode_internal_block_mss(
 
 bstr LossyAudioDecoder::Priv::decode_dct_mss(const MioChunk &chunk)
 {
+    auto &transform = *transforms[0];
     const auto degree_width = 1 << header.subband_degree;
     const auto sample_count
         = (chunk.sample_count + degree_width - 1) & ~(degree_width - 1);
@@ -1001,12 +1060,13 @@ bstr LossyAudioDecoder::Priv::decode_dct_mss(const MioChunk &chunk)
             if (i)
             {
                 const auto samples_to_process
-                    = std::min(samples_left, degree_num);
+                    = std::min(samples_left, transform.degree_num);
                 decode_post_block_mss(output_ptr, samples_to_process);
                 samples_left -= samples_to_process;
                 output_ptr += samples_to_process * channel_count;
             }
-            initialize_with_degree(header.subband_degree - division_code);
+            transform.initialize_with_degree(
+                header.subband_degree - division_code);
             last_division_code = division_code;
             lead_block = true;
         }
@@ -1021,7 +1081,7 @@ bstr LossyAudioDecoder::Priv::decode_dct_mss(const MioChunk &chunk)
             else
             {
                 const auto samples_to_process
-                    = std::min(samples_left, degree_num);
+                    = std::min(samples_left, transform.degree_num);
                 decode_internal_block_mss(output_ptr, samples_to_process);
                 samples_left -= samples_to_process;
                 output_ptr += samples_to_process * channel_count;
@@ -1031,7 +1091,8 @@ bstr LossyAudioDecoder::Priv::decode_dct_mss(const MioChunk &chunk)
 
     if (subband_count)
     {
-        const auto samples_to_process = std::min(samples_left, degree_num);
+        const auto samples_to_process
+            = std::min(samples_left, transform.degree_num);
         decode_post_block_mss(output_ptr, samples_to_process);
         samples_left -= samples_to_process;
         output_ptr += samples_to_process * channel_count;
@@ -1043,7 +1104,6 @@ bstr LossyAudioDecoder::Priv::decode_dct_mss(const MioChunk &chunk)
 LossyAudioDecoder::LossyAudioDecoder(const MioHeader &header)
     : p(new Priv(header))
 {
-    init_dct_of_k_matrix();
     if (header.architecture == common::Architecture::RunLengthGamma)
     {
         // this is nonsense but hey, I just reimplement stuff
@@ -86,6 +86,12 @@ bool MioAudioDecoder::is_recognized_impl(io::File &input_file) const
 
 res::Audio MioAudioDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
+{
+    return collect_stream(logger, input_file);
+}
+
+void MioAudioDecoder::decode_stream_impl(
+    const Logger &logger, io::File &input_file, res::IAudioSink &sink) const
 {
     input_file.stream.seek(0x40);
 
@@ -107,16 +113,14 @@ res::Audio MioAudioDecoder::decode_impl(
             "Transformation type %d not supported", header.transformation));
     }
 
-    bstr samples;
-    for (const auto chunk : chunks)
-        samples += impl->process_chunk(chunk);
-
     res::Audio audio;
     audio.channel_count = header.channel_count;
     audio.bits_per_sample = header.bits_per_sample;
     audio.sample_rate = header.sample_rate;
-    audio.samples = samples;
-    return audio;
+    sink.begin(audio);
+    for (const auto &chunk : chunks)
+        sink.write(impl->process_chunk(chunk));
+    sink.end();
 }
 
 static auto _ = dec::register_decoder<MioAudioDecoder>("entis/mio");
@@ -16,6 +16,8 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/ivory/wady_audio_decoder.h"
+#include <algorithm>
+#include "algo/audio/delta_pcm.h"
 #include "algo/range.h"
 #include "err.h"
 #include "io/memory_byte_stream.h"
@@ -24,6 +26,7 @@ using namespace au;
 using namespace au::dec::ivory;
 
 static const bstr magic = "WADY"_b;
+static const size_t frames_per_chunk = 0x10000;
 
 namespace
 {
@@ -72,51 +75,35 @@ static Version detect_version(io::BaseByteStream &input_stream)
     return version;
 }
 
-static bstr decode_v1(
+static void decode_v1(
     io::BaseByteStream &input_stream,
     const size_t sample_count,
     const size_t channels,
-    const size_t block_align)
+    const int multiplier,
+    res::IAudioSink &sink)
 {
-    static const u16 table[0x40] =
-    {
-        0x0000, 0x0002, 0x0004, 0x0006, 0x0008, 0x000A, 0x000C, 0x000F,
-        0x0012, 0x0015, 0x0018, 0x001C, 0x0020, 0x0024, 0x0028, 0x002C,
-        0x0031, 0x0036, 0x003B, 0x0040, 0x0046, 0x004C, 0x0052, 0x0058,
-        0x005F, 0x0066, 0x006D, 0x0074, 0x007C, 0x0084, 0x008C, 0x0094,
-        0x00A0, 0x00AA, 0x00B4, 0x00BE, 0x00C8, 0x00D2, 0x00DC, 0x00E6,
-        0x00F0, 0x00FF, 0x010E, 0x011D, 0x012C, 0x0140, 0x0154, 0x0168,
-        0x017C, 0x0190, 0x01A9, 0x01C2, 0x01DB, 0x01F4, 0x020D, 0x0226,
-        0x0244, 0x0262, 0x028A, 0x02BC, 0x02EE, 0x0320, 0x0384, 0x03E8,
-    };
-
-    bstr samples(sample_count * 2 * channels);
-    auto samples_ptr = samples.get<u16>();
-    auto samples_end = samples.end<u16>();
+    if (!channels)
+        return;
 
-    u16 prev_sample[2] = {0, 0};
-    io::MemoryByteStream tmp_stream(input_stream);
-    while (tmp_stream.left() && samples_ptr < samples_end)
+    algo::audio::DeltaPcmDecoder decoder(channels, multiplier);
+    size_t frames_left = sample_count;
+    while (frames_left && input_stream.left() >= channels)
     {
-        for (const auto i : algo::range(channels))
-        {
-            const u16 b = tmp_stream.read<u8>();
-            if (b & 0x80)
-            {
-                prev_sample[i] = b << 9;
-            }
-            else
-            {
-                u16 tmp = static_cast<s16>(b << 9) >> 15;
-                tmp = (tmp ^ table[b & 0x3F]) - tmp;
-                tmp *= block_align;
-                prev_sample[i] += tmp;
-            }
-            *samples_ptr++ = prev_sample[i];
-        }
+        const auto frame_count = std::min<size_t>(
+            std::min<size_t>(frames_per_chunk, frames_left),
+            input_stream.left() / channels);
+        sink.write(decoder.decode(input_stream.read(frame_count * channels)));
+        frames_left -= frame_count;
     }
 
-    return samples;
+    // frames past the end of input are left silent
+    while (frames_left)
+    {
+        const auto frame_count
+            = std::min<size_t>(frames_per_chunk, frames_left);
+        sink.write(bstr(frame_count * channels * 2));
+        frames_left -= frame_count;
+    }
 }
 
 static bstr decode_v2(
@@ -200,6 +187,12 @@ bool WadyAudioDecoder::is_recognized_impl(io::File &input_file) const
 
 res::Audio WadyAudioDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
+{
+    return collect_stream(logger, input_file);
+}
+
+void WadyAudioDecoder::decode_stream_impl(
+    const Logger &logger, io::File &input_file, res::IAudioSink &sink) const
 {
     input_file.stream.skip(magic.size());
     input_file.stream.skip(2);
@@ -226,27 +219,25 @@ res::Audio WadyAudioDecoder::decode_impl(
     const auto bits_per_sample = input_file.stream.read_le<u16>();
 
     input_file.stream.seek(0x30);
-    bstr samples;
+    res::Audio audio;
+    audio.channel_count = channels;
+    audio.bits_per_sample = bits_per_sample;
+    audio.sample_rate = sample_rate;
+    sink.begin(audio);
     if (version == Version::Version1)
     {
-        samples = decode_v1(
-            input_file.stream, sample_count, channels, block_align);
+        decode_v1(input_file.stream, sample_count, channels, block_align, sink);
     }
     else if (version == Version::Version2)
     {
-        samples = decode_v2(input_file.stream, sample_count, channels);
+        // channels are stored one after another, so they can't be streamed
+        sink.write(decode_v2(input_file.stream, sample_count, channels));
     }
     else
     {
         throw err::UnsupportedVersionError(version);
     }
-
-    res::Audio audio;
-    audio.channel_count = channels;
-    audio.bits_per_sample = bits_per_sample;
-    audio.sample_rate = sample_rate;
-    audio.samples = samples;
-    return audio;
+    sink.end();
 }
 
 static auto _ = dec::register_decoder<WadyAudioDecoder>("ivory/wady");
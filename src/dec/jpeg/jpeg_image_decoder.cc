@@ -17,7 +17,9 @@
 
 #include "dec/jpeg/jpeg_image_decoder.h"
 #include <jpeglib.h>
+#include <vector>
 #include "algo/range.h"
+#include "algo/str.h"
 #include "err.h"
 
 using namespace au;
@@ -25,11 +27,74 @@ using namespace au::dec::jpeg;
 
 static const bstr magic = "\xFF\xD8\xFF"_b;
 
+JpegImageDecoder::JpegImageDecoder() : fast_mode(false), scale_denominator(1)
+{
+    add_arg_parser_decorator(
+        [](ArgParser &arg_parser)
+        {
+            arg_parser.register_flag({"--jpeg-fast"})
+                ->set_description(
+                    "Trades JPEG decoding quality for speed by using fast "
+                    "integer IDCT and disabling fancy upsampling.");
+
+            arg_parser.register_switch({"--jpeg-scale"})
+                ->set_value_name("NUM")
+                ->set_description(
+                    "Decodes JPEG images downscaled by given factor. "
+                    "Useful for extracting previews.")
+                ->add_possible_value("1")
+                ->add_possible_value("2")
+                ->add_possible_value("4")
+                ->add_possible_value("8");
+        },
+        [&](const ArgParser &arg_parser)
+        {
+            set_fast_mode(arg_parser.has_flag("jpeg-fast"));
+            if (arg_parser.has_switch("jpeg-scale"))
+            {
+                set_scale_denominator(algo::from_string<int>(
+                    arg_parser.get_switch("jpeg-scale")));
+            }
+        });
+}
+
+void JpegImageDecoder::set_fast_mode(const bool fast_mode)
+{
+    this->fast_mode = fast_mode;
+}
+
+void JpegImageDecoder::set_scale_denominator(const size_t scale_denominator)
+{
+    if (scale_denominator != 1
+        && scale_denominator != 2
+        && scale_denominator != 4
+        && scale_denominator != 8)
+    {
+        throw err::UsageError("JPEG scale can be either 1, 2, 4 or 8");
+    }
+    this->scale_denominator = scale_denominator;
+}
+
 bool JpegImageDecoder::is_recognized_impl(io::File &input_file) const
 {
     return input_file.stream.read(magic.size()) == magic;
 }
 
+static void read_scanlines(
+    jpeg_decompress_struct &info, u8 *output, const size_t stride)
+{
+    std::vector<JSAMPROW> rows(info.output_height);
+    for (const auto y : algo::range(info.output_height))
+        rows[y] = output + y * stride;
+    while (info.output_scanline < info.output_height)
+    {
+        jpeg_read_scanlines(
+            &info,
+            &rows[info.output_scanline],
+            info.output_height - info.output_scanline);
+    }
+}
+
 res::Image JpegImageDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
 {
@@ -41,32 +106,55 @@ res::Image JpegImageDecoder::decode_impl(
     jpeg_create_decompress(&info);
     jpeg_mem_src(&info, source.get<u8>(), source.size());
     jpeg_read_header(&info, true);
+
+    if (fast_mode)
+    {
+        info.dct_method = JDCT_IFAST;
+        info.do_fancy_upsampling = false;
+        info.do_block_smoothing = false;
+    }
+    info.scale_num = 1;
+    info.scale_denom = scale_denominator;
+
+    const auto channels = info.num_components;
+    if (channels != 1 && channels != 3 && channels != 4)
+    {
+        jpeg_destroy_decompress(&info);
+        throw err::UnsupportedChannelCountError(channels);
+    }
+
+    #ifdef JCS_EXTENSIONS
+        // libjpeg-turbo can write BGRA pixels directly to the target image.
+        if (channels != 4)
+        {
+            info.out_color_space = JCS_EXT_BGRA;
+            jpeg_start_decompress(&info);
+            res::Image image(info.output_width, info.output_height);
+            read_scanlines(
+                info,
+                reinterpret_cast<u8*>(&image.at(0, 0)),
+                info.output_width * sizeof(res::Pixel));
+            jpeg_finish_decompress(&info);
+            jpeg_destroy_decompress(&info);
+            return image;
+        }
+    #endif
+
     jpeg_start_decompress(&info);
 
     const auto width = info.output_width;
     const auto height = info.output_height;
-    const auto channels = info.num_components;
 
     res::PixelFormat format;
     if (channels == 3)
         format = res::PixelFormat::RGB888;
     else if (channels == 4)
         format = res::PixelFormat::RGBA8888;
-    else if (channels == 1)
-        format = res::PixelFormat::Gray8;
     else
-    {
-        jpeg_finish_decompress(&info);
-        jpeg_destroy_decompress(&info);
-        throw err::UnsupportedChannelCountError(channels);
-    }
+        format = res::PixelFormat::Gray8;
 
     bstr raw_data(width * height * channels);
-    for (const auto y : algo::range(height))
-    {
-        auto ptr = raw_data.get<u8>() + y * width * channels;
-        jpeg_read_scanlines(&info, &ptr, 1);
-    }
+    read_scanlines(info, raw_data.get<u8>(), width * channels);
     jpeg_finish_decompress(&info);
     jpeg_destroy_decompress(&info);
 
@@ -25,10 +25,19 @@ namespace jpeg {
 
     class JpegImageDecoder final : public BaseImageDecoder
     {
+    public:
+        JpegImageDecoder();
+        void set_fast_mode(const bool fast_mode);
+        void set_scale_denominator(const size_t scale_denominator);
+
     protected:
         bool is_recognized_impl(io::File &input_file) const override;
         res::Image decode_impl(
             const Logger &logger, io::File &input_file) const override;
+
+    private:
+        bool fast_mode;
+        size_t scale_denominator;
     };
 
 } } }
@@ -38,8 +38,8 @@ res::Audio WafAudioDecoder::decode_impl(
     audio.codec = 2;
     audio.channel_count = input_file.stream.read_le<u16>();
     audio.sample_rate = input_file.stream.read_le<u32>();
-    const auto byte_rate = input_file.stream.read_le<u32>();
-    const auto block_align = input_file.stream.read_le<u16>();
+    audio.byte_rate = input_file.stream.read_le<u32>();
+    audio.block_align = input_file.stream.read_le<u16>();
     audio.bits_per_sample = input_file.stream.read_le<u16>();
     audio.extra_codec_headers = input_file.stream.read(32);
     const auto samples_size = input_file.stream.read_le<u32>();
@@ -16,6 +16,9 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/kirikiri/cxdec.h"
+#include <map>
+#include <mutex>
+#include <vector>
 #include "algo/range.h"
 #include "err.h"
 #include "io/file_byte_stream.h"
@@ -44,44 +47,96 @@ namespace
         std::array<size_t, 6> key_derivation_order3;
     };
 
-    class KeyDeriver final
+    enum class OpType : u8
+    {
+        PushConstant,
+        PushParameter,
+        Not,
+        Dec,
+        Neg,
+        Inc,
+        ControlBlockLookup,
+        SwapBits,
+        Xor,
+        Add,
+        Sub,
+        ShiftRightBy,
+        ShiftLeftBy,
+        AddTo,
+        SubtractFrom,
+        MultiplyBy,
+        Subtract,
+    };
+
+    struct Op final
+    {
+        OpType type;
+        u32 value;
+    };
+
+    using KeyDerivationProgram = std::vector<Op>;
+
+    class KeyDerivationCompiler final
     {
     public:
-        KeyDeriver(const CxdecSettings &settings);
-        u32 derive(u32 seed, u32 parameter);
+        KeyDerivationCompiler(const CxdecSettings &settings);
+        KeyDerivationProgram compile(u32 seed);
 
     private:
         void add_shellcode(const bstr &bytes_s);
+        void add_op(const OpType type, const u32 value = 0);
         u32 rand();
-        u32 derive_for_stage(size_t stage);
-        u32 run_first_stage();
-        u32 run_stage_strategy_0(size_t stage);
-        u32 run_stage_strategy_1(size_t stage);
+        void derive_for_stage(size_t stage);
+        void run_first_stage();
+        void run_stage_strategy_0(size_t stage);
+        void run_stage_strategy_1(size_t stage);
 
         const CxdecSettings &settings;
         bstr shellcode;
+        KeyDerivationProgram program;
         u32 seed;
-        size_t parameter;
         u32 control_block_addr;
     };
+
+    class ControlBlockCache final
+    {
+    public:
+        bstr get(const io::path &dir);
+
+    private:
+        std::mutex mutex;
+        std::map<std::string, bstr> control_blocks;
+    };
+
+    class KeyDeriver final
+    {
+    public:
+        KeyDeriver(const CxdecSettings &settings);
+        u32 derive(u32 seed, u32 parameter) const;
+
+    private:
+        const CxdecSettings settings;
+        std::array<KeyDerivationProgram, 128> programs;
+    };
 }
 
+static const size_t max_stack_size = 8;
+
 static bstr u32_to_string(u32 value)
 {
     return bstr(reinterpret_cast<char*>(&value), 4);
 }
 
-KeyDeriver::KeyDeriver(const CxdecSettings &settings) : settings(settings)
+KeyDerivationCompiler::KeyDerivationCompiler(const CxdecSettings &settings)
+    : settings(settings)
 {
     seed = 0;
-    parameter = 0;
     control_block_addr = reinterpret_cast<size_t>(&settings.control_block);
 }
 
-u32 KeyDeriver::derive(u32 seed, u32 parameter)
+KeyDerivationProgram KeyDerivationCompiler::compile(u32 seed)
 {
     this->seed = seed;
-    this->parameter = parameter;
 
     // What we do: we try to run a code a few times for different "stages".
     // The first one to succeed yields the key.
@@ -95,22 +150,28 @@ u32 KeyDeriver::derive(u32 seed, u32 parameter)
     // Maintaining the randomizer state is essential for the decryption to
     // work.
 
+    // None of this depends on the parameter, so instead of computing the key
+    // right away we record the operations and replay them for each parameter
+    // later on.
+
     for (size_t stage = 5; stage > 0; stage--)
     {
         try
         {
-            return derive_for_stage(stage);
+            program.clear();
+            derive_for_stage(stage);
+            return program;
         }
-        catch (const KeyDerivationError)
+        catch (const KeyDerivationError &)
         {
             continue;
         }
     }
 
-    throw err::NotSupportedError("Failed to derive the key from the parameter");
+    return {};
 }
 
-void KeyDeriver::add_shellcode(const bstr &bytes)
+void KeyDerivationCompiler::add_shellcode(const bstr &bytes)
 {
     // The execution for current stage must fail when we run code for too long.
     shellcode += bytes;
@@ -118,7 +179,12 @@ void KeyDeriver::add_shellcode(const bstr &bytes)
         throw KeyDerivationError();
 }
 
-u32 KeyDeriver::rand()
+void KeyDerivationCompiler::add_op(const OpType type, const u32 value)
+{
+    program.push_back({type, value});
+}
+
+u32 KeyDerivationCompiler::rand()
 {
     // This is a modified glibc LCG randomization routine. It is used to make
     // the key as random as possible for each file, which is supposed to
@@ -128,7 +194,7 @@ u32 KeyDeriver::rand()
     return seed ^ (old_seed << 16) ^ (old_seed >> 16);
 }
 
-u32 KeyDeriver::derive_for_stage(size_t stage)
+void KeyDerivationCompiler::derive_for_stage(size_t stage)
 {
     shellcode = ""_b;
 
@@ -138,22 +204,19 @@ u32 KeyDeriver::derive_for_stage(size_t stage)
     // mov edi, dword ptr ss:[esp+18] (esp+18 == parameter)
     add_shellcode("\x86\x7C\x24\x18"_b);
 
-    const auto eax = run_stage_strategy_1(stage);
+    run_stage_strategy_1(stage);
 
     // pop edx, pop ecx, pop ebx, pop esi, pop edi
     add_shellcode("\x5A\x59\x5B\x5E\x5F"_b);
 
     // retn
     add_shellcode("\xC3"_b);
-
-    return eax;
 }
 
-u32 KeyDeriver::run_first_stage()
+void KeyDerivationCompiler::run_first_stage()
 {
     const auto routine_number = settings.key_derivation_order1[rand() % 3];
 
-    u32 eax;
     switch (routine_number)
     {
         case 0:
@@ -162,14 +225,14 @@ u32 KeyDeriver::run_first_stage()
             add_shellcode("\xB8"_b);
             const auto tmp = rand();
             add_shellcode(u32_to_string(tmp));
-            eax = tmp;
+            add_op(OpType::PushConstant, tmp);
             break;
         }
 
         case 1:
             // mov eax, edi
             add_shellcode("\xB8\xC7"_b);
-            eax = parameter;
+            add_op(OpType::PushParameter);
             break;
 
         case 2:
@@ -183,25 +246,26 @@ u32 KeyDeriver::run_first_stage()
             const auto pos = (rand() & 0x3FF) * 4;
             add_shellcode(u32_to_string(pos));
 
-            eax = *reinterpret_cast<const u32*>(&settings.control_block[pos]);
+            add_op(
+                OpType::PushConstant,
+                *reinterpret_cast<const u32*>(&settings.control_block[pos]));
             break;
         }
 
         default:
             throw std::logic_error("Bad routine number");
     }
-
-    return eax;
 }
 
-u32 KeyDeriver::run_stage_strategy_0(size_t stage)
+void KeyDerivationCompiler::run_stage_strategy_0(size_t stage)
 {
     if (stage == 1)
         return run_first_stage();
 
-    auto eax = (rand() & 1)
-        ? run_stage_strategy_1(stage - 1)
-        : run_stage_strategy_0(stage - 1);
+    if (rand() & 1)
+        run_stage_strategy_1(stage - 1);
+    else
+        run_stage_strategy_0(stage - 1);
 
     const auto routine_number = settings.key_derivation_order2[rand() % 8];
 
@@ -210,25 +274,25 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
         case 0:
             // not eax
             add_shellcode("\xF7\xD0"_b);
-            eax ^= 0xFFFFFFFF;
+            add_op(OpType::Not);
             break;
 
         case 1:
             // dec eax
             add_shellcode("\x48"_b);
-            eax--;
+            add_op(OpType::Dec);
             break;
 
         case 2:
             // neg eax
             add_shellcode("\xF7\xD8"_b);
-            eax = static_cast<u32>(-static_cast<s32>(eax));
+            add_op(OpType::Neg);
             break;
 
         case 3:
             // inc eax
             add_shellcode("\x40"_b);
-            eax++;
+            add_op(OpType::Inc);
             break;
 
         case 4:
@@ -242,8 +306,7 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
             // mov eax, dword ptr ds:[esi+eax*4]
             add_shellcode("\x8B\x04\x86"_b);
 
-            eax = *reinterpret_cast<const u32*>(
-                &settings.control_block[(eax & 0x3FF) * 4]);
+            add_op(OpType::ControlBlockLookup);
             break;
 
         case 5:
@@ -272,12 +335,7 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
             // pop ebx
             add_shellcode("\x5B"_b);
 
-            auto ebx = eax;
-            ebx &= 0xAAAAAAAA;
-            eax &= 0x55555555;
-            ebx >>= 1;
-            eax <<= 1;
-            eax |= ebx;
+            add_op(OpType::SwapBits);
             break;
         }
 
@@ -288,7 +346,7 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
             const auto tmp = rand();
             add_shellcode(u32_to_string(tmp));
 
-            eax ^= tmp;
+            add_op(OpType::Xor, tmp);
             break;
         }
 
@@ -301,7 +359,7 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
                 const auto tmp = rand();
                 add_shellcode(u32_to_string(tmp));
 
-                eax += tmp;
+                add_op(OpType::Add, tmp);
             }
             else
             {
@@ -310,7 +368,7 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
                 const auto tmp = rand();
                 add_shellcode(u32_to_string(tmp));
 
-                eax -= tmp;
+                add_op(OpType::Sub, tmp);
             }
             break;
         }
@@ -318,11 +376,9 @@ u32 KeyDeriver::run_stage_strategy_0(size_t stage)
         default:
             throw std::logic_error("Bad routine number");
     }
-
-    return eax;
 }
 
-u32 KeyDeriver::run_stage_strategy_1(size_t stage)
+void KeyDerivationCompiler::run_stage_strategy_1(size_t stage)
 {
     if (stage == 1)
         return run_first_stage();
@@ -330,17 +386,18 @@ u32 KeyDeriver::run_stage_strategy_1(size_t stage)
     // push ebx
     add_shellcode("\x53"_b);
 
-    auto eax = (rand() & 1)
-        ? run_stage_strategy_1(stage - 1)
-        : run_stage_strategy_0(stage - 1);
+    if (rand() & 1)
+        run_stage_strategy_1(stage - 1);
+    else
+        run_stage_strategy_0(stage - 1);
 
     // mov ebx, eax
     add_shellcode("\x89\xC3"_b);
-    const auto ebx = eax;
 
-    eax = (rand() & 1)
-        ? run_stage_strategy_1(stage - 1)
-        : run_stage_strategy_0(stage - 1);
+    if (rand() & 1)
+        run_stage_strategy_1(stage - 1);
+    else
+        run_stage_strategy_0(stage - 1);
 
     const auto routine_number = settings.key_derivation_order3[rand() % 6];
     switch (routine_number)
@@ -362,8 +419,7 @@ u32 KeyDeriver::run_stage_strategy_1(size_t stage)
             // pop ecx
             add_shellcode("\x59"_b);
 
-            const auto ecx = ebx & 0x0F;
-            eax >>= ecx;
+            add_op(OpType::ShiftRightBy);
             break;
         }
 
@@ -384,15 +440,14 @@ u32 KeyDeriver::run_stage_strategy_1(size_t stage)
             // pop ecx
             add_shellcode("\x59"_b);
 
-            const auto ecx = ebx & 0x0F;
-            eax <<= ecx;
+            add_op(OpType::ShiftLeftBy);
             break;
         }
 
         case 2:
             // add eax, ebx
             add_shellcode("\x01\xD8"_b);
-            eax += ebx;
+            add_op(OpType::AddTo);
             break;
 
         case 3:
@@ -400,19 +455,19 @@ u32 KeyDeriver::run_stage_strategy_1(size_t stage)
             add_shellcode("\xF7\xD8"_b);
             // add eax, ebx
             add_shellcode("\x01\xD8"_b);
-            eax = ebx - eax;
+            add_op(OpType::SubtractFrom);
             break;
 
         case 4:
             // imul eax, ebx
             add_shellcode("\x0F\xAF\xC3"_b);
-            eax *= ebx;
+            add_op(OpType::MultiplyBy);
             break;
 
         case 5:
             // sub eax, ebx
             add_shellcode("\x29\xD8"_b);
-            eax -= ebx;
+            add_op(OpType::Subtract);
             break;
 
         default:
@@ -421,12 +476,108 @@ u32 KeyDeriver::run_stage_strategy_1(size_t stage)
 
     // pop ebx
     add_shellcode("\x5B"_b);
+}
 
-    return eax;
+KeyDeriver::KeyDeriver(const CxdecSettings &settings) : settings(settings)
+{
+    KeyDerivationCompiler compiler(this->settings);
+    for (const auto seed : algo::range(programs.size()))
+        programs[seed] = compiler.compile(seed);
+}
+
+u32 KeyDeriver::derive(u32 seed, u32 parameter) const
+{
+    const auto &program = programs.at(seed);
+    if (program.empty())
+    {
+        throw err::NotSupportedError(
+            "Failed to derive the key from the parameter");
+    }
+
+    // eax is the top of the stack; strategy 1 keeps its first result
+    // (ebx) right below it
+    std::array<u32, max_stack_size> stack;
+    size_t stack_size = 0;
+    for (const auto &op : program)
+    {
+        if (op.type == OpType::PushConstant)
+        {
+            stack[stack_size++] = op.value;
+            continue;
+        }
+        if (op.type == OpType::PushParameter)
+        {
+            stack[stack_size++] = parameter;
+            continue;
+        }
+
+        auto &eax = stack[stack_size - 1];
+        switch (op.type)
+        {
+            case OpType::Not:
+                eax ^= 0xFFFFFFFF;
+                break;
+
+            case OpType::Dec:
+                eax--;
+                break;
+
+            case OpType::Neg:
+                eax = static_cast<u32>(-static_cast<s32>(eax));
+                break;
+
+            case OpType::Inc:
+                eax++;
+                break;
+
+            case OpType::ControlBlockLookup:
+                eax = *reinterpret_cast<const u32*>(
+                    &settings.control_block[(eax & 0x3FF) * 4]);
+                break;
+
+            case OpType::SwapBits:
+                eax = ((eax & 0xAAAAAAAA) >> 1) | ((eax & 0x55555555) << 1);
+                break;
+
+            case OpType::Xor:
+                eax ^= op.value;
+                break;
+
+            case OpType::Add:
+                eax += op.value;
+                break;
+
+            case OpType::Sub:
+                eax -= op.value;
+                break;
+
+            default:
+            {
+                auto &ebx = stack[stack_size - 2];
+                stack_size--;
+                if (op.type == OpType::ShiftRightBy)
+                    ebx = eax >> (ebx & 0x0F);
+                else if (op.type == OpType::ShiftLeftBy)
+                    ebx = eax << (ebx & 0x0F);
+                else if (op.type == OpType::AddTo)
+                    ebx = eax + ebx;
+                else if (op.type == OpType::SubtractFrom)
+                    ebx = ebx - eax;
+                else if (op.type == OpType::MultiplyBy)
+                    ebx = eax * ebx;
+                else if (op.type == OpType::Subtract)
+                    ebx = eax - ebx;
+                else
+                    throw std::logic_error("Bad operation");
+                break;
+            }
+        }
+    }
+    return stack[0];
 }
 
 static void decrypt_chunk(
-    KeyDeriver &key_deriver,
+    const KeyDeriver &key_deriver,
     bstr &data,
     u32 hash,
     size_t base_offset,
@@ -456,9 +607,8 @@ static void decrypt_chunk(
         data_ptr[i] ^= xor2;
 }
 
-static bstr find_control_block(const io::path &path)
+static bstr find_control_block(const io::path &dir)
 {
-    const auto dir = path.parent();
     for (const auto &path : io::recursive_directory_range(dir))
     {
         if (!io::is_regular_file(path))
@@ -486,6 +636,19 @@ static bstr find_control_block(const io::path &path)
     throw err::FileNotFoundError("TPM file not found");
 }
 
+bstr ControlBlockCache::get(const io::path &dir)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = control_blocks.find(dir.str());
+    if (it != control_blocks.end())
+        return it->second;
+    const auto control_block = find_control_block(dir);
+    control_blocks[dir.str()] = control_block;
+    return control_block;
+}
+
+static ControlBlockCache control_block_cache;
+
 Xp3Plugin au::dec::kirikiri::create_cxdec_plugin(
     const u16 key1,
     const u16 key2,
@@ -500,23 +663,23 @@ Xp3Plugin au::dec::kirikiri::create_cxdec_plugin(
     {
         CxdecSettings settings;
         settings.control_block = control_block.empty()
-            ? find_control_block(arc_path)
+            ? control_block_cache.get(arc_path.parent())
             : control_block;
         settings.key_derivation_order1 = key_derivation_order1;
         settings.key_derivation_order2 = key_derivation_order2;
         settings.key_derivation_order3 = key_derivation_order3;
 
+        const auto key_deriver = std::make_shared<const KeyDeriver>(settings);
         return [=](bstr &data, u32 adlr_key)
         {
-            KeyDeriver key_deriver(settings);
             const auto hash1 = adlr_key;
             const auto hash2 = (adlr_key >> 16) ^ adlr_key;
             const auto offset1 = 0;
             const auto offset2 = std::min<size_t>(
                 data.size(), (adlr_key & key1) + key2);
-            decrypt_chunk(key_deriver, data, hash1, offset1, offset2);
+            decrypt_chunk(*key_deriver, data, hash1, offset1, offset2);
             decrypt_chunk(
-                key_deriver, data, hash2, offset2, data.size() - offset2);
+                *key_deriver, data, hash2, offset2, data.size() - offset2);
         };
     };
     return plugin;
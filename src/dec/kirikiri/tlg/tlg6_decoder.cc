@@ -16,6 +16,10 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/kirikiri/tlg/tlg6_decoder.h"
+#include <thread>
+#include <vector>
+#include "algo/lazy.h"
+#include "algo/parallel.h"
 #include "algo/range.h"
 #include "dec/kirikiri/tlg/lzss_decompressor.h"
 #include "err.h"
@@ -29,9 +33,6 @@ static const int golomb_n_count = 4;
 static const int leading_zero_table_bits = 12;
 static const int leading_zero_table_size = (1 << leading_zero_table_bits);
 
-static u8 leading_zero_table[leading_zero_table_size];
-static u8 golomb_bit_size_table[golomb_n_count * 2 * 128][golomb_n_count];
-
 namespace
 {
     struct Header final
@@ -224,13 +225,18 @@ static inline u32 avg(u32 a, u32 b, u32, u32 v)
         + ((a ^ b) & 0x01010101), v);
 }
 
-static void init_table()
+namespace
 {
-    static bool initialized = false;
-    if (initialized)
-        return;
-    initialized = true;
+    struct LookupTables final
+    {
+        u8 leading_zero[leading_zero_table_size];
+        u8 golomb_bit_size[golomb_n_count * 2 * 128][golomb_n_count];
+    };
+}
 
+static LookupTables create_lookup_tables()
+{
+    LookupTables tables;
     short golomb_compression_table[golomb_n_count][9] =
     {
         {3, 7, 15, 27, 63, 108, 223, 448, 130},
@@ -255,7 +261,7 @@ static void init_table()
         if (j == leading_zero_table_size)
             cnt = 0;
 
-        leading_zero_table[i] = cnt;
+        tables.leading_zero[i] = cnt;
     }
 
     for (const auto n : algo::range(golomb_n_count))
@@ -264,13 +270,18 @@ static void init_table()
         for (const auto i : algo::range(9))
         {
             for (const auto j : algo::range(golomb_compression_table[n][i]))
-                golomb_bit_size_table[a++][n] = i;
+                tables.golomb_bit_size[a++][n] = i;
         }
     }
+    return tables;
 }
 
+static const algo::Lazy<LookupTables> lookup_tables(create_lookup_tables);
+
 static void decode_golomb_values(u8 *pixel_buf, int pixel_count, u8 *bit_pool)
 {
+    const auto &leading_zero_table = lookup_tables->leading_zero;
+    const auto &golomb_bit_size_table = lookup_tables->golomb_bit_size;
     int n = golomb_n_count - 1;
     int a = 0;
 
@@ -391,30 +402,32 @@ static void decode_line(
     res::Pixel *current_line,
     int start_block,
     int block_limit,
-    u8 *filter_types,
+    const u8 *filter_types,
     int skip_block_bytes,
     u32 *in,
     int odd_skip,
     int dir,
     const Header &header)
 {
-    res::Pixel left, top_left;
+    // left, top_left and the filter results are kept packed so that the
+    // predictors work on all four channels at once.
+    u32 left, top_left;
     int step;
 
     if (start_block)
     {
         prev_line += start_block * w_block_size;
         current_line += start_block * w_block_size;
-        left = current_line[-1];
-        top_left = prev_line[-1];
+        left = to_bgra(current_line[-1]);
+        top_left = to_bgra(prev_line[-1]);
     }
     else
     {
-        left.r = left.g = left.b = 0;
-        top_left.r = top_left.g = top_left.b = 0;
-        left.a = top_left.a = header.channel_count == 3 ? 0xFF : 0;
+        left = top_left = header.channel_count == 3 ? 0xFF000000 : 0;
     }
 
+    const u32 alpha_mask = header.channel_count == 3 ? 0xFF000000 : 0;
+
     in += skip_block_bytes * start_block;
     step = (dir & 1) ? 1 : -1;
 
@@ -443,21 +456,15 @@ static void decode_line(
             inn.b = *in;
             transformer(inn);
 
-            res::Pixel top = *prev_line;
-            auto result = filter(
-                to_bgra(left),
-                to_bgra(top),
-                to_bgra(top_left),
-                to_bgra(inn));
-            left.a = result >> 24;
-            left.r = result >> 16;
-            left.g = result >> 8;
-            left.b = result;
-            if (header.channel_count == 3)
-                left.a = 0xFF;
-
+            const u32 top = to_bgra(*prev_line);
+            left = filter(left, top, top_left, to_bgra(inn)) | alpha_mask;
             top_left = top;
-            *current_line++ = left;
+
+            current_line->b = left;
+            current_line->g = left >> 8;
+            current_line->r = left >> 16;
+            current_line->a = left >> 24;
+            current_line++;
 
             prev_line++;
             in += step;
@@ -470,105 +477,149 @@ static void decode_line(
     }
 }
 
+static res::Pixel *decode_line_group(
+    res::Image &image,
+    res::Pixel *prev_line,
+    u32 *group_buf,
+    const FilterTypes &filter_types,
+    const size_t y,
+    const Header &header)
+{
+    u32 ylim = y + h_block_size;
+    if (ylim >= header.image_height)
+        ylim = header.image_height;
+
+    u32 main_count = header.image_width / w_block_size;
+    const u8 *ft = filter_types.data.get<u8>()
+        + (y / h_block_size) * header.x_block_count;
+    int skip_bytes = (ylim - y) * w_block_size;
+
+    for (const auto yy : algo::range(y, ylim))
+    {
+        auto *current_line = &image.at(0, yy);
+
+        int dir = (yy & 1) ^ 1;
+        int odd_skip = ((ylim - yy -1) - (yy - y));
+
+        if (main_count)
+        {
+            int start = ((header.image_width < w_block_size)
+                ? header.image_width
+                : w_block_size) * (yy - y);
+
+            decode_line(
+                prev_line,
+                current_line,
+                0,
+                main_count,
+                ft,
+                skip_bytes,
+                group_buf + start,
+                odd_skip,
+                dir,
+                header);
+        }
+
+        if (main_count != header.x_block_count)
+        {
+            int ww = header.image_width - main_count * w_block_size;
+            if (ww > w_block_size)
+                ww = w_block_size;
+
+            int start = ww * (yy - y);
+            decode_line(
+                prev_line,
+                current_line,
+                main_count,
+                header.x_block_count,
+                ft,
+                skip_bytes,
+                group_buf + start,
+                odd_skip,
+                dir,
+                header);
+        }
+
+        prev_line = current_line;
+    }
+    return prev_line;
+}
+
 static void read_image(
     io::BaseByteStream &input_stream, res::Image &image, const Header &header)
 {
     FilterTypes filter_types(input_stream);
     filter_types.decompress(header);
 
-    bstr pixel_buf(4 * header.image_width * h_block_size);
+    // Every line group stores a separate bit pool for each channel, so they
+    // can be entropy-decoded independently of each other. Only the
+    // reconstruction, which depends on the previous line, has to run
+    // sequentially. The groups are processed in windows of a couple of
+    // groups per thread so that the memory doesn't grow with the image.
+    const int window_size
+        = 2 * std::max<int>(std::thread::hardware_concurrency(), 1);
+    std::vector<bstr> bit_pools(window_size * header.channel_count);
+    bstr pixel_buf(4 * header.image_width * h_block_size * window_size);
+
     auto zero_line = std::make_unique<res::Pixel[]>(header.image_width);
     res::Pixel *prev_line = zero_line.get();
 
-    u32 main_count = header.image_width / w_block_size;
-    for (const auto y : algo::range(0, header.image_height, h_block_size))
+    for (const auto window_y
+        : algo::range(0, header.y_block_count, window_size))
     {
-        u32 ylim = y + h_block_size;
-        if (ylim >= header.image_height)
-            ylim = header.image_height;
+        const int group_count = std::min<int>(
+            window_size, header.y_block_count - window_y);
 
-        int pixel_count = (ylim - y) * header.image_width;
-        for (const auto c : algo::range(header.channel_count))
+        for (const auto i : algo::range(group_count * header.channel_count))
         {
             u32 bit_size = input_stream.read_le<u32>();
 
             int method = (bit_size >> 30) & 3;
             bit_size &= 0x3FFFFFFF;
-
-            int byte_size = (bit_size + 7) / 8;
-            bstr bit_pool = input_stream.read(byte_size);
-
-            // Although decode_golomb_values accesses only valid bits, it uses
-            // reinterpret_cast<u32*>() that might access bits out of bounds.
-            // This is to make sure those calls don't cause access violation.
-            bit_pool.resize(byte_size + 4);
-
             if (method != 0)
                 throw err::NotSupportedError("Unsupported encoding method");
 
-            decode_golomb_values(
-                pixel_buf.get<u8>() + c, pixel_count, bit_pool.get<u8>());
-        }
+            int byte_size = (bit_size + 7) / 8;
+            bit_pools[i] = input_stream.read(byte_size);
 
-        u8 *ft = filter_types.data.get<u8>()
-            + (y / h_block_size) * header.x_block_count;
-        int skip_bytes = (ylim - y) * w_block_size;
+            // Although decode_golomb_values accesses only valid bits, it
+            // uses reinterpret_cast<u32*>() that might access bits out of
+            // bounds. This is to make sure those calls don't cause access
+            // violation.
+            bit_pools[i].resize(byte_size + 4);
+        }
 
-        for (const auto yy : algo::range(y, ylim))
+        algo::parallel_for(group_count, [&](const size_t i)
         {
-            auto *current_line = &image.at(0, yy);
-
-            int dir = (yy & 1) ^ 1;
-            int odd_skip = ((ylim - yy -1) - (yy - y));
-
-            if (main_count)
+            const auto y = (window_y + i) * h_block_size;
+            const auto ylim = std::min<size_t>(
+                y + h_block_size, header.image_height);
+            const int pixel_count = (ylim - y) * header.image_width;
+            for (const auto c : algo::range(header.channel_count))
             {
-                int start = ((header.image_width < w_block_size)
-                    ? header.image_width
-                    : w_block_size) * (yy - y);
-
-                decode_line(
-                    prev_line,
-                    current_line,
-                    0,
-                    main_count,
-                    ft,
-                    skip_bytes,
-                    pixel_buf.get<u32>() + start,
-                    odd_skip,
-                    dir,
-                    header);
+                decode_golomb_values(
+                    pixel_buf.get<u8>()
+                        + 4 * i * h_block_size * header.image_width + c,
+                    pixel_count,
+                    bit_pools[i * header.channel_count + c].get<u8>());
             }
+        });
 
-            if (main_count != header.x_block_count)
-            {
-                int ww = header.image_width - main_count * w_block_size;
-                if (ww > w_block_size)
-                    ww = w_block_size;
-
-                int start = ww * (yy - y);
-                decode_line(
-                    prev_line,
-                    current_line,
-                    main_count,
-                    header.x_block_count,
-                    ft,
-                    skip_bytes,
-                    pixel_buf.get<u32>() + start,
-                    odd_skip,
-                    dir,
-                    header);
-            }
-
-            prev_line = current_line;
+        for (const auto i : algo::range(group_count))
+        {
+            prev_line = decode_line_group(
+                image,
+                prev_line,
+                pixel_buf.get<u32>() + i * h_block_size * header.image_width,
+                filter_types,
+                (window_y + i) * h_block_size,
+                header);
         }
     }
 }
 
 res::Image Tlg6Decoder::decode(io::File &file)
 {
-    init_table();
-
     Header header;
     header.channel_count = file.stream.read<u8>();
     header.data_flags = file.stream.read<u8>();
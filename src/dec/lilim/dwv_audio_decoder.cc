@@ -45,8 +45,8 @@ res::Audio DwvAudioDecoder::decode_impl(
     audio.codec = header_stream.read_le<u16>();
     audio.channel_count = header_stream.read_le<u16>();
     audio.sample_rate = header_stream.read_le<u32>();
-    const auto byte_rate = header_stream.read_le<u32>();
-    const auto block_align = header_stream.read_le<u16>();
+    audio.byte_rate = header_stream.read_le<u32>();
+    audio.block_align = header_stream.read_le<u16>();
     audio.bits_per_sample = header_stream.read_le<u16>();
     if (header_stream.left())
     {
@@ -38,6 +38,27 @@ namespace
         Texture3D  = 4,
     };
 
+    enum class DxgiFormat : u32
+    {
+        BC1Typeless     = 70,
+        BC1Unorm        = 71,
+        BC1UnormSrgb    = 72,
+        BC2Typeless     = 73,
+        BC2Unorm        = 74,
+        BC2UnormSrgb    = 75,
+        BC3Typeless     = 76,
+        BC3Unorm        = 77,
+        BC3UnormSrgb    = 78,
+        BC4Typeless     = 79,
+        BC4Unorm        = 80,
+        BC5Typeless     = 82,
+        BC5Unorm        = 83,
+        B8G8R8A8Unorm   = 87,
+        BC7Typeless     = 97,
+        BC7Unorm        = 98,
+        BC7UnormSrgb    = 99,
+    };
+
     enum DdsPixelFormatFlags
     {
         DDPF_ALPHAPIXELS = 0x1,
@@ -62,7 +83,7 @@ namespace
 
     struct DdsHeaderDx10 final
     {
-        u32 dxgi_format;
+        DxgiFormat dxgi_format;
         D3d10ResourceDimension resource_dimension;
         u32 misc_flag;
         u32 array_size;
@@ -102,6 +123,10 @@ static const bstr magic_dxt3 = "DXT3"_b;
 static const bstr magic_dxt4 = "DXT4"_b;
 static const bstr magic_dxt5 = "DXT5"_b;
 static const bstr magic_dx10 = "DX10"_b;
+static const bstr magic_ati1 = "ATI1"_b;
+static const bstr magic_ati2 = "ATI2"_b;
+static const bstr magic_bc4u = "BC4U"_b;
+static const bstr magic_bc5u = "BC5U"_b;
 
 static void fill_pixel_format(
     io::BaseByteStream &input_stream, DdsPixelFormat &pixel_format)
@@ -139,7 +164,8 @@ static std::unique_ptr<DdsHeaderDx10> read_header_dx10(
     io::BaseByteStream &input_stream)
 {
     auto header = std::make_unique<DdsHeaderDx10>();
-    header->dxgi_format = input_stream.read_le<u32>();
+    header->dxgi_format
+        = static_cast<DxgiFormat>(input_stream.read_le<u32>());
     header->resource_dimension
         = static_cast<D3d10ResourceDimension>(input_stream.read_le<u32>());
     header->misc_flag = input_stream.read_le<u32>();
@@ -148,6 +174,52 @@ static std::unique_ptr<DdsHeaderDx10> read_header_dx10(
     return header;
 }
 
+static std::unique_ptr<res::Image> decode_dx10(
+    io::BaseByteStream &input_stream,
+    const DdsHeaderDx10 &header_dx10,
+    const size_t width,
+    const size_t height)
+{
+    switch (header_dx10.dxgi_format)
+    {
+        case DxgiFormat::BC1Typeless:
+        case DxgiFormat::BC1Unorm:
+        case DxgiFormat::BC1UnormSrgb:
+            return decode_dxt1(input_stream, width, height);
+
+        case DxgiFormat::BC2Typeless:
+        case DxgiFormat::BC2Unorm:
+        case DxgiFormat::BC2UnormSrgb:
+            return decode_dxt3(input_stream, width, height);
+
+        case DxgiFormat::BC3Typeless:
+        case DxgiFormat::BC3Unorm:
+        case DxgiFormat::BC3UnormSrgb:
+            return decode_dxt5(input_stream, width, height);
+
+        case DxgiFormat::BC4Typeless:
+        case DxgiFormat::BC4Unorm:
+            return decode_bc4(input_stream, width, height);
+
+        case DxgiFormat::BC5Typeless:
+        case DxgiFormat::BC5Unorm:
+            return decode_bc5(input_stream, width, height);
+
+        case DxgiFormat::BC7Typeless:
+        case DxgiFormat::BC7Unorm:
+        case DxgiFormat::BC7UnormSrgb:
+            return decode_bc7(input_stream, width, height);
+
+        case DxgiFormat::B8G8R8A8Unorm:
+            return std::make_unique<res::Image>(
+                width, height, input_stream, res::PixelFormat::BGRA8888);
+    }
+
+    throw err::NotSupportedError(algo::format(
+        "DXGI format %d is not supported",
+        static_cast<int>(header_dx10.dxgi_format)));
+}
+
 bool DdsImageDecoder::is_recognized_impl(io::File &input_file) const
 {
     return input_file.stream.read(magic.size()) == magic;
@@ -159,26 +231,35 @@ res::Image DdsImageDecoder::decode_impl(
     input_file.stream.skip(magic.size());
 
     auto header = read_header(input_file.stream);
+    std::unique_ptr<DdsHeaderDx10> header_dx10;
     if (header->pixel_format.four_cc == magic_dx10)
-        read_header_dx10(input_file.stream);
+        header_dx10 = read_header_dx10(input_file.stream);
 
     const auto width = header->width;
     const auto height = header->height;
 
     std::unique_ptr<res::Image> image(nullptr);
-    if (header->pixel_format.flags & DDPF_FOURCC)
+    if (header_dx10)
+    {
+        image = decode_dx10(input_file.stream, *header_dx10, width, height);
+    }
+    else if (header->pixel_format.flags & DDPF_FOURCC)
     {
-        if (header->pixel_format.four_cc == magic_dxt1)
+        const auto &four_cc = header->pixel_format.four_cc;
+        if (four_cc == magic_dxt1)
             image = decode_dxt1(input_file.stream, width, height);
-        else if (header->pixel_format.four_cc == magic_dxt3)
+        else if (four_cc == magic_dxt3)
             image = decode_dxt3(input_file.stream, width, height);
-        else if (header->pixel_format.four_cc == magic_dxt5)
+        else if (four_cc == magic_dxt5)
             image = decode_dxt5(input_file.stream, width, height);
+        else if (four_cc == magic_ati1 || four_cc == magic_bc4u)
+            image = decode_bc4(input_file.stream, width, height);
+        else if (four_cc == magic_ati2 || four_cc == magic_bc5u)
+            image = decode_bc5(input_file.stream, width, height);
         else
         {
             throw err::NotSupportedError(algo::format(
-                "%s textures are not supported",
-                header->pixel_format.four_cc.c_str()));
+                "%s textures are not supported", four_cc.c_str()));
         }
     }
     else if (header->pixel_format.flags & DDPF_RGB)
@@ -16,24 +16,224 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/microsoft/dxt/dxt_decoders.h"
+#include <algorithm>
+#include "algo/parallel.h"
 #include "algo/range.h"
 
 using namespace au;
 
+namespace
+{
+    using BlockDecoder = void (*)(
+        const u8 *input, res::Pixel *output, const size_t stride);
+
+    struct Bc7ModeInfo final
+    {
+        size_t subset_count;
+        size_t partition_bits;
+        size_t rotation_bits;
+        size_t index_selection_bits;
+        size_t color_bits;
+        size_t alpha_bits;
+        size_t endpoint_pbits;
+        size_t shared_pbits;
+        size_t index_bits;
+        size_t index2_bits;
+    };
+
+    class Bc7BitReader final
+    {
+    public:
+        Bc7BitReader(const u8 *input);
+        u32 read(const size_t bits);
+
+    private:
+        u64 low, high;
+    };
+}
+
+static const Bc7ModeInfo bc7_modes[8] =
+{
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+    {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+    {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+    {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+static const u8 bc7_weights2[4] = {0, 21, 43, 64};
+static const u8 bc7_weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static const u8 bc7_weights4[16] =
+    {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// Bit masks of the pixels that belong to the second subset
+static const u16 bc7_partitions2[64] =
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+static const u8 bc7_partitions3[64][16] =
+{
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+    {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+    {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+    {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+    {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+    {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+    {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+    {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+    {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+    {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+    {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+    {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+static const u8 bc7_anchors2[64] =
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+static const u8 bc7_anchors3a[64] =
+{
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+static const u8 bc7_anchors3b[64] =
+{
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+Bc7BitReader::Bc7BitReader(const u8 *input) : low(0), high(0)
+{
+    for (const auto i : algo::range(8))
+    {
+        low |= static_cast<u64>(input[i]) << (i << 3);
+        high |= static_cast<u64>(input[8 + i]) << (i << 3);
+    }
+}
+
+u32 Bc7BitReader::read(const size_t bits)
+{
+    if (!bits)
+        return 0;
+    const u32 ret = low & ((1ull << bits) - 1);
+    low = (low >> bits) | (high << (64 - bits));
+    high >>= bits;
+    return ret;
+}
+
 static std::unique_ptr<res::Image> create_image(
     const size_t width, const size_t height)
 {
     return std::make_unique<res::Image>((width + 3) & ~3, (height + 3) & ~3);
 }
 
+// Reads all the blocks in one go, then decodes them straight into the target
+// image, one row of blocks per parallel_for iteration.
+static std::unique_ptr<res::Image> decode_blocks(
+    io::BaseByteStream &input_stream,
+    const size_t width,
+    const size_t height,
+    const size_t block_size,
+    const BlockDecoder decode_block)
+{
+    auto image = create_image(width, height);
+    const auto block_count_x = image->width() / 4;
+    const auto block_count_y = image->height() / 4;
+    const auto input = input_stream.read(
+        block_count_x * block_count_y * block_size);
+    algo::parallel_for(block_count_y, [&](const size_t block_y)
+    {
+        const auto *input_ptr
+            = input.get<const u8>() + block_y * block_count_x * block_size;
+        auto *output_ptr = &image->at(0, block_y * 4);
+        for (const auto block_x : algo::range(block_count_x))
+        {
+            decode_block(input_ptr, output_ptr, image->width());
+            input_ptr += block_size;
+            output_ptr += 4;
+        }
+    });
+    return image;
+}
+
 static void decode_dxt1_block(
-    io::BaseByteStream &input_stream, res::Pixel output_colors[4][4])
+    const u8 *input, res::Pixel *output, const size_t stride)
 {
     res::Pixel colors[4];
-    const auto tmp = input_stream.read(4);
-    const auto *tmp_ptr = tmp.get<const u8>();
-    colors[0] = res::read_pixel<res::PixelFormat::BGR565>(tmp_ptr);
-    colors[1] = res::read_pixel<res::PixelFormat::BGR565>(tmp_ptr);
+    colors[0] = res::read_pixel<res::PixelFormat::BGR565>(input);
+    colors[1] = res::read_pixel<res::PixelFormat::BGR565>(input);
     const auto transparent
         = colors[0].b <= colors[1].b
         && colors[0].g <= colors[1].g
@@ -54,115 +254,291 @@ static void decode_dxt1_block(
         }
     }
 
-    auto lookup = input_stream.read_le<u32>();
+    u32 lookup = input[0] | (input[1] << 8) | (input[2] << 16)
+        | (input[3] << 24);
     for (const auto y : algo::range(4))
-    for (const auto x : algo::range(4))
     {
-        const auto index = lookup & 3;
-        output_colors[y][x] = colors[index];
-        lookup >>= 2;
+        for (const auto x : algo::range(4))
+        {
+            output[x] = colors[lookup & 3];
+            lookup >>= 2;
+        }
+        output += stride;
     }
 }
 
-static void decode_dxt5_block(
-    io::BaseByteStream &input_stream, u8 output_alpha[4][4])
+// Decodes the interpolated 8-bit channel used by DXT5 alpha and BC4/BC5.
+static void decode_dxt5_channel(
+    const u8 *input, res::Pixel *output, const size_t stride, const size_t c)
 {
-    u8 alpha[8];
-    alpha[0] = input_stream.read<u8>();
-    alpha[1] = input_stream.read<u8>();
+    u8 values[8];
+    values[0] = input[0];
+    values[1] = input[1];
 
-    if (alpha[0] > alpha[1])
+    if (values[0] > values[1])
     {
         for (const auto i : algo::range(2, 8))
-            alpha[i] = ((8. - i) * alpha[0] + ((i - 1.) * alpha[1])) / 7.;
+            values[i] = ((8 - i) * values[0] + (i - 1) * values[1]) / 7;
     }
     else
     {
         for (const auto i : algo::range(2, 6))
-            alpha[i] = ((6. - i) * alpha[0] + ((i - 1.) * alpha[1])) / 5.;
-        alpha[6] = 0;
-        alpha[7] = 255;
+            values[i] = ((6 - i) * values[0] + (i - 1) * values[1]) / 5;
+        values[6] = 0;
+        values[7] = 255;
     }
 
-    for (const auto i : algo::range(2))
+    u64 lookup = 0;
+    for (const auto i : algo::range(6))
+        lookup |= static_cast<u64>(input[2 + i]) << (i << 3);
+    for (const auto y : algo::range(4))
     {
-        u32 lookup = input_stream.read<u8>();
-        lookup |= input_stream.read<u8>() << 8;
-        lookup |= input_stream.read<u8>() << 16;
-        for (const auto j : algo::range(8))
+        for (const auto x : algo::range(4))
         {
-            const auto index = lookup & 7;
-            const auto pos = i * 8 + j;
-            const auto x = pos % 4;
-            const auto y = pos / 4;
+            output[x][c] = values[lookup & 7];
             lookup >>= 3;
-            output_alpha[y][x] = alpha[index];
         }
+        output += stride;
     }
 }
 
-std::unique_ptr<res::Image> dec::microsoft::dxt::decode_dxt1(
-    io::BaseByteStream &input_stream, size_t width, size_t height)
+static void decode_dxt3_block(
+    const u8 *input, res::Pixel *output, const size_t stride)
 {
-    auto image = create_image(width, height);
-    for (const auto block_y : algo::range(0, height, 4))
-    for (const auto block_x : algo::range(0, width, 4))
+    decode_dxt1_block(input + 8, output, stride);
+    for (const auto y : algo::range(4))
     {
-        res::Pixel colors[4][4];
-        decode_dxt1_block(input_stream, colors);
-        for (const auto y : algo::range(4))
-        for (const auto x : algo::range(4))
-            image->at(block_x + x, block_y + y) = colors[y][x];
+        for (const auto x : algo::range(0, 4, 2))
+        {
+            const auto b = *input++;
+            output[x + 0].a = b & 0xF0;
+            output[x + 1].a = (b & 0x0F) << 4;
+        }
+        output += stride;
     }
-    return image;
 }
 
-std::unique_ptr<res::Image> dec::microsoft::dxt::decode_dxt3(
-    io::BaseByteStream &input_stream, size_t width, size_t height)
+static void decode_dxt5_block(
+    const u8 *input, res::Pixel *output, const size_t stride)
 {
-    auto image = create_image(width, height);
-    for (const auto block_y : algo::range(0, height, 4))
-    for (const auto block_x : algo::range(0, width, 4))
+    decode_dxt1_block(input + 8, output, stride);
+    decode_dxt5_channel(input, output, stride, 3);
+}
+
+static void decode_bc4_block(
+    const u8 *input, res::Pixel *output, const size_t stride)
+{
+    decode_dxt5_channel(input, output, stride, 2);
+    for (const auto y : algo::range(4))
     {
-        u8 alpha[4][4];
-        for (const auto y : algo::range(4))
-        for (const auto x : algo::range(0, 4, 2))
+        for (const auto x : algo::range(4))
         {
-            const auto b = input_stream.read<u8>();
-            alpha[y][x + 0] = b & 0xF0;
-            alpha[y][x + 1] = (b & 0x0F) << 4;
+            output[x].b = output[x].g = output[x].r;
+            output[x].a = 0xFF;
         }
+        output += stride;
+    }
+}
 
-        res::Pixel colors[4][4];
-        decode_dxt1_block(input_stream, colors);
-        for (const auto y : algo::range(4))
+static void decode_bc5_block(
+    const u8 *input, res::Pixel *output, const size_t stride)
+{
+    decode_dxt5_channel(input, output, stride, 2);
+    decode_dxt5_channel(input + 8, output, stride, 1);
+    for (const auto y : algo::range(4))
+    {
         for (const auto x : algo::range(4))
         {
-            colors[y][x].a = alpha[y][x];
-            image->at(block_x + x, block_y + y) = colors[y][x];
+            output[x].b = 0;
+            output[x].a = 0xFF;
         }
+        output += stride;
     }
-    return image;
 }
 
-std::unique_ptr<res::Image> dec::microsoft::dxt::decode_dxt5(
-    io::BaseByteStream &input_stream, size_t width, size_t height)
+static const u8 *get_bc7_weights(const size_t index_bits)
 {
-    auto image = create_image(width, height);
-    for (const auto block_y : algo::range(0, height, 4))
-    for (const auto block_x : algo::range(0, width, 4))
-    {
-        u8 alpha[4][4];
-        decode_dxt5_block(input_stream, alpha);
+    if (index_bits == 2)
+        return bc7_weights2;
+    if (index_bits == 3)
+        return bc7_weights3;
+    return bc7_weights4;
+}
 
-        res::Pixel colors[4][4];
-        decode_dxt1_block(input_stream, colors);
+static void decode_bc7_block(
+    const u8 *input, res::Pixel *output, const size_t stride)
+{
+    size_t mode = 0;
+    while (mode < 8 && !(input[0] & (1 << mode)))
+        mode++;
+    if (mode == 8)
+    {
         for (const auto y : algo::range(4))
-        for (const auto x : algo::range(4))
         {
-            colors[y][x].a = alpha[y][x];
-            image->at(block_x + x, block_y + y) = colors[y][x];
+            for (const auto x : algo::range(4))
+                output[x] = {0, 0, 0, 0};
+            output += stride;
         }
+        return;
     }
-    return image;
+
+    const auto &info = bc7_modes[mode];
+    Bc7BitReader bit_reader(input);
+    bit_reader.read(mode + 1);
+    const auto partition = bit_reader.read(info.partition_bits);
+    const auto rotation = bit_reader.read(info.rotation_bits);
+    const auto index_selection = bit_reader.read(info.index_selection_bits);
+
+    // endpoints[subset * 2 + endpoint] in R, G, B, A order
+    u8 endpoints[6][4];
+    for (const auto c : algo::range(3))
+    for (const auto i : algo::range(info.subset_count * 2))
+        endpoints[i][c] = bit_reader.read(info.color_bits);
+    for (const auto i : algo::range(info.subset_count * 2))
+        endpoints[i][3] = bit_reader.read(info.alpha_bits);
+
+    auto color_bits = info.color_bits;
+    auto alpha_bits = info.alpha_bits;
+    if (info.endpoint_pbits || info.shared_pbits)
+    {
+        u8 pbits[6];
+        if (info.endpoint_pbits)
+        {
+            for (const auto i : algo::range(info.subset_count * 2))
+                pbits[i] = bit_reader.read(1);
+        }
+        else
+        {
+            for (const auto i : algo::range(info.subset_count))
+                pbits[i * 2] = pbits[i * 2 + 1] = bit_reader.read(1);
+        }
+        for (const auto i : algo::range(info.subset_count * 2))
+        for (const auto c : algo::range(4))
+            endpoints[i][c] = (endpoints[i][c] << 1) | pbits[i];
+        color_bits++;
+        if (alpha_bits)
+            alpha_bits++;
+    }
+
+    for (const auto i : algo::range(info.subset_count * 2))
+    {
+        for (const auto c : algo::range(3))
+        {
+            endpoints[i][c] <<= 8 - color_bits;
+            endpoints[i][c] |= endpoints[i][c] >> color_bits;
+        }
+        if (alpha_bits)
+        {
+            endpoints[i][3] <<= 8 - alpha_bits;
+            endpoints[i][3] |= endpoints[i][3] >> alpha_bits;
+        }
+        else
+            endpoints[i][3] = 0xFF;
+    }
+
+    u8 subsets[16];
+    size_t anchors[3] = {0, 0, 0};
+    for (const auto i : algo::range(16))
+    {
+        if (info.subset_count == 2)
+            subsets[i] = (bc7_partitions2[partition] >> i) & 1;
+        else if (info.subset_count == 3)
+            subsets[i] = bc7_partitions3[partition][i];
+        else
+            subsets[i] = 0;
+    }
+    if (info.subset_count == 2)
+        anchors[1] = bc7_anchors2[partition];
+    else if (info.subset_count == 3)
+    {
+        anchors[1] = bc7_anchors3a[partition];
+        anchors[2] = bc7_anchors3b[partition];
+    }
+
+    // Anchor indices have their most significant bit implicitly set to 0.
+    u8 indices[16];
+    for (const auto i : algo::range(16))
+    {
+        const auto is_anchor = anchors[subsets[i]] == static_cast<size_t>(i);
+        indices[i] = bit_reader.read(info.index_bits - is_anchor);
+    }
+    u8 indices2[16];
+    for (const auto i : algo::range(16))
+    {
+        if (info.index2_bits)
+            indices2[i] = bit_reader.read(info.index2_bits - !i);
+        else
+            indices2[i] = indices[i];
+    }
+
+    auto color_indices = indices;
+    auto alpha_indices = indices2;
+    auto color_weights = get_bc7_weights(info.index_bits);
+    auto alpha_weights = get_bc7_weights(
+        info.index2_bits ? info.index2_bits : info.index_bits);
+    if (index_selection)
+    {
+        std::swap(color_indices, alpha_indices);
+        std::swap(color_weights, alpha_weights);
+    }
+
+    for (const auto i : algo::range(16))
+    {
+        const auto &e0 = endpoints[subsets[i] * 2];
+        const auto &e1 = endpoints[subsets[i] * 2 + 1];
+        const auto color_weight = color_weights[color_indices[i]];
+        const auto alpha_weight = alpha_weights[alpha_indices[i]];
+        u8 rgba[4];
+        for (const auto c : algo::range(3))
+        {
+            rgba[c] = ((64 - color_weight) * e0[c]
+                + color_weight * e1[c] + 32) >> 6;
+        }
+        rgba[3] = ((64 - alpha_weight) * e0[3] + alpha_weight * e1[3] + 32)
+            >> 6;
+        if (rotation)
+            std::swap(rgba[rotation - 1], rgba[3]);
+
+        auto &pixel = output[(i >> 2) * stride + (i & 3)];
+        pixel.r = rgba[0];
+        pixel.g = rgba[1];
+        pixel.b = rgba[2];
+        pixel.a = rgba[3];
+    }
+}
+
+std::unique_ptr<res::Image> dec::microsoft::dxt::decode_dxt1(
+    io::BaseByteStream &input_stream, size_t width, size_t height)
+{
+    return decode_blocks(input_stream, width, height, 8, decode_dxt1_block);
+}
+
+std::unique_ptr<res::Image> dec::microsoft::dxt::decode_dxt3(
+    io::BaseByteStream &input_stream, size_t width, size_t height)
+{
+    return decode_blocks(input_stream, width, height, 16, decode_dxt3_block);
+}
+
+std::unique_ptr<res::Image> dec::microsoft::dxt::decode_dxt5(
+    io::BaseByteStream &input_stream, size_t width, size_t height)
+{
+    return decode_blocks(input_stream, width, height, 16, decode_dxt5_block);
+}
+
+std::unique_ptr<res::Image> dec::microsoft::dxt::decode_bc4(
+    io::BaseByteStream &input_stream, size_t width, size_t height)
+{
+    return decode_blocks(input_stream, width, height, 8, decode_bc4_block);
+}
+
+std::unique_ptr<res::Image> dec::microsoft::dxt::decode_bc5(
+    io::BaseByteStream &input_stream, size_t width, size_t height)
+{
+    return decode_blocks(input_stream, width, height, 16, decode_bc5_block);
+}
+
+std::unique_ptr<res::Image> dec::microsoft::dxt::decode_bc7(
+    io::BaseByteStream &input_stream, size_t width, size_t height)
+{
+    return decode_blocks(input_stream, width, height, 16, decode_bc7_block);
 }
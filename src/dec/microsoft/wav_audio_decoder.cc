@@ -50,8 +50,8 @@ res::Audio WavAudioDecoder::decode_impl(
             audio.codec = input_file.stream.read_le<u16>();
             audio.channel_count = input_file.stream.read_le<u16>();
             audio.sample_rate = input_file.stream.read_le<u32>();
-            const auto byte_rate = input_file.stream.read_le<u32>();
-            const auto block_align = input_file.stream.read_le<u16>();
+            audio.byte_rate = input_file.stream.read_le<u32>();
+            audio.block_align = input_file.stream.read_le<u16>();
             audio.bits_per_sample = input_file.stream.read_le<u16>();
             const auto chunk_pos = input_file.stream.pos() - chunk_start;
             if (chunk_pos < chunk_size)
@@ -17,6 +17,7 @@
 
 #include "dec/purple_software/jbp1.h"
 #include <array>
+#include "algo/lazy.h"
 #include "algo/range.h"
 #include "err.h"
 #include "io/memory_byte_stream.h"
@@ -289,24 +290,26 @@ static void dct(
     }
 }
 
-static void ycc2rgb(u8 *dc, u8 *ac, short *iy, short *cbcr, const size_t stride)
+static std::array<u8, 0x300> create_clamp_table()
 {
-    static bool initialized = false;
-    static std::array<u8, 0x300> lookup_table;
+    std::array<u8, 0x300> clamp_table;
+    for (const auto n : algo::range(0x100))
+        clamp_table[n] = 0;
 
-    if (!initialized)
-    {
-        for (const auto n : algo::range(0x100))
-            lookup_table[n] = 0;
+    for (const auto n : algo::range(0x100))
+        clamp_table[n + 0x100] = n;
 
-        for (const auto n : algo::range(0x100))
-            lookup_table[n + 0x100] = n;
+    for (const auto n : algo::range(0x100))
+        clamp_table[n + 0x200] = 0xFF;
+    return clamp_table;
+}
 
-        for (const auto n : algo::range(0x100))
-            lookup_table[n + 0x200] = 0xFF;
+static const algo::Lazy<std::array<u8, 0x300>> clamp_table(
+    create_clamp_table);
 
-        initialized = true;
-    }
+static void ycc2rgb(u8 *dc, u8 *ac, short *iy, short *cbcr, const size_t stride)
+{
+    const auto &lookup_table = *clamp_table;
 
     for (const auto y : algo::range(4))
     {
@@ -16,14 +16,17 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/real_live/nwa_audio_decoder.h"
+#include <algorithm>
+#include <thread>
+#include "algo/parallel.h"
 #include "algo/range.h"
 #include "err.h"
-#include "io/lsb_bit_stream.h"
-#include "io/memory_byte_stream.h"
 
 using namespace au;
 using namespace au::dec::real_live;
 
+static const size_t uncompressed_chunk_size = 0x100000;
+
 namespace
 {
     struct NwaHeader final
@@ -40,38 +43,68 @@ namespace
         size_t block_size;
         size_t rest_size;
     };
+
+    class NwaBitReader final
+    {
+    public:
+        NwaBitReader(const u8 *input, const u8 *input_end);
+        u32 read(const size_t bits);
+
+    private:
+        const u8 *input;
+        const u8 *input_end;
+        u64 buffer;
+        size_t bits_available;
+    };
+}
+
+NwaBitReader::NwaBitReader(const u8 *input, const u8 *input_end)
+    : input(input), input_end(input_end), buffer(0), bits_available(0)
+{
+}
+
+inline u32 NwaBitReader::read(const size_t bits)
+{
+    while (bits_available < bits)
+    {
+        if (input >= input_end)
+            throw err::EofError();
+        buffer |= static_cast<u64>(*input++) << bits_available;
+        bits_available += 8;
+    }
+    const auto value = buffer & ((1ull << bits) - 1);
+    buffer >>= bits;
+    bits_available -= bits;
+    return value;
 }
 
-static bstr decode_block(
+template<typename T> static void decode_block(
     const NwaHeader &header,
-    size_t current_block,
-    io::BaseByteStream &input_stream,
-    const std::vector<u32> &offsets)
+    const u8 *input,
+    const u8 *input_end,
+    T *output,
+    const size_t output_size)
 {
     const auto bytes_per_sample = header.bits_per_sample >> 3;
-    const auto current_block_size = current_block != header.block_count - 1
-        ? header.block_size * bytes_per_sample
-        : header.rest_size * bytes_per_sample;
-    const auto output_size = current_block_size / bytes_per_sample;
-    const auto input_size = current_block != offsets.size() - 1
-        ? offsets.at(current_block + 1) - offsets.at(current_block)
-        : input_stream.size() - offsets.at(current_block);
+    const auto input_size = static_cast<size_t>(input_end - input);
+    if (input_size < bytes_per_sample * header.channel_count)
+        throw err::EofError();
 
-    io::MemoryByteStream output_stream(output_size);
-
-    input_stream.seek(offsets.at(current_block));
     s16 d[2];
     for (const auto i : algo::range(header.channel_count))
     {
         if (header.bits_per_sample == 8)
-            d[i] = input_stream.read<u8>();
+        {
+            d[i] = *input++;
+        }
         else
-            d[i] = input_stream.read_le<u16>();
+        {
+            d[i] = input[0] | (input[1] << 8);
+            input += 2;
+        }
     }
 
-    const auto input = input_stream.read(
-        input_size - bytes_per_sample * header.channel_count);
-    io::LsbBitStream bit_stream(input);
+    NwaBitReader bit_reader(input, input_end);
 
     auto current_channel = 0;
     auto run_length = 0;
@@ -83,10 +116,10 @@ static bstr decode_block(
         }
         else
         {
-            int type = bit_stream.read(3);
+            int type = bit_reader.read(3);
             if (type == 7)
             {
-                if (bit_stream.read(1))
+                if (bit_reader.read(1))
                 {
                     d[current_channel] = 0;
                 }
@@ -100,7 +133,7 @@ static bstr decode_block(
                     }
                     const auto mask1 = (1 << (bits - 1));
                     const auto mask2 = (1 << (bits - 1)) - 1;
-                    const auto b = bit_stream.read(bits);
+                    const auto b = bit_reader.read(bits);
                     if (b & mask1)
                         d[current_channel] -= (b & mask2) << shift;
                     else
@@ -122,7 +155,7 @@ static bstr decode_block(
                 }
                 const auto mask1 = (1 << (bits - 1));
                 const auto mask2 = (1 << (bits - 1)) - 1;
-                const auto b = bit_stream.read(bits);
+                const auto b = bit_reader.read(bits);
                 if (b & mask1)
                     d[current_channel] -= (b & mask2) << shift;
                 else
@@ -130,30 +163,27 @@ static bstr decode_block(
             }
             else if (header.use_run_length)
             {
-                run_length = bit_stream.read(1);
+                run_length = bit_reader.read(1);
                 if (run_length == 1)
                 {
-                    run_length = bit_stream.read(2);
+                    run_length = bit_reader.read(2);
                     if (run_length == 3)
-                        run_length = bit_stream.read(8);
+                        run_length = bit_reader.read(8);
                 }
             }
         }
 
-        if (header.bits_per_sample == 8)
-            output_stream.write<u8>(d[current_channel]);
-        else
-            output_stream.write_le<u16>(d[current_channel]);
+        *output++ = static_cast<T>(d[current_channel]);
 
         if (header.channel_count == 2)
             current_channel ^= 1;
     }
-
-    return output_stream.seek(0).read_to_eof();
 }
 
-static bstr read_compressed_samples(
-    io::BaseByteStream &input_stream, const NwaHeader &header)
+static void read_compressed_samples(
+    io::BaseByteStream &input_stream,
+    const NwaHeader &header,
+    res::IAudioSink &sink)
 {
     if (header.compression_level < 0 || header.compression_level > 5)
         throw err::NotSupportedError("Unsupported compression level");
@@ -183,20 +213,81 @@ static bstr read_compressed_samples(
     }
 
     input_stream.skip(4);
-    std::vector<u32> offsets;
+    std::vector<uoff_t> offsets;
     for (const auto i : algo::range(header.block_count))
         offsets.push_back(input_stream.read_le<u32>());
-
-    bstr output;
+    offsets.push_back(input_stream.size());
     for (const auto i : algo::range(header.block_count))
-        output += decode_block(header, i, input_stream, offsets);
-    return output;
+    {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > offsets.back())
+            throw err::BadDataOffsetError();
+    }
+
+    // Every block starts with its own predictor values, so the blocks can be
+    // decoded independently into disjoint parts of the output. They're
+    // decoded in windows of a couple of blocks per thread so that the memory
+    // doesn't grow with the length of the track.
+    const int window_size
+        = 2 * std::max<int>(std::thread::hardware_concurrency(), 1);
+    const auto bytes_per_sample = header.bits_per_sample >> 3;
+    for (const auto window_start
+        : algo::range(0, header.block_count, window_size))
+    {
+        const auto window_end = std::min<size_t>(
+            window_start + window_size, header.block_count);
+        const auto input_offset = offsets[window_start];
+        const auto data = input_stream
+            .seek(input_offset)
+            .read(offsets[window_end] - input_offset);
+        const auto sample_count = window_end == header.block_count
+            ? (window_end - window_start - 1) * header.block_size
+                + header.rest_size
+            : (window_end - window_start) * header.block_size;
+        bstr output(sample_count * bytes_per_sample);
+        algo::parallel_for(window_end - window_start, [&](const size_t i)
+        {
+            const auto block = window_start + i;
+            const auto input_start = offsets[block] - input_offset;
+            const auto input_end = offsets[block + 1] - input_offset;
+            const auto output_size = block != header.block_count - 1
+                ? header.block_size
+                : header.rest_size;
+            const auto output_offset = i * header.block_size;
+            if (header.bits_per_sample == 8)
+            {
+                decode_block(
+                    header,
+                    data.get<u8>() + input_start,
+                    data.get<u8>() + input_end,
+                    output.get<u8>() + output_offset,
+                    output_size);
+            }
+            else
+            {
+                decode_block(
+                    header,
+                    data.get<u8>() + input_start,
+                    data.get<u8>() + input_end,
+                    output.get<s16>() + output_offset,
+                    output_size);
+            }
+        });
+        sink.write(output);
+    }
 }
 
-static bstr read_uncompressed_samples(
-    io::BaseByteStream &input_stream, const NwaHeader &header)
+static void read_uncompressed_samples(
+    io::BaseByteStream &input_stream,
+    const NwaHeader &header,
+    res::IAudioSink &sink)
 {
-    return input_stream.read(header.size_orig);
+    auto left = header.size_orig;
+    while (left)
+    {
+        const auto chunk_size = std::min(left, uncompressed_chunk_size);
+        sink.write(input_stream.read(chunk_size));
+        left -= chunk_size;
+    }
 }
 
 bool NwaAudioDecoder::is_recognized_impl(io::File &input_file) const
@@ -207,8 +298,13 @@ bool NwaAudioDecoder::is_recognized_impl(io::File &input_file) const
 res::Audio NwaAudioDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
 {
-    // buffer the file in memory for performance
-    io::MemoryByteStream input_stream(input_file.stream.seek(0).read_to_eof());
+    return collect_stream(logger, input_file);
+}
+
+void NwaAudioDecoder::decode_stream_impl(
+    const Logger &logger, io::File &input_file, res::IAudioSink &sink) const
+{
+    auto &input_stream = input_file.stream.seek(0);
 
     NwaHeader header;
     header.channel_count = input_stream.read_le<u16>();
@@ -223,16 +319,16 @@ res::Audio NwaAudioDecoder::decode_impl(
     header.block_size = input_stream.read_le<u32>();
     header.rest_size = input_stream.read_le<u32>();
 
-    const auto samples = header.compression_level == -1
-        ? read_uncompressed_samples(input_stream, header)
-        : read_compressed_samples(input_stream, header);
-
     res::Audio audio;
     audio.channel_count = header.channel_count;
     audio.bits_per_sample = header.bits_per_sample;
     audio.sample_rate = header.sample_rate;
-    audio.samples = samples;
-    return audio;
+    sink.begin(audio);
+    if (header.compression_level == -1)
+        read_uncompressed_samples(input_stream, header, sink);
+    else
+        read_compressed_samples(input_stream, header, sink);
+    sink.end();
 }
 
 static auto _ = dec::register_decoder<NwaAudioDecoder>("real-live/nwa");
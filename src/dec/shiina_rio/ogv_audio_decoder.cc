@@ -42,9 +42,9 @@ std::unique_ptr<io::File> OgvAudioDecoder::decode_impl(
     if (input_file.stream.read(4) != "data"_b)
         throw err::CorruptDataError("Expected data chunk");
     input_file.stream.skip(4);
-    const auto data = input_file.stream.read_to_eof();
 
-    auto output_file = std::make_unique<io::File>(input_file.path, data);
+    auto output_file = std::make_unique<io::File>(
+        input_file.path, input_file.stream.read_to_eof());
     output_file->guess_extension();
     return output_file;
 }
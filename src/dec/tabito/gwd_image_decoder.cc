@@ -16,6 +16,8 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/tabito/gwd_image_decoder.h"
+#include <array>
+#include "algo/lazy.h"
 #include "algo/ptr.h"
 #include "algo/range.h"
 #include "err.h"
@@ -25,7 +27,6 @@ using namespace au;
 using namespace au::dec::tabito;
 
 static const bstr magic = "GWD"_b;
-static u8 transform_table[256][256];
 
 bool GwdImageDecoder::is_recognized_impl(io::File &input_file) const
 {
@@ -41,8 +42,11 @@ namespace
     };
 }
 
-static void init_transform_table()
+using TransformTable = std::array<std::array<u8, 256>, 256>;
+
+static TransformTable create_transform_table()
 {
+    TransformTable transform_table;
     for (const auto i : algo::range(256))
     for (const auto j : algo::range(256))
     {
@@ -62,8 +66,12 @@ static void init_transform_table()
             ? 0xFF - result
             : result;
     }
+    return transform_table;
 }
 
+static const algo::Lazy<TransformTable> transform_table(
+    create_transform_table);
+
 static u32 read_gamma_bits(io::BaseBitStream &input_stream)
 {
     int num = 1;
@@ -98,8 +106,9 @@ static void decode_row(io::BaseBitStream &input_stream, bstr &output_row)
 
 static void transform_row(bstr &row)
 {
+    const auto &table = *transform_table;
     for (const auto i : algo::range(1, row.size()))
-        row[i] = transform_table[row[i]][row[i - 1]];
+        row[i] = table[row[i]][row[i - 1]];
 }
 
 static res::Image read_gwd_stream(io::BaseByteStream &input_stream)
@@ -112,8 +121,6 @@ static res::Image read_gwd_stream(io::BaseByteStream &input_stream)
     const auto height = input_stream.read_be<u16>();
     const auto depth = input_stream.read<u8>();
 
-    init_transform_table();
-
     bstr decoded_row(width);
     io::MsbBitStream bit_stream(input_stream);
 
@@ -16,62 +16,17 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/vorbis/packed_ogg_audio_decoder.h"
+#include <algorithm>
+#include <cstring>
+#include "algo/endian.h"
 #include "algo/range.h"
 #include "err.h"
-#include "io/memory_byte_stream.h"
 
 using namespace au;
 using namespace au::dec::vorbis;
 
-namespace
-{
-    struct OggPage final
-    {
-        u8 version;
-        u8 header_type;
-        bstr granule_position;
-        u32 bitstream_serial_number;
-        u32 page_sequence_number;
-        u32 checksum;
-        std::vector<bstr> segments;
-    };
-}
-
 static const bstr ogg_magic = "OggS"_b;
-
-static OggPage read_ogg_page(io::BaseByteStream &input_stream)
-{
-    OggPage page;
-    page.version = input_stream.read<u8>();
-    page.header_type = input_stream.read<u8>();
-    page.granule_position = input_stream.read(8);
-    page.bitstream_serial_number = input_stream.read_le<u32>();
-    page.page_sequence_number = input_stream.read_le<u32>();
-    page.checksum = input_stream.read_le<u32>();
-    std::vector<size_t> sizes(input_stream.read<u8>());
-    for (auto &size : sizes)
-        size = input_stream.read<u8>();
-    for (auto &size : sizes)
-        page.segments.push_back(input_stream.read(size));
-    return page;
-}
-
-static void write_ogg_page(
-    io::BaseByteStream &output_stream, const OggPage &page)
-{
-    output_stream.write(ogg_magic);
-    output_stream.write<u8>(page.version);
-    output_stream.write<u8>(page.header_type);
-    output_stream.write(page.granule_position);
-    output_stream.write_le<u32>(page.bitstream_serial_number);
-    output_stream.write_le<u32>(page.page_sequence_number);
-    output_stream.write_le<u32>(page.checksum);
-    output_stream.write<u8>(page.segments.size());
-    for (auto &page_segment : page.segments)
-        output_stream.write<u8>(page_segment.size());
-    for (auto &page_segment : page.segments)
-        output_stream.write(page_segment);
-}
+static const size_t ogg_page_header_size = 27;
 
 bool PackedOggAudioDecoder::is_recognized_impl(io::File &input_file) const
 {
@@ -83,10 +38,9 @@ bool PackedOggAudioDecoder::is_recognized_impl(io::File &input_file) const
     return input_file.stream.read(4) == ogg_magic;
 }
 
-static void rewrite_ogg_stream(
-    const Logger &logger,
-    io::BaseByteStream &input_stream,
-    io::BaseByteStream &output_stream)
+// Walks the pages in place and moves the ones that are kept towards the start
+// of the buffer. Returns the size of the rewritten stream.
+static size_t rewrite_ogg_stream(const Logger &logger, bstr &data)
 {
     // The OGG files used by LiarSoft may contain multiple streams, out of
     // which only the first one contains actual audio data.
@@ -94,37 +48,57 @@ static void rewrite_ogg_stream(
     u32 initial_serial_number = 0;
     auto pages = 0;
     auto serial_number_known = false;
-    while (input_stream.left())
+    const auto data_ptr = data.get<u8>();
+    size_t input_pos = 0;
+    size_t output_pos = 0;
+    while (input_pos < data.size())
     {
-        OggPage page;
-        try
+        const auto page_ptr = data_ptr + input_pos;
+        const auto left = data.size() - input_pos;
+        if (left >= ogg_magic.size()
+            && !std::equal(ogg_magic.begin(), ogg_magic.end(), page_ptr))
         {
-            if (input_stream.read(4) != ogg_magic)
-                throw err::CorruptDataError("Expected OGG signature");
+            throw err::CorruptDataError("Expected OGG signature");
+        }
 
-            page = read_ogg_page(input_stream);
+        auto page_size = ogg_page_header_size;
+        if (left >= page_size)
+        {
+            const auto segment_count = page_ptr[page_size - 1];
+            page_size += segment_count;
+            if (left >= page_size)
+            {
+                for (const auto i : algo::range(segment_count))
+                    page_size += page_ptr[ogg_page_header_size + i];
+            }
         }
-        catch (const err::IoError)
+        if (page_size > left)
         {
             logger.warn(
                 "Last OGG page is truncated; recovered %d pages.\n", pages);
             break;
         }
+        input_pos += page_size;
 
+        const auto serial_number = algo::from_little_endian<u32>(
+            *reinterpret_cast<const u32*>(page_ptr + 14));
         if (!serial_number_known)
         {
-            initial_serial_number = page.bitstream_serial_number;
+            initial_serial_number = serial_number;
             serial_number_known = true;
         }
 
         // The extra streams cause problems with popular (notably, all
         // ffmpeg-based) audio players, so we discard these streams here.
-        if (page.bitstream_serial_number == initial_serial_number)
+        if (serial_number == initial_serial_number)
         {
-            write_ogg_page(output_stream, page);
+            if (output_pos != input_pos - page_size)
+                std::memmove(data_ptr + output_pos, page_ptr, page_size);
+            output_pos += page_size;
             pages++;
         }
     }
+    return output_pos;
 }
 
 std::unique_ptr<io::File> PackedOggAudioDecoder::decode_impl(
@@ -146,11 +120,11 @@ std::unique_ptr<io::File> PackedOggAudioDecoder::decode_impl(
     if (input_file.stream.read(4) != "data"_b)
         throw err::CorruptDataError("Expected data chunk");
     const auto data_size = input_file.stream.read_le<u32>();
-    io::MemoryByteStream input(input_file.stream, data_size);
+    auto data = input_file.stream.read(data_size);
+    data.resize(rewrite_ogg_stream(logger, data));
 
-    auto output_file = std::make_unique<io::File>();
-    rewrite_ogg_stream(logger, input, output_file->stream);
-    output_file->path = input_file.path;
+    auto output_file
+        = std::make_unique<io::File>(input_file.path, std::move(data));
     output_file->guess_extension();
     return output_file;
 }
@@ -62,8 +62,8 @@ res::Audio WpnAudioDecoder::decode_impl(
     audio.codec = input_file.stream.read_le<u16>();
     audio.channel_count = input_file.stream.read_le<u16>();
     audio.sample_rate = input_file.stream.read_le<u32>();
-    const auto byte_rate = input_file.stream.read_le<u32>();
-    const auto block_align = input_file.stream.read_le<u16>();
+    audio.byte_rate = input_file.stream.read_le<u32>();
+    audio.block_align = input_file.stream.read_le<u16>();
     audio.bits_per_sample = input_file.stream.read_le<u16>();
     if (input_file.stream.pos() - fmt_chunk.offset < fmt_chunk.size)
     {
@@ -49,6 +49,8 @@ res::Audio WwaAudioDecoder::decode_impl(
     audio.channel_count = channel_count;
     audio.sample_rate = sample_rate;
     audio.bits_per_sample = bits_per_sample;
+    audio.block_align = block_align;
+    audio.byte_rate = byte_rate;
     audio.samples = samples;
     return audio;
 }
@@ -0,0 +1,44 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "io/file.h"
+#include "res/iaudio_sink.h"
+
+namespace au {
+namespace enc {
+namespace microsoft {
+
+    // Writes the WAV header upfront and fills in the chunk sizes once all
+    // the samples are written.
+    class WavAudioSink final : public res::IAudioSink
+    {
+    public:
+        WavAudioSink(io::File &output_file);
+
+        void begin(const res::Audio &audio) override;
+        void write(const bstr &samples) override;
+        void end() override;
+
+    private:
+        io::File &output_file;
+        std::vector<res::AudioLoopInfo> loops;
+        uoff_t data_offset;
+    };
+
+} } }
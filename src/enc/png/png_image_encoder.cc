@@ -17,6 +17,8 @@
 
 #include "enc/png/png_image_encoder.h"
 #include <png.h>
+#include <unordered_map>
+#include <vector>
 #include "algo/range.h"
 #include "err.h"
 #include "io/memory_byte_stream.h"
@@ -36,6 +38,44 @@ static void flush_handler(png_structp)
 {
 }
 
+static u32 pixel_to_u32(const res::Pixel &p)
+{
+    return p.b | (p.g << 8) | (p.r << 16) | (p.a << 24);
+}
+
+// Maps the pixels back to the palette the image was created with, so that
+// indexed images can be written as PLTE images rather than as RGBA. Returns
+// an empty bstr if any of the pixels has no corresponding palette entry.
+static bstr get_palette_indices(
+    const res::Image &input_image, const res::Palette &palette)
+{
+    if (!palette.size() || palette.size() > 256)
+        return ""_b;
+
+    std::unordered_map<u32, u8> color_to_index;
+    for (const auto i : algo::range(palette.size()))
+        color_to_index.emplace(pixel_to_u32(palette[i]), i);
+
+    bstr indices(input_image.width() * input_image.height());
+    auto indices_ptr = indices.get<u8>();
+    u32 last_color = pixel_to_u32(palette[0]);
+    u8 last_index = 0;
+    for (const auto &pixel : input_image)
+    {
+        const auto color = pixel_to_u32(pixel);
+        if (color != last_color)
+        {
+            const auto it = color_to_index.find(color);
+            if (it == color_to_index.end())
+                return ""_b;
+            last_color = color;
+            last_index = it->second;
+        }
+        *indices_ptr++ = last_index;
+    }
+    return indices;
+}
+
 void PngImageEncoder::encode_impl(
     const Logger &logger,
     const res::Image &input_image,
@@ -54,9 +94,15 @@ void PngImageEncoder::encode_impl(
     const auto height = input_image.height();
     if (!width || !height)
         throw err::BadDataSizeError();
-    const auto bpp = 4;
-    const auto color_type = PNG_COLOR_TYPE_RGBA;
-    int transformations = PNG_TRANSFORM_BGR;
+    const auto palette = input_image.palette();
+    const auto indices = palette
+        ? get_palette_indices(input_image, *palette)
+        : ""_b;
+    const auto indexed = !indices.empty();
+    const auto color_type = indexed
+        ? PNG_COLOR_TYPE_PALETTE
+        : PNG_COLOR_TYPE_RGBA;
+    int transformations = indexed ? PNG_TRANSFORM_IDENTITY : PNG_TRANSFORM_BGR;
 
     png_set_IHDR(
         png_ptr, info_ptr, width, height, 8, color_type,
@@ -64,6 +110,22 @@ void PngImageEncoder::encode_impl(
         PNG_COMPRESSION_TYPE_BASE,
         PNG_FILTER_TYPE_BASE);
 
+    std::vector<png_color> plte;
+    std::vector<png_byte> trns;
+    if (indexed)
+    {
+        for (const auto &color : *palette)
+        {
+            plte.push_back({color.r, color.g, color.b});
+            trns.push_back(color.a);
+        }
+        while (!trns.empty() && trns.back() == 0xFF)
+            trns.pop_back();
+        png_set_PLTE(png_ptr, info_ptr, plte.data(), plte.size());
+        if (!trns.empty())
+            png_set_tRNS(png_ptr, info_ptr, trns.data(), trns.size(), nullptr);
+    }
+
     // 0 = no compression, 9 = max compression
     // 1 produces good file size and is still fast.
     png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
@@ -71,11 +133,14 @@ void PngImageEncoder::encode_impl(
 
     png_set_write_fn(
         png_ptr, &output_file.stream, &write_handler, &flush_handler);
-    png_write_info(png_ptr, info_ptr);
 
     auto rows = std::make_unique<const u8*[]>(height);
     for (const auto y : algo::range(height))
-        rows.get()[y] = reinterpret_cast<const u8*>(&input_image.at(0, y));
+    {
+        rows.get()[y] = indexed
+            ? indices.get<const u8>() + y * width
+            : reinterpret_cast<const u8*>(&input_image.at(0, y));
+    }
     png_set_rows(png_ptr, info_ptr, const_cast<u8**>(rows.get()));
     png_write_png(png_ptr, info_ptr, transformations, nullptr);
     png_destroy_write_struct(&png_ptr, &info_ptr);
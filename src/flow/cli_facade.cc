@@ -17,14 +17,23 @@
 
 #include "flow/cli_facade.h"
 #include <algorithm>
+#include <iostream>
 #include <map>
+#include <set>
 #include "algo/range.h"
 #include "algo/str.h"
 #include "arg_parser.h"
 #include "dec/idecoder.h"
 #include "dec/registry.h"
+#include "err.h"
+#include "flow/entry_filter.h"
+#include "flow/entry_lister.h"
+#include "flow/file_saver_dedup.h"
 #include "flow/file_saver_hdd.h"
+#include "flow/file_saver_pack.h"
+#include "flow/manifest.h"
 #include "flow/parallel_unpacker.h"
+#include "flow/profiler.h"
 #include "io/file_system.h"
 #include "version.h"
 #include "virtual_file_system.h"
@@ -38,8 +47,15 @@ namespace
     {
         std::string decoder;
         io::path output_dir;
+        io::path pack_path;
+        io::path manifest_path;
+        io::path trace_path;
         std::vector<io::path> input_paths;
+        std::shared_ptr<EntryFilter> entry_filter;
         bool overwrite;
+        bool deduplicate;
+        bool list_entries;
+        bool show_stats;
         bool enable_nested_decoding;
         bool enable_virtual_file_system;
         bool should_show_help;
@@ -47,9 +63,59 @@ namespace
         bool should_list_decoders;
         int verbosity = 3;
         unsigned int thread_count;
+        size_t memory_budget;
+        size_t read_ahead_budget;
+        SchedulingPolicy scheduling_policy;
     };
 }
 
+static size_t parse_memory_size(const std::string &input)
+{
+    const auto pos = input.find_first_not_of("0123456789");
+    if (input.empty() || pos == 0)
+        throw err::UsageError("Invalid memory size: " + input);
+    const auto number
+        = static_cast<size_t>(std::stoull(input.substr(0, pos)));
+    if (pos == std::string::npos)
+        return number;
+    const auto suffix = algo::lower(input.substr(pos));
+    if (suffix == "k")
+        return number << 10;
+    if (suffix == "m")
+        return number << 20;
+    if (suffix == "g")
+        return number << 30;
+    throw err::UsageError("Invalid memory size: " + input);
+}
+
+// Arguments that do not change what is written, so that the manifest does
+// not consider inputs out of date when only these differ. Everything else,
+// including decoder options and entry filters, is recorded.
+static const std::set<std::string> non_output_options
+{
+    "-o", "--out", "--manifest", "-t", "--threads", "--schedule",
+    "--max-memory", "--read-ahead", "-v", "--verbosity", "--stats",
+    "--trace", "--no-color", "--no-colors",
+};
+
+static std::string get_output_options(
+    const std::vector<std::string> &arguments)
+{
+    std::string result;
+    for (const auto &argument : arguments)
+    {
+        if (argument.empty() || argument[0] != '-')
+            continue;
+        const auto name = argument.substr(0, argument.find('='));
+        if (non_output_options.find(name) != non_output_options.end())
+            continue;
+        if (!result.empty())
+            result += " ";
+        result += argument;
+    }
+    return result;
+}
+
 struct CliFacade::Priv final
 {
 public:
@@ -97,6 +163,15 @@ CliFacade::Priv::Priv(Logger &logger, const std::vector<std::string> &arguments)
     {
         logger.mute(Logger::MessageType::Info);
     }
+
+    // keep stdout clean for the JSON lines
+    if (options.list_entries)
+    {
+        logger.mute(Logger::MessageType::Summary);
+        logger.mute(Logger::MessageType::Success);
+        logger.mute(Logger::MessageType::Info);
+        logger.mute(Logger::MessageType::Debug);
+    }
 }
 
 void CliFacade::Priv::print_decoder_list() const
@@ -157,12 +232,60 @@ void CliFacade::Priv::register_cli_options()
             "Renames output files to preserve existing files. "
             "By default, existing files are overwritten with output files.");
 
+    arg_parser.register_flag({"--dedup"})
+        ->set_description(
+            "Stores output files with identical contents only once and "
+            "hard links the duplicates to the first copy.");
+
+    arg_parser.register_switch({"--manifest"})
+        ->set_value_name("FILE")
+        ->set_description(
+            "Records which outputs each input file produced in given FILE. "
+            "When the FILE already exists, input files that did not change "
+            "since are skipped, unless the output directory or options that "
+            "affect the output differ.");
+
+    arg_parser.register_flag({"--list", "--index"})
+        ->set_description(
+            "Prints paths, offsets and sizes of archive entries as JSON "
+            "lines instead of extracting them. Entries are read only to look "
+            "for nested archives, which --no-recurse disables.");
+
+    arg_parser.register_switch({"--include"})
+        ->set_value_name("GLOB")
+        ->set_description(
+            "Extracts only archive entries matching given GLOB, along with "
+            "their contents. Can be repeated. \"*\" does not cross "
+            "directories, \"**\" does; GLOB without a slash is matched "
+            "against file names only. Entries that cannot lead to a match "
+            "are not decoded at all.");
+
+    arg_parser.register_switch({"--exclude"})
+        ->set_value_name("GLOB")
+        ->set_description(
+            "Skips archive entries matching given GLOB, along with their "
+            "contents. Can be repeated.");
+
+    arg_parser.register_switch({"--include-regex"})
+        ->set_value_name("REGEX")
+        ->set_description("Like --include, but takes a regular expression.");
+
+    arg_parser.register_switch({"--exclude-regex"})
+        ->set_value_name("REGEX")
+        ->set_description("Like --exclude, but takes a regular expression.");
+
     arg_parser.register_switch({"-o", "--out"})
         ->set_value_name("DIR")
         ->set_description("Specifies where to place the output files. "
             "By default, the files are placed in current working directory. "
             "(Archives always create an intermediate directory.)");
 
+    arg_parser.register_switch({"--pack"})
+        ->set_value_name("FILE")
+        ->set_description("Writes all output files into a single .tar or "
+            ".zip archive instead of the output directory. Useful when "
+            "extracting large numbers of small files.");
+
     {
         auto sw = arg_parser.register_switch({"-d", "--dec"})
             ->set_value_name("DECODER")
@@ -179,6 +302,30 @@ void CliFacade::Priv::register_cli_options()
         ->set_value_name("NUM")
         ->set_description("Sets worker thread count.");
 
+    arg_parser.register_switch({"--schedule"})
+        ->set_value_name("POLICY")
+        ->set_description("Sets the order in which archive entries are "
+            "decoded.")
+        ->add_possible_value("default", "last entry in the archive first")
+        ->add_possible_value(
+            "largest-first", "avoids a long tail caused by one huge entry")
+        ->add_possible_value(
+            "offset", "keeps reads sequential on spinning disks");
+
+    arg_parser.register_switch({"--max-memory"})
+        ->set_value_name("SIZE")
+        ->set_description(
+            "Limits how much memory the running tasks are expected to take, "
+            "e.g. 512M or 2G. Tasks that would not fit wait for others to "
+            "finish; tasks larger than SIZE run alone.");
+
+    arg_parser.register_switch({"--read-ahead"})
+        ->set_value_name("SIZE")
+        ->set_description(
+            "Reads archive entries ahead of decoding on a separate thread, "
+            "holding up to SIZE bytes per archive, e.g. 64M. Helps when the "
+            "decoding threads would otherwise wait for the disk.");
+
     {
         auto sw = arg_parser.register_switch({"-v", "--verbosity"})
             ->set_description(
@@ -196,6 +343,16 @@ void CliFacade::Priv::register_cli_options()
             ->hide_possible_values();
     }
 
+    arg_parser.register_flag({"--stats"})
+        ->set_description(
+            "Prints time spent in each stage and throughput per decoder.");
+
+    arg_parser.register_switch({"--trace"})
+        ->set_value_name("FILE")
+        ->set_description(
+            "Saves a timeline of all stages per worker thread in Chrome "
+            "trace format to given FILE.");
+
     arg_parser.register_flag({"--no-color", "--no-colors"})
         ->set_description("Disables colors in console output.");
 
@@ -222,6 +379,11 @@ void CliFacade::Priv::parse_cli_options()
     options.overwrite
         = !arg_parser.has_flag("-r") && !arg_parser.has_flag("--rename");
 
+    options.deduplicate = arg_parser.has_flag("--dedup");
+
+    options.list_entries
+        = arg_parser.has_flag("--list") || arg_parser.has_flag("--index");
+
     if (arg_parser.has_flag("--no-color") || arg_parser.has_flag("--no-colors"))
         logger.disable_colors();
 
@@ -235,6 +397,10 @@ void CliFacade::Priv::parse_cli_options()
 
     options.enable_nested_decoding = !arg_parser.has_flag("--no-recurse");
 
+    options.show_stats = arg_parser.has_flag("--stats");
+    if (arg_parser.has_switch("--trace"))
+        options.trace_path = arg_parser.get_switch("--trace");
+
     if (arg_parser.has_switch("-t"))
         options.thread_count = algo::from_string<int>(
             arg_parser.get_switch("-t"));
@@ -244,6 +410,24 @@ void CliFacade::Priv::parse_cli_options()
     else
         options.thread_count = 0;
 
+    options.read_ahead_budget = arg_parser.has_switch("--read-ahead")
+        ? parse_memory_size(arg_parser.get_switch("--read-ahead"))
+        : 0;
+
+    options.scheduling_policy = SchedulingPolicy::Default;
+    if (arg_parser.has_switch("--schedule"))
+    {
+        const auto policy = arg_parser.get_switch("--schedule");
+        if (policy == "largest-first")
+            options.scheduling_policy = SchedulingPolicy::LargestFirst;
+        else if (policy == "offset")
+            options.scheduling_policy = SchedulingPolicy::OffsetOrder;
+    }
+
+    options.memory_budget = arg_parser.has_switch("--max-memory")
+        ? parse_memory_size(arg_parser.get_switch("--max-memory"))
+        : 0;
+
     if (arg_parser.has_flag("--no-vfs"))
         VirtualFileSystem::disable();
 
@@ -254,6 +438,56 @@ void CliFacade::Priv::parse_cli_options()
     else
         options.output_dir = "./";
 
+    if (arg_parser.has_switch("--pack"))
+    {
+        options.pack_path = arg_parser.get_switch("--pack");
+        if (!options.pack_path.has_extension("tar")
+            && !options.pack_path.has_extension("zip"))
+        {
+            throw err::UsageError("Unsupported pack format");
+        }
+        if (options.deduplicate)
+            throw err::UsageError("--dedup cannot be used with --pack");
+    }
+
+    if (arg_parser.has_switch("--manifest"))
+    {
+        options.manifest_path = arg_parser.get_switch("--manifest");
+        if (!options.pack_path.str().empty())
+            throw err::UsageError("--manifest cannot be used with --pack");
+    }
+
+    if (options.list_entries)
+    {
+        if (!options.pack_path.str().empty()
+            || !options.manifest_path.str().empty()
+            || options.deduplicate)
+        {
+            throw err::UsageError(
+                "--list cannot be used with --pack, --dedup or --manifest");
+        }
+    }
+
+    const auto includes = arg_parser.get_switch_values("--include");
+    const auto excludes = arg_parser.get_switch_values("--exclude");
+    const auto include_regexes
+        = arg_parser.get_switch_values("--include-regex");
+    const auto exclude_regexes
+        = arg_parser.get_switch_values("--exclude-regex");
+    if (includes.size() || excludes.size()
+        || include_regexes.size() || exclude_regexes.size())
+    {
+        options.entry_filter = std::make_shared<EntryFilter>();
+        for (const auto &glob : includes)
+            options.entry_filter->include(glob, PatternType::Glob);
+        for (const auto &glob : excludes)
+            options.entry_filter->exclude(glob, PatternType::Glob);
+        for (const auto &regex : include_regexes)
+            options.entry_filter->include(regex, PatternType::Regex);
+        for (const auto &regex : exclude_regexes)
+            options.entry_filter->exclude(regex, PatternType::Regex);
+    }
+
     if (arg_parser.has_switch("-d"))
         options.decoder = arg_parser.get_switch("-d");
     if (arg_parser.has_switch("--dec"))
@@ -306,19 +540,67 @@ int CliFacade::Priv::run() const
         ? std::set<std::string>(name_list.begin(), name_list.end())
         : std::set<std::string>{options.decoder};
 
-    FileSaverHdd file_saver(options.output_dir, options.overwrite);
+    std::unique_ptr<IFileSaver> file_saver;
+    FileSaverPack *file_saver_pack = nullptr;
+    if (!options.pack_path.str().empty())
+    {
+        auto saver = std::make_unique<FileSaverPack>(
+            options.pack_path,
+            options.pack_path.has_extension("zip")
+                ? PackFormat::Zip
+                : PackFormat::Tar);
+        file_saver_pack = saver.get();
+        file_saver = std::move(saver);
+    }
+    else if (options.deduplicate)
+    {
+        file_saver = std::make_unique<FileSaverDedup>(
+            options.output_dir, options.overwrite);
+    }
+    else
+    {
+        file_saver = std::make_unique<FileSaverHdd>(
+            options.output_dir, options.overwrite);
+    }
     ParallelUnpackerContext context(
         logger,
-        file_saver,
+        *file_saver,
         registry,
         options.enable_nested_decoding,
         arguments,
         available_decoders);
 
+    std::unique_ptr<Manifest> manifest;
+    std::unique_ptr<EntryLister> entry_lister;
+    std::unique_ptr<Profiler> profiler;
     ParallelUnpacker unpacker(context);
+    if (options.list_entries)
+    {
+        entry_lister = std::make_unique<EntryLister>(std::cout);
+        unpacker.set_entry_lister(*entry_lister);
+    }
+    if (options.entry_filter)
+        unpacker.set_entry_filter(*options.entry_filter);
+    unpacker.set_memory_budget(options.memory_budget);
+    unpacker.set_scheduling_policy(options.scheduling_policy);
+    unpacker.set_read_ahead(options.read_ahead_budget);
+    if (options.show_stats || !options.trace_path.str().empty())
+    {
+        profiler = std::make_unique<Profiler>();
+        unpacker.set_profiler(*profiler);
+    }
+    if (!options.manifest_path.str().empty())
+    {
+        manifest = std::make_unique<Manifest>(
+            options.manifest_path,
+            options.output_dir,
+            get_output_options(arguments));
+        unpacker.set_manifest(*manifest);
+    }
     for (const auto &input_path : options.input_paths)
     {
         unpacker.add_input_file(
+            input_path,
             io::path(input_path).change_stem(input_path.stem() + "~").name(),
             [&]()
             {
@@ -328,7 +610,16 @@ int CliFacade::Priv::run() const
                     io::absolute(input_path), io::FileMode::Read);
             });
     }
-    return unpacker.run(options.thread_count) ? 0 : 1;
+    const auto result = unpacker.run(options.thread_count);
+    if (file_saver_pack)
+        file_saver_pack->finish();
+    if (manifest)
+        manifest->save();
+    if (profiler && options.show_stats)
+        profiler->print_summary(logger);
+    if (profiler && !options.trace_path.str().empty())
+        profiler->save_trace(options.trace_path);
+    return result ? 0 : 1;
 }
 
 CliFacade::CliFacade(Logger &logger, const std::vector<std::string> &arguments)
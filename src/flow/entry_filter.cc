@@ -0,0 +1,183 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/entry_filter.h"
+#include <regex>
+#include <vector>
+#include "algo/str.h"
+#include "err.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct Pattern final
+    {
+        Pattern(const std::string &text, const PatternType type);
+
+        bool matches(const std::string &path) const;
+        bool may_match_inside(const std::string &path) const;
+
+        std::string text;
+        PatternType type;
+        std::regex regex;
+        bool has_slash;
+    };
+}
+
+// in partial mode, running out of text while some pattern is left counts as
+// a match, as more path components may follow
+static bool match_glob(const char *pattern, const char *text, bool partial)
+{
+    while (*pattern)
+    {
+        if (*pattern == '*')
+        {
+            const auto deep = pattern[1] == '*';
+            const auto rest = pattern + (deep ? 2 : 1);
+            if (deep && *rest == '/' && match_glob(rest + 1, text, partial))
+                return true;
+            for (auto t = text; ; t++)
+            {
+                if (match_glob(rest, t, partial))
+                    return true;
+                if (!*t || (!deep && *t == '/'))
+                    return false;
+            }
+        }
+        if (!*text)
+            return partial;
+        if (*pattern == '?' ? *text == '/' : *pattern != *text)
+            return false;
+        pattern++;
+        text++;
+    }
+    return !*text;
+}
+
+static std::vector<std::string> get_prefixes(const io::path &path)
+{
+    std::vector<std::string> prefixes;
+    std::string prefix;
+    for (const auto &part : algo::split(path.str(), '/', false))
+    {
+        if (part.empty())
+            continue;
+        prefix += prefix.empty() ? part : "/" + part;
+        prefixes.push_back(prefix);
+    }
+    return prefixes;
+}
+
+Pattern::Pattern(const std::string &text, const PatternType type) :
+        text(text),
+        type(type),
+        has_slash(text.find('/') != std::string::npos)
+{
+    if (type == PatternType::Regex)
+    {
+        try
+        {
+            regex = std::regex(text);
+        }
+        catch (const std::regex_error &)
+        {
+            throw err::UsageError("Invalid regex: " + text);
+        }
+    }
+}
+
+bool Pattern::matches(const std::string &path) const
+{
+    if (type == PatternType::Regex)
+        return std::regex_search(path, regex);
+    if (has_slash)
+        return match_glob(text.c_str(), path.c_str(), false);
+    const auto name = path.substr(path.find_last_of('/') + 1);
+    return match_glob(text.c_str(), name.c_str(), false);
+}
+
+bool Pattern::may_match_inside(const std::string &path) const
+{
+    if (type == PatternType::Regex || !has_slash)
+        return true;
+    return match_glob(text.c_str(), (path + "/").c_str(), true);
+}
+
+struct EntryFilter::Priv final
+{
+    bool is_excluded(const std::vector<std::string> &prefixes) const;
+
+    std::vector<Pattern> includes;
+    std::vector<Pattern> excludes;
+};
+
+bool EntryFilter::Priv::is_excluded(
+    const std::vector<std::string> &prefixes) const
+{
+    for (const auto &prefix : prefixes)
+        for (const auto &pattern : excludes)
+            if (pattern.matches(prefix))
+                return true;
+    return false;
+}
+
+EntryFilter::EntryFilter() : p(new Priv)
+{
+}
+
+EntryFilter::~EntryFilter()
+{
+}
+
+void EntryFilter::include(const std::string &pattern, const PatternType type)
+{
+    p->includes.push_back(Pattern(pattern, type));
+}
+
+void EntryFilter::exclude(const std::string &pattern, const PatternType type)
+{
+    p->excludes.push_back(Pattern(pattern, type));
+}
+
+bool EntryFilter::is_selected(const io::path &entry_path) const
+{
+    const auto prefixes = get_prefixes(entry_path);
+    if (p->is_excluded(prefixes))
+        return false;
+    if (p->includes.empty())
+        return true;
+    for (const auto &prefix : prefixes)
+        for (const auto &pattern : p->includes)
+            if (pattern.matches(prefix))
+                return true;
+    return false;
+}
+
+bool EntryFilter::may_contain_selected(const io::path &entry_path) const
+{
+    const auto prefixes = get_prefixes(entry_path);
+    if (p->is_excluded(prefixes))
+        return false;
+    if (p->includes.empty() || is_selected(entry_path))
+        return true;
+    for (const auto &pattern : p->includes)
+        if (pattern.may_match_inside(prefixes.empty() ? "" : prefixes.back()))
+            return true;
+    return false;
+}
@@ -0,0 +1,55 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "io/path.h"
+#include "types.h"
+
+namespace au {
+namespace flow {
+
+    enum class PatternType : u8
+    {
+        Glob,
+        Regex,
+    };
+
+    // Selects archive entries by their path, counting from the outermost
+    // archive. Globs without a slash match the file name alone, "*" does not
+    // cross directories and "**" does. Regexes are searched for anywhere in
+    // the path. Selecting or excluding an entry also affects its contents.
+    class EntryFilter final
+    {
+    public:
+        EntryFilter();
+        ~EntryFilter();
+
+        void include(const std::string &pattern, const PatternType type);
+        void exclude(const std::string &pattern, const PatternType type);
+
+        bool is_selected(const io::path &entry_path) const;
+        bool may_contain_selected(const io::path &entry_path) const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
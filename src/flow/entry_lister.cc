@@ -0,0 +1,102 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/entry_lister.h"
+#include <mutex>
+#include "algo/format.h"
+
+using namespace au;
+using namespace au::flow;
+
+static std::string quote(const std::string &input)
+{
+    std::string output = "\"";
+    for (const auto c : input)
+    {
+        if (c == '"' || c == '\\')
+            output += std::string("\\") + c;
+        else if (c == '\n')
+            output += "\\n";
+        else if (c == '\r')
+            output += "\\r";
+        else if (c == '\t')
+            output += "\\t";
+        else if (static_cast<u8>(c) < 0x20)
+            output += algo::format("\\u%04x", c);
+        else
+            output += c;
+    }
+    return output + "\"";
+}
+
+struct EntryLister::Priv final
+{
+    Priv(std::ostream &output);
+
+    std::ostream &output;
+    std::mutex mutex;
+    size_t entry_count;
+};
+
+EntryLister::Priv::Priv(std::ostream &output) : output(output), entry_count(0)
+{
+}
+
+EntryLister::EntryLister(std::ostream &output) : p(new Priv(output))
+{
+}
+
+EntryLister::~EntryLister()
+{
+    p->output.flush();
+}
+
+void EntryLister::add(
+    const io::path &archive_path,
+    const std::string &decoder_name,
+    const dec::ArchiveEntry &entry)
+{
+    auto line = "{\"archive\":" + quote(archive_path.str())
+        + ",\"decoder\":" + quote(decoder_name)
+        + ",\"path\":" + quote(entry.path.str());
+
+    dec::ArchiveEntryRange range;
+    if (dec::get_entry_range(entry, range))
+    {
+        line += algo::format(
+            ",\"offset\":%llu,\"size\":%llu",
+            static_cast<unsigned long long>(range.offset),
+            static_cast<unsigned long long>(range.size_orig));
+        if (range.compressed)
+        {
+            line += algo::format(
+                ",\"size_comp\":%llu",
+                static_cast<unsigned long long>(range.size_stored));
+        }
+    }
+    line += "}\n";
+
+    std::unique_lock<std::mutex> lock(p->mutex);
+    p->output << line;
+    p->entry_count++;
+}
+
+size_t EntryLister::get_entry_count() const
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    return p->entry_count;
+}
@@ -0,0 +1,47 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include "dec/base_archive_decoder.h"
+
+namespace au {
+namespace flow {
+
+    // Writes archive entries as JSON Lines instead of extracting them.
+    class EntryLister final
+    {
+    public:
+        EntryLister(std::ostream &output);
+        ~EntryLister();
+
+        void add(
+            const io::path &archive_path,
+            const std::string &decoder_name,
+            const dec::ArchiveEntry &entry);
+
+        size_t get_entry_count() const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
@@ -0,0 +1,133 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/file_saver_dedup.h"
+#include <map>
+#include <mutex>
+#include <set>
+#include "algo/crypt/sha1.h"
+#include "algo/format.h"
+#include "flow/staging_area.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+
+using namespace au;
+using namespace au::flow;
+
+static std::mutex mutex;
+
+struct FileSaverDedup::Priv final
+{
+    Priv(
+        const io::path &output_dir,
+        const bool overwrite);
+
+    io::path make_path_unique(const io::path &path);
+
+    io::path output_dir;
+    bool overwrite;
+    size_t saved_file_count;
+    size_t linked_file_count;
+    std::set<io::path> paths;
+    StagingArea staging_area;
+    std::map<bstr, io::path> paths_by_hash;
+};
+
+FileSaverDedup::Priv::Priv(const io::path &output_dir, const bool overwrite)
+    : output_dir(output_dir),
+        overwrite(overwrite),
+        saved_file_count(0),
+        linked_file_count(0),
+        staging_area(output_dir)
+{
+}
+
+io::path FileSaverDedup::Priv::make_path_unique(const io::path &path)
+{
+    io::path new_path = path;
+    int i = 1;
+    while (paths.find(new_path) != paths.end()
+        || (!overwrite && io::exists(new_path)))
+    {
+        new_path.change_stem(path.stem() + algo::format("(%d)", i++));
+    }
+    paths.insert(new_path);
+    return new_path;
+}
+
+FileSaverDedup::FileSaverDedup(
+    const io::path &output_dir, const bool overwrite)
+    : p(new Priv(output_dir, overwrite))
+{
+}
+
+FileSaverDedup::~FileSaverDedup()
+{
+}
+
+io::path FileSaverDedup::save(std::shared_ptr<io::File> file) const
+{
+    // hash before taking the lock so that workers can do it in parallel
+    file->stream.seek(0);
+    const auto hash = algo::crypt::sha1(file->stream)
+        + algo::format("%llx", static_cast<u64>(file->stream.size()));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const auto full_path = p->make_path_unique(p->output_dir / file->path);
+    io::create_directories(full_path.parent());
+    ++p->saved_file_count;
+
+    // never write through an existing file, it might be linked elsewhere
+    if (io::exists(full_path))
+        io::remove(full_path);
+
+    const auto it = p->paths_by_hash.find(hash);
+    if (it != p->paths_by_hash.end())
+    {
+        if (io::create_hard_link(it->second, full_path))
+        {
+            ++p->linked_file_count;
+            return full_path;
+        }
+    }
+
+    if (!p->staging_area.move(file, full_path))
+    {
+        io::FileByteStream output_stream(full_path, io::FileMode::Write);
+        file->stream.seek(0);
+        output_stream.write(file->stream);
+    }
+    if (it == p->paths_by_hash.end())
+        p->paths_by_hash[hash] = full_path;
+    return full_path;
+}
+
+std::shared_ptr<io::File> FileSaverDedup::create_file(
+    const io::path &path) const
+{
+    return p->staging_area.create_file(path);
+}
+
+size_t FileSaverDedup::get_saved_file_count() const
+{
+    return p->saved_file_count;
+}
+
+size_t FileSaverDedup::get_linked_file_count() const
+{
+    return p->linked_file_count;
+}
@@ -19,6 +19,7 @@
 #include <mutex>
 #include <set>
 #include "algo/format.h"
+#include "flow/staging_area.h"
 #include "io/file_byte_stream.h"
 #include "io/file_system.h"
 
@@ -39,10 +40,14 @@ struct FileSaverHdd::Priv final
     bool overwrite;
     size_t saved_file_count;
     std::set<io::path> paths;
+    StagingArea staging_area;
 };
 
 FileSaverHdd::Priv::Priv(const io::path &output_dir, const bool overwrite)
-    : output_dir(output_dir), overwrite(overwrite), saved_file_count(0)
+    : output_dir(output_dir),
+        overwrite(overwrite),
+        saved_file_count(0),
+        staging_area(output_dir)
 {
 }
 
@@ -74,13 +79,21 @@ io::path FileSaverHdd::save(std::shared_ptr<io::File> file) const
     std::unique_lock<std::mutex> lock(mutex);
     const auto full_path = p->make_path_unique(p->output_dir / file->path);
     io::create_directories(full_path.parent());
-    io::FileByteStream output_stream(full_path, io::FileMode::Write);
-    file->stream.seek(0);
-    output_stream.write(file->stream);
+    if (!p->staging_area.move(file, full_path))
+    {
+        io::FileByteStream output_stream(full_path, io::FileMode::Write);
+        file->stream.seek(0);
+        output_stream.write(file->stream);
+    }
     ++p->saved_file_count;
     return full_path;
 }
 
+std::shared_ptr<io::File> FileSaverHdd::create_file(const io::path &path) const
+{
+    return p->staging_area.create_file(path);
+}
+
 size_t FileSaverHdd::get_saved_file_count() const
 {
     return p->saved_file_count;
@@ -31,6 +31,8 @@ namespace flow {
 
         io::path save(std::shared_ptr<io::File> file) const override;
         size_t get_saved_file_count() const override;
+        std::shared_ptr<io::File> create_file(
+            const io::path &path) const override;
 
     private:
         struct Priv;
@@ -0,0 +1,459 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/file_saver_pack.h"
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include "algo/crypt/crc32.h"
+#include "algo/format.h"
+#include "algo/pack/zlib.h"
+#include "algo/range.h"
+#include "err.h"
+#include "io/file_byte_stream.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct PackEntry final
+    {
+        std::string name;
+        bstr data;
+        size_t original_size;
+        u32 crc;
+        bool deflated;
+    };
+
+    struct ZipRecord final
+    {
+        std::string name;
+        size_t original_size;
+        size_t stored_size;
+        u32 crc;
+        bool deflated;
+        u64 offset;
+    };
+}
+
+// bounds the memory taken by entries that wait for the writer
+static const size_t max_queued_entries = 64;
+
+static const size_t tar_block_size = 512;
+static const u32 zip_max_u32 = 0xFFFFFFFF;
+static const u16 zip_max_u16 = 0xFFFF;
+static const u16 zip_utf8_flag = 0x0800;
+
+static void write_octal(
+    bstr &header, const size_t offset, const size_t size, const u64 value)
+{
+    const auto str = algo::format(
+        "%0*llo",
+        static_cast<int>(size - 1),
+        static_cast<unsigned long long>(value));
+    if (str.size() > size - 1)
+        throw err::IoError("File is too large to be stored in a tar archive");
+    for (const auto i : algo::range(str.size()))
+        header[offset + i] = str[i];
+}
+
+static void write_string(
+    bstr &header, const size_t offset, const std::string &value)
+{
+    for (const auto i : algo::range(value.size()))
+        header[offset + i] = value[i];
+}
+
+static bstr make_tar_header(
+    const std::string &name,
+    const std::string &prefix,
+    const u64 size,
+    const u64 mtime,
+    const char type)
+{
+    bstr header(tar_block_size);
+    write_string(header, 0, name);
+    write_octal(header, 100, 8, 0644);
+    write_octal(header, 108, 8, 0);
+    write_octal(header, 116, 8, 0);
+    write_octal(header, 124, 12, size);
+    write_octal(header, 136, 12, mtime);
+    write_string(header, 148, "        ");
+    header[156] = type;
+    write_string(header, 257, "ustar");
+    write_string(header, 263, "00");
+    write_string(header, 345, prefix);
+
+    u32 checksum = 0;
+    for (const auto c : header)
+        checksum += c;
+    write_octal(header, 148, 7, checksum);
+    return header;
+}
+
+static std::string make_pax_record(
+    const std::string &key, const std::string &value)
+{
+    // the length prefix counts its own digits
+    const auto body = " " + key + "=" + value + "\n";
+    auto length = body.size() + 1;
+    while (algo::format("%d", length).size() + body.size() != length)
+        ++length;
+    return algo::format("%d", length) + body;
+}
+
+static u16 get_dos_time(const std::tm &time)
+{
+    return (time.tm_hour << 11) | (time.tm_min << 5) | (time.tm_sec / 2);
+}
+
+static u16 get_dos_date(const std::tm &time)
+{
+    return ((std::max(time.tm_year, 80) - 80) << 9)
+        | ((time.tm_mon + 1) << 5)
+        | time.tm_mday;
+}
+
+struct FileSaverPack::Priv final
+{
+    Priv(const io::path &output_path, const PackFormat format);
+    ~Priv();
+
+    void stop_writer();
+    void finish();
+    io::path make_path_unique(const io::path &path);
+    void run_writer();
+    void write_tar_entry(const PackEntry &entry);
+    void write_tar_trailer();
+    void write_zip_entry(const PackEntry &entry);
+    void write_zip_trailer();
+
+    io::path output_path;
+    PackFormat format;
+    io::FileByteStream output_stream;
+    size_t saved_file_count;
+    std::set<io::path> paths;
+    std::time_t mtime;
+    std::vector<ZipRecord> zip_records;
+
+    std::mutex mutex;
+    std::condition_variable queue_changed;
+    std::deque<PackEntry> queue;
+    bool closing;
+    bool failed;
+    bool finished;
+    std::thread writer;
+};
+
+FileSaverPack::Priv::Priv(const io::path &output_path, const PackFormat format)
+    : output_path(output_path),
+        format(format),
+        output_stream(output_path, io::FileMode::Write),
+        saved_file_count(0),
+        mtime(std::time(nullptr)),
+        closing(false),
+        failed(false),
+        finished(false)
+{
+    writer = std::thread([&]() { run_writer(); });
+}
+
+FileSaverPack::Priv::~Priv()
+{
+    stop_writer();
+}
+
+void FileSaverPack::Priv::stop_writer()
+{
+    if (!writer.joinable())
+        return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        closing = true;
+    }
+    queue_changed.notify_all();
+    writer.join();
+}
+
+void FileSaverPack::Priv::finish()
+{
+    if (finished)
+        return;
+    stop_writer();
+    if (failed)
+        throw err::IoError("Error writing to " + output_path.str());
+    if (format == PackFormat::Tar)
+        write_tar_trailer();
+    else if (format == PackFormat::Zip)
+        write_zip_trailer();
+    finished = true;
+}
+
+io::path FileSaverPack::Priv::make_path_unique(const io::path &path)
+{
+    io::path new_path = path;
+    int i = 1;
+    while (paths.find(new_path) != paths.end())
+        new_path.change_stem(path.stem() + algo::format("(%d)", i++));
+    paths.insert(new_path);
+    return new_path;
+}
+
+void FileSaverPack::Priv::run_writer()
+{
+    while (true)
+    {
+        PackEntry entry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queue_changed.wait(
+                lock, [&]() { return closing || !queue.empty(); });
+            if (queue.empty())
+                return;
+            entry = std::move(queue.front());
+            queue.pop_front();
+        }
+        queue_changed.notify_all();
+
+        try
+        {
+            if (format == PackFormat::Tar)
+                write_tar_entry(entry);
+            else if (format == PackFormat::Zip)
+                write_zip_entry(entry);
+        }
+        catch (...)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                failed = true;
+                queue.clear();
+            }
+            queue_changed.notify_all();
+            return;
+        }
+    }
+}
+
+void FileSaverPack::Priv::write_tar_entry(const PackEntry &entry)
+{
+    std::string name = entry.name;
+    std::string prefix;
+    if (name.size() > 100)
+    {
+        const auto pos = name.find('/', name.size() - 101);
+        if (pos != std::string::npos && pos <= 155 && pos + 1 < name.size())
+        {
+            prefix = name.substr(0, pos);
+            name = name.substr(pos + 1);
+        }
+        else
+        {
+            // too long for ustar fields, use a pax extended header
+            const auto record = make_pax_record("path", entry.name);
+            output_stream.write(
+                make_tar_header("PaxHeader", "", record.size(), mtime, 'x'));
+            output_stream.write(bstr(record));
+            output_stream.write(bstr(
+                (tar_block_size - record.size() % tar_block_size)
+                    % tar_block_size));
+            name = name.substr(0, 100);
+        }
+    }
+
+    output_stream.write(
+        make_tar_header(name, prefix, entry.data.size(), mtime, '0'));
+    output_stream.write(entry.data);
+    output_stream.write(bstr(
+        (tar_block_size - entry.data.size() % tar_block_size)
+            % tar_block_size));
+}
+
+void FileSaverPack::Priv::write_tar_trailer()
+{
+    output_stream.write(bstr(tar_block_size * 2));
+}
+
+void FileSaverPack::Priv::write_zip_entry(const PackEntry &entry)
+{
+    const auto time = *std::localtime(&mtime);
+
+    ZipRecord record;
+    record.name = entry.name;
+    record.original_size = entry.original_size;
+    record.stored_size = entry.data.size();
+    record.crc = entry.crc;
+    record.deflated = entry.deflated;
+    record.offset = output_stream.pos();
+
+    output_stream.write_le<u32>(0x04034B50);
+    output_stream.write_le<u16>(20);
+    output_stream.write_le<u16>(zip_utf8_flag);
+    output_stream.write_le<u16>(entry.deflated ? 8 : 0);
+    output_stream.write_le<u16>(get_dos_time(time));
+    output_stream.write_le<u16>(get_dos_date(time));
+    output_stream.write_le<u32>(record.crc);
+    output_stream.write_le<u32>(record.stored_size);
+    output_stream.write_le<u32>(record.original_size);
+    output_stream.write_le<u16>(record.name.size());
+    output_stream.write_le<u16>(0);
+    output_stream.write(bstr(record.name));
+    output_stream.write(entry.data);
+
+    zip_records.push_back(record);
+}
+
+void FileSaverPack::Priv::write_zip_trailer()
+{
+    const auto time = *std::localtime(&mtime);
+    const u64 directory_offset = output_stream.pos();
+    for (const auto &record : zip_records)
+    {
+        const auto needs_zip64 = record.offset >= zip_max_u32;
+        output_stream.write_le<u32>(0x02014B50);
+        output_stream.write_le<u16>(needs_zip64 ? 45 : 20);
+        output_stream.write_le<u16>(needs_zip64 ? 45 : 20);
+        output_stream.write_le<u16>(zip_utf8_flag);
+        output_stream.write_le<u16>(record.deflated ? 8 : 0);
+        output_stream.write_le<u16>(get_dos_time(time));
+        output_stream.write_le<u16>(get_dos_date(time));
+        output_stream.write_le<u32>(record.crc);
+        output_stream.write_le<u32>(record.stored_size);
+        output_stream.write_le<u32>(record.original_size);
+        output_stream.write_le<u16>(record.name.size());
+        output_stream.write_le<u16>(needs_zip64 ? 12 : 0);
+        output_stream.write_le<u16>(0); // comment size
+        output_stream.write_le<u16>(0); // disk number
+        output_stream.write_le<u16>(0); // internal attributes
+        output_stream.write_le<u32>(0); // external attributes
+        output_stream.write_le<u32>(
+            needs_zip64 ? zip_max_u32 : record.offset);
+        output_stream.write(bstr(record.name));
+        if (needs_zip64)
+        {
+            output_stream.write_le<u16>(0x0001);
+            output_stream.write_le<u16>(8);
+            output_stream.write_le<u64>(record.offset);
+        }
+    }
+    const u64 directory_end = output_stream.pos();
+    const u64 directory_size = directory_end - directory_offset;
+    const u64 record_count = zip_records.size();
+
+    const auto needs_zip64 = record_count >= zip_max_u16
+        || directory_offset >= zip_max_u32
+        || directory_size >= zip_max_u32;
+    if (needs_zip64)
+    {
+        output_stream.write_le<u32>(0x06064B50);
+        output_stream.write_le<u64>(44);
+        output_stream.write_le<u16>(45);
+        output_stream.write_le<u16>(45);
+        output_stream.write_le<u32>(0);
+        output_stream.write_le<u32>(0);
+        output_stream.write_le<u64>(record_count);
+        output_stream.write_le<u64>(record_count);
+        output_stream.write_le<u64>(directory_size);
+        output_stream.write_le<u64>(directory_offset);
+
+        output_stream.write_le<u32>(0x07064B50);
+        output_stream.write_le<u32>(0);
+        output_stream.write_le<u64>(directory_end);
+        output_stream.write_le<u32>(1);
+    }
+
+    output_stream.write_le<u32>(0x06054B50);
+    output_stream.write_le<u16>(0);
+    output_stream.write_le<u16>(0);
+    output_stream.write_le<u16>(std::min<u64>(record_count, zip_max_u16));
+    output_stream.write_le<u16>(std::min<u64>(record_count, zip_max_u16));
+    output_stream.write_le<u32>(std::min<u64>(directory_size, zip_max_u32));
+    output_stream.write_le<u32>(
+        std::min<u64>(directory_offset, zip_max_u32));
+    output_stream.write_le<u16>(0); // comment size
+}
+
+FileSaverPack::FileSaverPack(
+    const io::path &output_path, const PackFormat format)
+    : p(new Priv(output_path, format))
+{
+}
+
+FileSaverPack::~FileSaverPack()
+{
+}
+
+io::path FileSaverPack::save(std::shared_ptr<io::File> file) const
+{
+    PackEntry entry;
+    file->stream.seek(0);
+    entry.data = file->stream.read_to_eof();
+    entry.original_size = entry.data.size();
+    entry.crc = 0;
+    entry.deflated = false;
+
+    if (p->format == PackFormat::Zip)
+    {
+        if (entry.original_size >= zip_max_u32)
+            throw err::IoError("File is too large to be stored in a zip");
+        // compress here so that the work spreads across the callers
+        entry.crc = algo::crypt::crc32(entry.data);
+        auto deflated = algo::pack::zlib_deflate(
+            entry.data,
+            algo::pack::ZlibKind::RawDeflate,
+            algo::pack::CompressionLevel::Fast);
+        if (deflated.size() < entry.data.size())
+        {
+            entry.data = std::move(deflated);
+            entry.deflated = true;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(p->mutex);
+    p->queue_changed.wait(lock, [&]()
+    {
+        return p->failed || p->queue.size() < max_queued_entries;
+    });
+    if (p->failed)
+        throw err::IoError("Error writing to " + p->output_path.str());
+    if (p->closing)
+        throw std::logic_error("Saving to a finished archive");
+    const auto path = p->make_path_unique(file->path);
+    entry.name = path.c_str();
+    p->queue.push_back(std::move(entry));
+    ++p->saved_file_count;
+    lock.unlock();
+    p->queue_changed.notify_all();
+    return p->output_path / path;
+}
+
+size_t FileSaverPack::get_saved_file_count() const
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    return p->saved_file_count;
+}
+
+void FileSaverPack::finish()
+{
+    p->finish();
+}
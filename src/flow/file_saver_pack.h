@@ -0,0 +1,53 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include "flow/ifile_saver.h"
+
+namespace au {
+namespace flow {
+
+    enum class PackFormat : u8
+    {
+        Tar,
+        Zip,
+    };
+
+    // Stores all saved files in a single archive rather than one file each.
+    // Callers only prepare the entries; a dedicated thread writes them out in
+    // order. The archive is complete only after finish() returns.
+    class FileSaverPack final : public IFileSaver
+    {
+    public:
+        FileSaverPack(const io::path &output_path, const PackFormat format);
+        ~FileSaverPack();
+
+        io::path save(std::shared_ptr<io::File> file) const override;
+        size_t get_saved_file_count() const override;
+
+        // Waits for the queued entries and writes the archive trailer.
+        // Throws if any part of the archive could not be written.
+        void finish();
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <memory>
 #include "io/file.h"
 
 namespace au {
@@ -28,6 +29,15 @@ namespace flow {
         virtual ~IFileSaver() {}
         virtual io::path save(std::shared_ptr<io::File> file) const = 0;
         virtual size_t get_saved_file_count() const = 0;
+
+        // Returns an empty file to be filled in and passed to save(). Savers
+        // that write to disk back it with a file in the output directory so
+        // that large outputs never have to be held in memory.
+        virtual std::shared_ptr<io::File> create_file(
+            const io::path &path) const
+        {
+            return std::make_shared<io::File>(path, ""_b);
+        }
     };
 
 } }
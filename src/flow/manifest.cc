@@ -0,0 +1,243 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/manifest.h"
+#include <map>
+#include <mutex>
+#include <vector>
+#include "algo/crypt/sha1.h"
+#include "algo/str.h"
+#include "err.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct Record final
+    {
+        uoff_t size;
+        std::time_t mtime;
+        bstr hash;
+        std::string decoder_name;
+        io::path output_dir;
+        std::string options;
+        std::vector<io::path> output_paths;
+        bool failed;
+    };
+}
+
+static const std::string input_tag = "input";
+static const std::string output_dir_tag = "output-dir";
+static const std::string options_tag = "options";
+static const std::string output_tag = "output";
+
+static bstr hash_file(const io::path &path)
+{
+    io::FileByteStream input_stream(path, io::FileMode::Read);
+    return algo::crypt::sha1(input_stream);
+}
+
+static std::string make_key(const io::path &input_path)
+{
+    return io::absolute(input_path).str();
+}
+
+struct Manifest::Priv final
+{
+    Priv(
+        const io::path &path,
+        const io::path &output_dir,
+        const std::string &options);
+    void load();
+
+    io::path path;
+    io::path output_dir;
+    std::string options;
+    mutable std::mutex mutex;
+    mutable std::map<std::string, Record> records;
+};
+
+Manifest::Priv::Priv(
+    const io::path &path,
+    const io::path &output_dir,
+    const std::string &options)
+    : path(path), output_dir(io::absolute(output_dir)), options(options)
+{
+}
+
+void Manifest::Priv::load()
+{
+    io::FileByteStream input_stream(path, io::FileMode::Read);
+    Record *record = nullptr;
+    while (input_stream.left())
+    {
+        const auto line = input_stream.read_line().str();
+        const auto tokens = algo::split(line, '\t', false);
+        // only the input line has several fields; other values are taken
+        // whole, tabs included
+        const auto pos = line.find('\t');
+        const auto tag = line.substr(0, pos);
+        const auto value
+            = pos == std::string::npos ? "" : line.substr(pos + 1);
+        if (tokens.size() == 6 && tokens[0] == input_tag)
+        {
+            record = &records[tokens[5]];
+            record->size = std::stoull(tokens[1]);
+            record->mtime = std::stoll(tokens[2]);
+            record->hash = algo::unhex(tokens[3]);
+            record->decoder_name = tokens[4];
+            record->failed = false;
+        }
+        else if (tag == output_dir_tag && record)
+        {
+            record->output_dir = value;
+        }
+        else if (tag == options_tag && record)
+        {
+            record->options = value;
+        }
+        else if (tag == output_tag && record)
+        {
+            record->output_paths.push_back(value);
+        }
+        else
+        {
+            throw err::CorruptDataError("Malformed manifest line: " + line);
+        }
+    }
+}
+
+Manifest::Manifest(
+    const io::path &path,
+    const io::path &output_dir,
+    const std::string &options)
+    : p(new Priv(path, output_dir, options))
+{
+    if (io::exists(path))
+        p->load();
+}
+
+Manifest::~Manifest()
+{
+}
+
+bool Manifest::is_up_to_date(const io::path &input_path) const
+{
+    if (!io::exists(input_path))
+        return false;
+    std::unique_lock<std::mutex> lock(p->mutex);
+    const auto it = p->records.find(make_key(input_path));
+    if (it == p->records.end())
+        return false;
+    auto &record = it->second;
+    if (record.failed || io::file_size(input_path) != record.size)
+        return false;
+    if (!(record.output_dir == p->output_dir) || record.options != p->options)
+        return false;
+    for (const auto &output_path : record.output_paths)
+        if (!io::exists(output_path))
+            return false;
+
+    // only hash when cheaper checks are inconclusive
+    const auto mtime = io::last_write_time(input_path);
+    if (mtime == record.mtime)
+        return true;
+    if (hash_file(input_path) != record.hash)
+        return false;
+    record.mtime = mtime;
+    return true;
+}
+
+void Manifest::begin_input(const io::path &input_path)
+{
+    Record record;
+    record.size = io::file_size(input_path);
+    record.mtime = io::last_write_time(input_path);
+    record.decoder_name = "-";
+    record.output_dir = p->output_dir;
+    record.options = p->options;
+    record.failed = false;
+
+    const auto key = make_key(input_path);
+    {
+        // an input unpacked again with other options keeps its hash
+        std::unique_lock<std::mutex> lock(p->mutex);
+        const auto it = p->records.find(key);
+        if (it != p->records.end()
+            && it->second.size == record.size
+            && it->second.mtime == record.mtime)
+        {
+            record.hash = it->second.hash;
+        }
+    }
+    if (record.hash.empty())
+        record.hash = hash_file(input_path);
+
+    std::unique_lock<std::mutex> lock(p->mutex);
+    p->records[key] = record;
+}
+
+void Manifest::set_decoder(
+    const io::path &input_path, const std::string &decoder_name)
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    p->records[make_key(input_path)].decoder_name = decoder_name;
+}
+
+void Manifest::add_output(
+    const io::path &input_path, const io::path &output_path)
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    p->records[make_key(input_path)].output_paths.push_back(
+        io::absolute(output_path));
+}
+
+void Manifest::mark_failed(const io::path &input_path)
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    p->records[make_key(input_path)].failed = true;
+}
+
+void Manifest::save() const
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    io::FileByteStream output_stream(p->path, io::FileMode::Write);
+    for (const auto &it : p->records)
+    {
+        const auto &record = it.second;
+        if (record.failed)
+            continue;
+        output_stream.write(bstr(
+            input_tag + "\t"
+            + std::to_string(record.size) + "\t"
+            + std::to_string(record.mtime) + "\t"
+            + algo::hex(record.hash) + "\t"
+            + record.decoder_name + "\t"
+            + it.first + "\n"));
+        output_stream.write(bstr(
+            output_dir_tag + "\t" + record.output_dir.str() + "\n"));
+        output_stream.write(bstr(options_tag + "\t" + record.options + "\n"));
+        for (const auto &output_path : record.output_paths)
+        {
+            output_stream.write(
+                bstr(output_tag + "\t" + output_path.str() + "\n"));
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "io/path.h"
+
+namespace au {
+namespace flow {
+
+    // Remembers which outputs each input file produced in earlier runs, so
+    // that inputs that did not change since can be skipped. Inputs are not
+    // skipped when they were unpacked to another directory or with other
+    // options; options is any text that changes along with the output.
+    class Manifest final
+    {
+    public:
+        Manifest(
+            const io::path &path,
+            const io::path &output_dir,
+            const std::string &options);
+        ~Manifest();
+
+        bool is_up_to_date(const io::path &input_path) const;
+
+        void begin_input(const io::path &input_path);
+        void set_decoder(
+            const io::path &input_path, const std::string &decoder_name);
+        void add_output(
+            const io::path &input_path, const io::path &output_path);
+        void mark_failed(const io::path &input_path);
+
+        void save() const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
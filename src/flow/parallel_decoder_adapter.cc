@@ -16,18 +16,48 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "flow/parallel_decoder_adapter.h"
+#include <algorithm>
 #include "algo/naming_strategies.h"
-#include "enc/microsoft/wav_audio_encoder.h"
+#include "enc/microsoft/wav_audio_sink.h"
 #include "enc/png/png_image_encoder.h"
+#include "flow/profiler.h"
+#include "flow/read_ahead.h"
 #include "flow/vfs_bridge.h"
 
 using namespace au;
 using namespace au::flow;
 
+// decoded pixels and samples tend to take several times more than the input
+static const size_t decoded_media_expansion = 4;
+
+static size_t estimate_memory(const dec::ArchiveEntry &entry)
+{
+    dec::ArchiveEntryRange range;
+    if (!dec::get_entry_range(entry, range))
+        return 0;
+    return range.compressed
+        ? range.size_orig + range.size_stored
+        : range.size_orig;
+}
+
+static bool may_contain_archives(
+    const BaseParallelUnpackingTask &task, const dec::BaseDecoder &decoder)
+{
+    if (!task.task_context.unpacker_context.enable_nested_decoding)
+        return false;
+    if (!decoder.get_linked_formats().empty())
+        return true;
+    return task.source_type == TaskSourceType::NestedDecoding
+        && !task.decoders_to_check.empty();
+}
+
 ParallelDecoderAdapter::ParallelDecoderAdapter(
     const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
-    const std::shared_ptr<io::File> input_file)
-    : parent_task(parent_task), input_file(input_file)
+    const std::shared_ptr<io::File> input_file,
+    const std::string &decoder_name) :
+        parent_task(parent_task),
+        input_file(input_file),
+        decoder_name(decoder_name)
 {
 }
 
@@ -38,8 +68,12 @@ ParallelDecoderAdapter::~ParallelDecoderAdapter()
 void ParallelDecoderAdapter::visit(const dec::BaseArchiveDecoder &decoder)
 {
     auto input_file = this->input_file;
+    const auto profiler = parent_task->task_context.profiler;
+    ProfileScope read_meta_scope(
+        profiler, decoder_name, ProfileStage::ReadMeta);
     auto meta = std::shared_ptr<dec::ArchiveMeta>(
         decoder.read_meta(parent_task->logger, *input_file));
+    read_meta_scope.finish();
     parent_task->logger.info(
         "archive contains %d files.\n", meta->entries.size());
 
@@ -50,54 +84,136 @@ void ParallelDecoderAdapter::visit(const dec::BaseArchiveDecoder &decoder)
         input_file,
         parent_task->base_name);
 
+    const auto entry_lister = parent_task->task_context.entry_lister;
+    const auto entry_filter = parent_task->task_context.entry_filter;
+    const auto may_nest = may_contain_archives(*parent_task, decoder);
+
+    std::vector<const dec::ArchiveEntry*> entries_to_read;
     for (const auto &entry : meta->entries)
+    {
+        const auto entry_path = parent_task->get_entry_path() / entry->path;
+        const auto is_selected
+            = !entry_filter || entry_filter->is_selected(entry_path);
+        const auto may_lead_to_selected = may_nest && (!entry_filter
+            || entry_filter->may_contain_selected(entry_path));
+
+        if (entry_lister && is_selected)
+            entry_lister->add(input_file->path, decoder_name, *entry);
+
+        // listing reads entries only to look for nested archives
+        if (may_lead_to_selected || (!entry_lister && is_selected))
+            entries_to_read.push_back(entry.get());
+    }
+
+    entries_to_read = order_entries(
+        entries_to_read, parent_task->task_context.scheduling_policy);
+
+    std::shared_ptr<ReadAhead> read_ahead;
+    const auto read_ahead_budget
+        = parent_task->task_context.read_ahead_budget;
+    if (read_ahead_budget
+        && !entries_to_read.empty()
+        && dynamic_cast<io::FileByteStream*>(&input_file->stream))
+    {
+        read_ahead = std::make_shared<ReadAhead>(
+            input_file, entries_to_read, read_ahead_budget);
+    }
+
+    // the tasks are pushed to the front, so the first one needs to go last
+    std::reverse(entries_to_read.begin(), entries_to_read.end());
+    for (const auto entry : entries_to_read)
     {
         parent_task->save_file(
             input_file,
-            [meta, &entry, &decoder, vfs_bridge]
+            [meta, entry, &decoder, vfs_bridge, read_ahead, profiler,
+                decoder_name = decoder_name]
             (io::File &input_file_copy, const Logger &logger)
             {
+                ProfileScope scope(
+                    profiler, decoder_name, ProfileStage::ReadFile);
+                if (read_ahead)
+                {
+                    if (auto stream = read_ahead->open(*entry))
+                    {
+                        io::File prefetched_file(
+                            input_file_copy.path, std::move(stream));
+                        return decoder.read_file(
+                            logger, prefetched_file, *meta, *entry);
+                    }
+                }
                 return decoder.read_file(
                     logger, input_file_copy, *meta, *entry);
             },
             decoder,
-            entry->path.str());
+            entry->path.str(),
+            estimate_memory(*entry));
     }
 }
 
 void ParallelDecoderAdapter::visit(const dec::BaseFileDecoder &decoder)
 {
+    if (parent_task->task_context.entry_lister)
+        return;
+    const auto profiler = parent_task->task_context.profiler;
     parent_task->save_file(
         input_file,
-        [&decoder](io::File &input_file_copy, const Logger &logger)
+        [&decoder, profiler, decoder_name = decoder_name]
+        (io::File &input_file_copy, const Logger &logger)
         {
+            ProfileScope scope(profiler, decoder_name, ProfileStage::Decode);
             return decoder.decode(logger, input_file_copy);
         },
-        decoder);
+        decoder,
+        "",
+        input_file->stream.size());
 }
 
 void ParallelDecoderAdapter::visit(const dec::BaseImageDecoder &decoder)
 {
+    if (parent_task->task_context.entry_lister)
+        return;
+    const auto profiler = parent_task->task_context.profiler;
     parent_task->save_file(
         input_file,
-        [&decoder](io::File &input_file_copy, const Logger &logger)
+        [&decoder, profiler, decoder_name = decoder_name]
+        (io::File &input_file_copy, const Logger &logger)
         {
+            ProfileScope decode_scope(
+                profiler, decoder_name, ProfileStage::Decode);
             auto output_file = decoder.decode(logger, input_file_copy);
+            decode_scope.finish();
+            ProfileScope encode_scope(
+                profiler, decoder_name, ProfileStage::Encode);
             const auto encoder = enc::png::PngImageEncoder();
             return encoder.encode(logger, output_file, input_file_copy.path);
         },
-        decoder);
+        decoder,
+        "",
+        input_file->stream.size() * decoded_media_expansion);
 }
 
 void ParallelDecoderAdapter::visit(const dec::BaseAudioDecoder &decoder)
 {
+    if (parent_task->task_context.entry_lister)
+        return;
+    const auto profiler = parent_task->task_context.profiler;
+    const auto &file_saver
+        = parent_task->task_context.unpacker_context.file_saver;
     parent_task->save_file(
         input_file,
-        [&decoder](io::File &input_file_copy, const Logger &logger)
+        [&decoder, &file_saver, profiler, decoder_name = decoder_name]
+        (io::File &input_file_copy, const Logger &logger)
         {
-            auto output_file = decoder.decode(logger, input_file_copy);
-            const auto encoder = enc::microsoft::WavAudioEncoder();
-            return encoder.encode(logger, output_file, input_file_copy.path);
+            // samples are encoded while they are being decoded, straight
+            // into the file the saver is going to keep
+            ProfileScope scope(profiler, decoder_name, ProfileStage::Decode);
+            const auto output_file
+                = file_saver.create_file(input_file_copy.path);
+            enc::microsoft::WavAudioSink sink(*output_file);
+            decoder.decode(logger, input_file_copy, sink);
+            return output_file;
         },
-        decoder);
+        decoder,
+        "",
+        input_file->stream.size() * decoded_media_expansion);
 }
@@ -43,9 +43,11 @@ namespace
             const std::set<std::string> &decoders_to_check,
             const InputFileFactory file_factory);
 
-        bool work() const override;
+        bool work_impl() const override;
+        std::string get_decoder_name() const override;
 
         const InputFileFactory file_factory;
+        mutable std::string decoder_name;
     };
 
     struct ProcessOutputFileTask final : public BaseParallelUnpackingTask
@@ -59,33 +61,53 @@ namespace
             const std::shared_ptr<io::File> input_file,
             const DecoderFileFactory file_factory,
             const std::shared_ptr<const dec::IDecoder> origin_decoder,
-            const std::string &target_name);
+            const std::string &target_name,
+            const size_t memory_estimate);
 
-        bool work() const override;
+        bool work_impl() const override;
+        io::path get_entry_path() const override;
+        size_t get_memory_estimate() const override;
 
         const std::shared_ptr<io::File> input_file;
         const DecoderFileFactory file_factory;
         const std::shared_ptr<const dec::IDecoder> origin_decoder;
         const std::string target_name;
+        const size_t memory_estimate;
     };
 }
 
 static bool save(
     const BaseParallelUnpackingTask &task, std::shared_ptr<io::File> file)
 {
+    if (task.task_context.entry_lister)
+        return true;
+    const auto entry_filter = task.task_context.entry_filter;
+    const auto entry_path = task.get_entry_path();
+    if (entry_filter
+        && !entry_path.str().empty()
+        && !entry_filter->is_selected(entry_path))
+    {
+        task.logger.info("not selected, skipping.\n");
+        return true;
+    }
     try
     {
+        ProfileScope scope(
+            task.task_context.profiler,
+            task.get_decoder_name(),
+            ProfileStage::Save,
+            file->stream.size());
         const auto full_path
             = task.task_context.unpacker_context.file_saver.save(file);
         task.logger.success("saved to %s\n", full_path.c_str());
-        task.logger.flush();
+        if (const auto input_path = task.get_manifest_input_path())
+            task.task_context.manifest->add_output(*input_path, full_path);
         return true;
     }
     catch (const err::IoError &e)
     {
         task.logger.err(
             "error saving (%s)\n", e.what() ? e.what() : "unknown error");
-        task.logger.flush();
         return false;
     }
 }
@@ -118,7 +140,8 @@ static std::shared_ptr<dec::IDecoder> guess_decoder(
     const BaseParallelUnpackingTask &task,
     const std::set<std::string> &decoders_to_check,
     io::File &file,
-    const TaskSourceType source_type)
+    const TaskSourceType source_type,
+    std::string &decoder_name)
 {
     task.logger.info(
         "guessing decoder among %d decoders...\n", decoders_to_check.size());
@@ -134,8 +157,8 @@ static std::shared_ptr<dec::IDecoder> guess_decoder(
 
     if (matching_decoders.size() == 1)
     {
-        task.logger.success(
-            "recognized as %s.\n", matching_decoders.begin()->first.c_str());
+        decoder_name = matching_decoders.begin()->first;
+        task.logger.success("recognized as %s.\n", decoder_name.c_str());
         return matching_decoders.begin()->second;
     }
 
@@ -188,7 +211,13 @@ ParallelTaskContext::ParallelTaskContext(
     TaskScheduler &task_scheduler) :
         unpacker(unpacker),
         unpacker_context(unpacker_context),
-        task_scheduler(task_scheduler)
+        task_scheduler(task_scheduler),
+        manifest(nullptr),
+        entry_lister(nullptr),
+        entry_filter(nullptr),
+        scheduling_policy(SchedulingPolicy::Default),
+        read_ahead_budget(0),
+        profiler(nullptr)
 {
 }
 
@@ -210,6 +239,30 @@ BaseParallelUnpackingTask::BaseParallelUnpackingTask(
     mutex.unlock();
     logger.set_prefix(
         algo::format("[task %d] %s: ", task_id, base_name.c_str()));
+    logger.enable_buffering();
+}
+
+bool BaseParallelUnpackingTask::work() const
+{
+    const auto result = work_impl();
+    logger.flush();
+    if (!result)
+    {
+        if (const auto input_path = get_manifest_input_path())
+            task_context.manifest->mark_failed(*input_path);
+    }
+    return result;
+}
+
+const io::path *BaseParallelUnpackingTask::get_manifest_input_path() const
+{
+    if (!task_context.manifest)
+        return nullptr;
+    auto task = this;
+    while (task->parent_task != nullptr)
+        task = task->parent_task.get();
+    const auto it = task_context.input_paths.find(task);
+    return it != task_context.input_paths.end() ? &it->second : nullptr;
 }
 
 size_t BaseParallelUnpackingTask::get_depth() const
@@ -224,11 +277,22 @@ size_t BaseParallelUnpackingTask::get_depth() const
     return depth;
 }
 
+io::path BaseParallelUnpackingTask::get_entry_path() const
+{
+    return parent_task ? parent_task->get_entry_path() : io::path();
+}
+
+std::string BaseParallelUnpackingTask::get_decoder_name() const
+{
+    return parent_task ? parent_task->get_decoder_name() : "";
+}
+
 void BaseParallelUnpackingTask::save_file(
     const std::shared_ptr<io::File> input_file,
     const DecoderFileFactory file_factory,
     const dec::BaseDecoder &origin_decoder,
-    const std::string &target_name) const
+    const std::string &target_name,
+    const size_t memory_estimate) const
 {
     task_context.task_scheduler.push_front(
         std::make_shared<ProcessOutputFileTask>(
@@ -241,7 +305,8 @@ void BaseParallelUnpackingTask::save_file(
             input_file,
             file_factory,
             origin_decoder.shared_from_this(),
-            target_name));
+            target_name,
+            memory_estimate));
 }
 
 DecodeInputFileTask::DecodeInputFileTask(
@@ -261,7 +326,7 @@ DecodeInputFileTask::DecodeInputFileTask(
 {
 }
 
-bool DecodeInputFileTask::work() const
+bool DecodeInputFileTask::work_impl() const
 {
     std::shared_ptr<io::File> input_file;
     try
@@ -281,10 +346,27 @@ bool DecodeInputFileTask::work() const
 
     try
     {
+        const auto manifest_input_path
+            = source_type == TaskSourceType::InitialUserInput
+                ? get_manifest_input_path()
+                : nullptr;
+        if (manifest_input_path)
+            task_context.manifest->begin_input(*manifest_input_path);
+
         logger.info("initial recognition...\n");
 
+        const auto recognition_begin = Profiler::Clock::now();
         const auto decoder = guess_decoder(
-            *this, decoders_to_check, *input_file, source_type);
+            *this, decoders_to_check, *input_file, source_type, decoder_name);
+        if (task_context.profiler)
+        {
+            task_context.profiler->add(
+                decoder_name,
+                ProfileStage::Recognition,
+                recognition_begin,
+                Profiler::Clock::now(),
+                input_file->stream.size());
+        }
 
         if (!decoder)
         {
@@ -292,6 +374,11 @@ bool DecodeInputFileTask::work() const
                 ? save(*this, input_file)
                 : false;
         }
+        if (manifest_input_path)
+        {
+            task_context.manifest->set_decoder(
+                *manifest_input_path, decoder_name);
+        }
 
         ArgParser decoder_arg_parser;
         const auto decorators = decoder->get_arg_parser_decorators();
@@ -301,7 +388,8 @@ bool DecodeInputFileTask::work() const
         for (const auto &decorator : decorators)
             decorator.parse_cli_options(decoder_arg_parser);
 
-        ParallelDecoderAdapter adapter(shared_from_this(), input_file);
+        ParallelDecoderAdapter adapter(
+            shared_from_this(), input_file, decoder_name);
         decoder->accept(adapter);
         return true;
     }
@@ -314,6 +402,13 @@ bool DecodeInputFileTask::work() const
     }
 }
 
+std::string DecodeInputFileTask::get_decoder_name() const
+{
+    return decoder_name.empty()
+        ? BaseParallelUnpackingTask::get_decoder_name()
+        : decoder_name;
+}
+
 ProcessOutputFileTask::ProcessOutputFileTask(
     ParallelTaskContext &task_context,
     const TaskSourceType source_type,
@@ -323,7 +418,8 @@ ProcessOutputFileTask::ProcessOutputFileTask(
     const std::shared_ptr<io::File> input_file,
     const DecoderFileFactory file_factory,
     const std::shared_ptr<const dec::IDecoder> origin_decoder,
-    const std::string &target_name) :
+    const std::string &target_name,
+    const size_t memory_estimate) :
         BaseParallelUnpackingTask(
             task_context,
             source_type,
@@ -333,11 +429,12 @@ ProcessOutputFileTask::ProcessOutputFileTask(
         input_file(input_file),
         file_factory(file_factory),
         origin_decoder(origin_decoder),
-        target_name(target_name)
+        target_name(target_name),
+        memory_estimate(memory_estimate)
 {
 }
 
-bool ProcessOutputFileTask::work() const
+bool ProcessOutputFileTask::work_impl() const
 {
     logger.info(
         target_name.empty()
@@ -420,6 +517,17 @@ bool ProcessOutputFileTask::work() const
     return true;
 }
 
+io::path ProcessOutputFileTask::get_entry_path() const
+{
+    const auto parent_path = BaseParallelUnpackingTask::get_entry_path();
+    return target_name.empty() ? parent_path : parent_path / target_name;
+}
+
+size_t ProcessOutputFileTask::get_memory_estimate() const
+{
+    return memory_estimate;
+}
+
 struct ParallelUnpacker::Priv final
 {
     Priv(
@@ -449,6 +557,41 @@ ParallelUnpacker::~ParallelUnpacker()
 {
 }
 
+void ParallelUnpacker::set_manifest(Manifest &manifest)
+{
+    p->task_context.manifest = &manifest;
+}
+
+void ParallelUnpacker::set_entry_lister(EntryLister &entry_lister)
+{
+    p->task_context.entry_lister = &entry_lister;
+}
+
+void ParallelUnpacker::set_entry_filter(const EntryFilter &entry_filter)
+{
+    p->task_context.entry_filter = &entry_filter;
+}
+
+void ParallelUnpacker::set_memory_budget(const size_t bytes)
+{
+    p->task_scheduler.set_memory_budget(bytes);
+}
+
+void ParallelUnpacker::set_scheduling_policy(const SchedulingPolicy policy)
+{
+    p->task_context.scheduling_policy = policy;
+}
+
+void ParallelUnpacker::set_read_ahead(const size_t bytes)
+{
+    p->task_context.read_ahead_budget = bytes;
+}
+
+void ParallelUnpacker::set_profiler(Profiler &profiler)
+{
+    p->task_context.profiler = &profiler;
+}
+
 void ParallelUnpacker::add_input_file(
     const io::path &base_name, const InputFileFactory file_factory)
 {
@@ -462,6 +605,30 @@ void ParallelUnpacker::add_input_file(
             file_factory));
 }
 
+void ParallelUnpacker::add_input_file(
+    const io::path &input_path,
+    const io::path &base_name,
+    const InputFileFactory file_factory)
+{
+    const auto manifest = p->task_context.manifest;
+    if (manifest && manifest->is_up_to_date(input_path))
+    {
+        Logger logger(p->unpacker_context.logger);
+        logger.info("%s: unchanged, skipping\n", input_path.c_str());
+        return;
+    }
+
+    const auto task = std::make_shared<DecodeInputFileTask>(
+        p->task_context,
+        TaskSourceType::InitialUserInput,
+        base_name,
+        nullptr,
+        p->unpacker_context.decoders_to_check,
+        file_factory);
+    p->task_context.input_paths[task.get()] = input_path;
+    p->task_scheduler.push_back(task);
+}
+
 bool ParallelUnpacker::run(const size_t thread_count)
 {
     const auto begin = std::chrono::steady_clock::now();
@@ -22,7 +22,12 @@
 #include <set>
 #include "dec/base_decoder.h"
 #include "dec/registry.h"
+#include "flow/entry_filter.h"
+#include "flow/entry_lister.h"
 #include "flow/ifile_saver.h"
+#include "flow/manifest.h"
+#include "flow/profiler.h"
+#include "flow/scheduling_policy.h"
 #include "flow/task_scheduler.h"
 #include "logger.h"
 
@@ -36,6 +41,7 @@ namespace flow {
     };
 
     class ParallelUnpacker;
+    struct BaseParallelUnpackingTask;
 
     using InputFileFactory = std::function<std::shared_ptr<io::File>()>;
     using DecoderFileFactory
@@ -69,6 +75,15 @@ namespace flow {
         ParallelUnpacker &unpacker;
         const ParallelUnpackerContext &unpacker_context;
         TaskScheduler &task_scheduler;
+
+        // set up before the tasks start running
+        Manifest *manifest;
+        EntryLister *entry_lister;
+        const EntryFilter *entry_filter;
+        SchedulingPolicy scheduling_policy;
+        size_t read_ahead_budget;
+        Profiler *profiler;
+        std::map<const BaseParallelUnpackingTask*, io::path> input_paths;
     };
 
     struct BaseParallelUnpackingTask :
@@ -84,13 +99,20 @@ namespace flow {
 
         virtual ~BaseParallelUnpackingTask() {}
 
+        bool work() const override;
+        virtual bool work_impl() const = 0;
+
         size_t get_depth() const;
+        virtual io::path get_entry_path() const;
+        virtual std::string get_decoder_name() const;
+        const io::path *get_manifest_input_path() const;
 
         void save_file(
             const std::shared_ptr<io::File> input_file,
             const DecoderFileFactory,
             const dec::BaseDecoder &origin_decoder,
-            const std::string &custom_name = "") const;
+            const std::string &custom_name = "",
+            const size_t memory_estimate = 0) const;
 
         Logger logger;
         ParallelTaskContext &task_context;
@@ -106,7 +128,33 @@ namespace flow {
         ParallelUnpacker(const ParallelUnpackerContext &unpacker_context);
         ~ParallelUnpacker();
 
+        void set_manifest(Manifest &manifest);
+
+        // lists archive entries instead of saving any files
+        void set_entry_lister(EntryLister &entry_lister);
+
+        // skips archive entries that cannot lead to a selected file
+        void set_entry_filter(const EntryFilter &entry_filter);
+
+        void set_memory_budget(const size_t bytes);
+
+        // decides in which order entries of each archive are decoded
+        void set_scheduling_policy(const SchedulingPolicy policy);
+
+        // prefetches entries of archives on disk, holding at most given
+        // number of bytes per archive
+        void set_read_ahead(const size_t bytes);
+
+        // records time spent by the tasks in each stage
+        void set_profiler(Profiler &profiler);
+
         void add_input_file(const io::path &base_name, const InputFileFactory);
+
+        // skips the file if the manifest says it did not change
+        void add_input_file(
+            const io::path &input_path,
+            const io::path &base_name,
+            const InputFileFactory);
         bool run(const size_t thread_count = 0);
 
     private:
@@ -0,0 +1,269 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/profiler.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "algo/format.h"
+#include "algo/range.h"
+#include "io/file_byte_stream.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct Event final
+    {
+        std::string decoder_name;
+        ProfileStage stage;
+        Profiler::Clock::time_point begin;
+        Profiler::Clock::time_point end;
+        uoff_t bytes;
+        size_t thread_number;
+    };
+
+    struct DecoderSummary final
+    {
+        std::string decoder_name;
+        std::map<ProfileStage, double> stage_times;
+        double total_time = 0;
+        size_t input_count = 0;
+        uoff_t bytes_in = 0;
+        uoff_t bytes_out = 0;
+    };
+}
+
+static const std::vector<std::pair<ProfileStage, std::string>> stage_names
+{
+    {ProfileStage::Recognition, "recognize"},
+    {ProfileStage::ReadMeta,    "read_meta"},
+    {ProfileStage::ReadFile,    "read_file"},
+    {ProfileStage::Decode,      "decode"},
+    {ProfileStage::Encode,      "encode"},
+    {ProfileStage::Save,        "save"},
+};
+
+static std::string get_stage_name(const ProfileStage stage)
+{
+    for (const auto &it : stage_names)
+        if (it.first == stage)
+            return it.second;
+    return "?";
+}
+
+static double to_seconds(const Profiler::Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+        .count() / 1000000.0;
+}
+
+static std::string escape(const std::string &input)
+{
+    std::string output;
+    for (const auto c : input)
+    {
+        if (c == '"' || c == '\\')
+            output += '\\';
+        if (static_cast<u8>(c) >= 0x20)
+            output += c;
+    }
+    return output;
+}
+
+struct Profiler::Priv final
+{
+    Priv();
+
+    mutable std::mutex mutex;
+    std::vector<Event> events;
+    std::map<std::thread::id, size_t> thread_numbers;
+    const Clock::time_point start;
+};
+
+Profiler::Priv::Priv() : start(Clock::now())
+{
+}
+
+Profiler::Profiler() : p(new Priv)
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::add(
+    const std::string &decoder_name,
+    const ProfileStage stage,
+    const Clock::time_point begin,
+    const Clock::time_point end,
+    const uoff_t bytes)
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    const auto thread_id = std::this_thread::get_id();
+    if (p->thread_numbers.find(thread_id) == p->thread_numbers.end())
+    {
+        const auto thread_number = p->thread_numbers.size();
+        p->thread_numbers[thread_id] = thread_number;
+    }
+    Event event;
+    event.decoder_name = decoder_name.empty() ? "(none)" : decoder_name;
+    event.stage = stage;
+    event.begin = begin;
+    event.end = end;
+    event.bytes = bytes;
+    event.thread_number = p->thread_numbers[thread_id];
+    p->events.push_back(event);
+}
+
+void Profiler::print_summary(const Logger &logger) const
+{
+    std::map<std::string, DecoderSummary> summaries;
+    {
+        std::unique_lock<std::mutex> lock(p->mutex);
+        for (const auto &event : p->events)
+        {
+            auto &summary = summaries[event.decoder_name];
+            summary.decoder_name = event.decoder_name;
+            const auto time = to_seconds(event.end - event.begin);
+            summary.stage_times[event.stage] += time;
+            summary.total_time += time;
+            if (event.stage == ProfileStage::Recognition)
+            {
+                summary.input_count++;
+                summary.bytes_in += event.bytes;
+            }
+            else if (event.stage == ProfileStage::Save)
+            {
+                summary.bytes_out += event.bytes;
+            }
+        }
+    }
+
+    std::vector<DecoderSummary> sorted_summaries;
+    for (const auto &it : summaries)
+        sorted_summaries.push_back(it.second);
+    std::sort(
+        sorted_summaries.begin(),
+        sorted_summaries.end(),
+        [](const DecoderSummary &a, const DecoderSummary &b)
+        {
+            return a.total_time > b.total_time;
+        });
+
+    logger.log(
+        Logger::MessageType::Summary,
+        "%-24s %6s %8s",
+        "decoder",
+        "inputs",
+        "time");
+    for (const auto &it : stage_names)
+        logger.log(Logger::MessageType::Summary, " %9s", it.second.c_str());
+    logger.log(
+        Logger::MessageType::Summary,
+        " %9s %9s %8s\n",
+        "MiB in",
+        "MiB out",
+        "MiB/s");
+
+    for (const auto &summary : sorted_summaries)
+    {
+        logger.log(
+            Logger::MessageType::Summary,
+            "%-24s %6d %7.3fs",
+            summary.decoder_name.c_str(),
+            static_cast<int>(summary.input_count),
+            summary.total_time);
+        for (const auto &it : stage_names)
+        {
+            const auto time_it = summary.stage_times.find(it.first);
+            logger.log(
+                Logger::MessageType::Summary,
+                " %8.3fs",
+                time_it == summary.stage_times.end() ? 0.0 : time_it->second);
+        }
+        const auto mib_in = summary.bytes_in / 1024.0 / 1024.0;
+        logger.log(
+            Logger::MessageType::Summary,
+            " %9.2f %9.2f %8.2f\n",
+            mib_in,
+            summary.bytes_out / 1024.0 / 1024.0,
+            summary.total_time > 0 ? mib_in / summary.total_time : 0.0);
+    }
+}
+
+void Profiler::save_trace(const io::path &path) const
+{
+    io::FileByteStream output_stream(path, io::FileMode::Write);
+    output_stream.write("{\"traceEvents\":[");
+    std::unique_lock<std::mutex> lock(p->mutex);
+    for (const auto i : algo::range(p->events.size()))
+    {
+        const auto &event = p->events[i];
+        const auto begin = std::chrono::duration_cast<
+            std::chrono::microseconds>(event.begin - p->start).count();
+        const auto duration = std::chrono::duration_cast<
+            std::chrono::microseconds>(event.end - event.begin).count();
+        output_stream.write(algo::format(
+            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                "\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"bytes\":%llu}}",
+            i ? "," : "",
+            get_stage_name(event.stage).c_str(),
+            escape(event.decoder_name).c_str(),
+            static_cast<long long>(begin),
+            static_cast<long long>(duration),
+            static_cast<int>(event.thread_number),
+            static_cast<unsigned long long>(event.bytes)));
+    }
+    output_stream.write("\n]}\n");
+}
+
+ProfileScope::ProfileScope(
+    Profiler *profiler,
+    const std::string &decoder_name,
+    const ProfileStage stage,
+    const uoff_t bytes) :
+        profiler(profiler),
+        decoder_name(decoder_name),
+        stage(stage),
+        begin(Profiler::Clock::now()),
+        bytes(bytes)
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+    finish();
+}
+
+void ProfileScope::finish()
+{
+    if (!profiler)
+        return;
+    profiler->add(decoder_name, stage, begin, Profiler::Clock::now(), bytes);
+    profiler = nullptr;
+}
+
+void ProfileScope::set_bytes(const uoff_t bytes)
+{
+    this->bytes = bytes;
+}
@@ -0,0 +1,88 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include "io/path.h"
+#include "logger.h"
+#include "types.h"
+
+namespace au {
+namespace flow {
+
+    enum class ProfileStage : u8
+    {
+        Recognition,
+        ReadMeta,
+        ReadFile,
+        Decode,
+        Encode,
+        Save,
+    };
+
+    // Collects how long each task spent in each stage, per decoder.
+    class Profiler final
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        Profiler();
+        ~Profiler();
+
+        // for Recognition, bytes count toward the input; for Save, toward
+        // the output
+        void add(
+            const std::string &decoder_name,
+            const ProfileStage stage,
+            const Clock::time_point begin,
+            const Clock::time_point end,
+            const uoff_t bytes);
+
+        void print_summary(const Logger &logger) const;
+        void save_trace(const io::path &path) const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+    // measures the lifetime of the object; does nothing without a profiler
+    class ProfileScope final
+    {
+    public:
+        ProfileScope(
+            Profiler *profiler,
+            const std::string &decoder_name,
+            const ProfileStage stage,
+            const uoff_t bytes = 0);
+        ~ProfileScope();
+
+        void set_bytes(const uoff_t bytes);
+        void finish();
+
+    private:
+        Profiler *profiler;
+        const std::string decoder_name;
+        const ProfileStage stage;
+        const Profiler::Clock::time_point begin;
+        uoff_t bytes;
+    };
+
+} }
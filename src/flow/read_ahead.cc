@@ -0,0 +1,364 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/read_ahead.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "algo/range.h"
+#include "err.h"
+
+using namespace au;
+using namespace au::flow;
+
+static const uoff_t max_gap = 64 * 1024;
+static const uoff_t max_chunk_size = 4 * 1024 * 1024;
+
+namespace
+{
+    struct Chunk final
+    {
+        uoff_t offset;
+        uoff_t size;
+        std::shared_ptr<const bstr> data;
+        size_t consumer_count;
+        bool done;
+    };
+
+    struct State final
+    {
+        bool can_admit(const Chunk &chunk) const;
+        bool is_reader_blocked() const;
+        void release(const size_t chunk_id);
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<Chunk> chunks;
+        std::map<const dec::ArchiveEntry*, size_t> chunk_ids;
+        std::shared_ptr<io::File> input_file;
+        uoff_t input_size;
+        size_t budget;
+        size_t held;
+        size_t next_chunk_id;
+        bool reader_waiting;
+        bool stop;
+    };
+
+    struct Lease final
+    {
+        Lease(const std::shared_ptr<State> state, const size_t chunk_id);
+        ~Lease();
+
+        const std::shared_ptr<State> state;
+        const size_t chunk_id;
+    };
+
+    class PrefetchedByteStream final : public io::BaseByteStream
+    {
+    public:
+        PrefetchedByteStream(
+            const std::shared_ptr<const Lease> lease,
+            const std::shared_ptr<const bstr> data,
+            const uoff_t data_offset,
+            const uoff_t stream_size,
+            const std::shared_ptr<io::File> source);
+
+        uoff_t size() const override;
+        uoff_t pos() const override;
+        std::unique_ptr<BaseByteStream> clone() const override;
+
+    protected:
+        void read_impl(void *destination, const size_t size) override;
+        void write_impl(const void *source, const size_t size) override;
+        void seek_impl(const uoff_t offset) override;
+        void resize_impl(const uoff_t new_size) override;
+
+    private:
+        const std::shared_ptr<const Lease> lease;
+        const std::shared_ptr<const bstr> data;
+        const uoff_t data_offset;
+        const uoff_t stream_size;
+        const std::shared_ptr<io::File> source;
+        std::unique_ptr<io::BaseByteStream> fallback_stream;
+        uoff_t position;
+    };
+}
+
+static bool get_range(
+    const dec::ArchiveEntry &entry, uoff_t &offset, uoff_t &size)
+{
+    dec::ArchiveEntryRange range;
+    if (!dec::get_entry_range(entry, range))
+        return false;
+    offset = range.offset;
+    size = range.size_stored;
+    return size > 0;
+}
+
+bool State::can_admit(const Chunk &chunk) const
+{
+    return stop
+        || !chunk.consumer_count
+        || !held
+        || held + chunk.size <= budget;
+}
+
+bool State::is_reader_blocked() const
+{
+    return reader_waiting && !can_admit(chunks[next_chunk_id]);
+}
+
+void State::release(const size_t chunk_id)
+{
+    // must be called with the mutex locked
+    auto &chunk = chunks[chunk_id];
+    chunk.consumer_count--;
+    if (!chunk.consumer_count && chunk.data)
+    {
+        held -= chunk.size;
+        chunk.data.reset();
+    }
+    condition.notify_all();
+}
+
+Lease::Lease(const std::shared_ptr<State> state, const size_t chunk_id)
+    : state(state), chunk_id(chunk_id)
+{
+}
+
+Lease::~Lease()
+{
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->release(chunk_id);
+}
+
+PrefetchedByteStream::PrefetchedByteStream(
+    const std::shared_ptr<const Lease> lease,
+    const std::shared_ptr<const bstr> data,
+    const uoff_t data_offset,
+    const uoff_t stream_size,
+    const std::shared_ptr<io::File> source) :
+        lease(lease),
+        data(data),
+        data_offset(data_offset),
+        stream_size(stream_size),
+        source(source),
+        position(0)
+{
+}
+
+uoff_t PrefetchedByteStream::size() const
+{
+    return stream_size;
+}
+
+uoff_t PrefetchedByteStream::pos() const
+{
+    return position;
+}
+
+std::unique_ptr<io::BaseByteStream> PrefetchedByteStream::clone() const
+{
+    auto ret = std::make_unique<PrefetchedByteStream>(
+        lease, data, data_offset, stream_size, source);
+    ret->seek(position);
+    return std::move(ret);
+}
+
+void PrefetchedByteStream::read_impl(void *destination, const size_t size)
+{
+    if (position >= data_offset
+        && position + size <= data_offset + data->size())
+    {
+        std::memcpy(
+            destination, data->get<u8>() + position - data_offset, size);
+    }
+    else
+    {
+        if (!fallback_stream)
+            fallback_stream = source->stream.clone();
+        const auto chunk = fallback_stream->seek(position).read(size);
+        std::memcpy(destination, chunk.get<u8>(), size);
+    }
+    position += size;
+}
+
+void PrefetchedByteStream::write_impl(const void *source, const size_t size)
+{
+    throw err::NotSupportedError("Prefetched streams are read-only");
+}
+
+void PrefetchedByteStream::seek_impl(const uoff_t offset)
+{
+    if (offset > stream_size)
+        throw err::EofError();
+    position = offset;
+}
+
+void PrefetchedByteStream::resize_impl(const uoff_t new_size)
+{
+    throw err::NotSupportedError("Prefetched streams are read-only");
+}
+
+static void read_chunks(
+    const std::shared_ptr<State> state,
+    const std::unique_ptr<io::BaseByteStream> input_stream)
+{
+    for (const auto chunk_id : algo::range(state->chunks.size()))
+    {
+        auto &chunk = state->chunks[chunk_id];
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->next_chunk_id = chunk_id;
+            state->reader_waiting = true;
+            state->condition.notify_all();
+            state->condition.wait(
+                lock, [&]() { return state->can_admit(chunk); });
+            state->reader_waiting = false;
+            if (state->stop)
+                return;
+            if (!chunk.consumer_count)
+            {
+                chunk.done = true;
+                continue;
+            }
+            state->held += chunk.size;
+        }
+
+        std::shared_ptr<const bstr> data;
+        try
+        {
+            data = std::make_shared<const bstr>(
+                input_stream->seek(chunk.offset).read(chunk.size));
+        }
+        catch (const std::exception &)
+        {
+        }
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (data && chunk.consumer_count)
+            chunk.data = data;
+        else
+            state->held -= chunk.size;
+        chunk.done = true;
+        state->condition.notify_all();
+    }
+}
+
+struct ReadAhead::Priv final
+{
+    std::shared_ptr<State> state;
+    std::thread thread;
+};
+
+ReadAhead::ReadAhead(
+    const std::shared_ptr<io::File> input_file,
+    const std::vector<const dec::ArchiveEntry*> &entries,
+    const size_t budget) : p(new Priv)
+{
+    p->state = std::make_shared<State>();
+    auto &state = *p->state;
+    state.input_file = input_file;
+    state.input_size = input_file->stream.size();
+    state.budget = budget;
+    state.held = 0;
+    state.next_chunk_id = 0;
+    state.reader_waiting = false;
+    state.stop = false;
+
+    for (const auto entry : entries)
+    {
+        uoff_t offset, size;
+        if (!get_range(*entry, offset, size))
+            continue;
+
+        if (!state.chunks.empty())
+        {
+            auto &last_chunk = state.chunks.back();
+            const auto last_end = last_chunk.offset + last_chunk.size;
+            const auto start = std::min(last_chunk.offset, offset);
+            const auto end = std::max(last_end, offset + size);
+            if (offset <= last_end + max_gap
+                && offset + size + max_gap >= last_chunk.offset
+                && end - start <= max_chunk_size)
+            {
+                last_chunk.offset = start;
+                last_chunk.size = end - start;
+                last_chunk.consumer_count++;
+                state.chunk_ids[entry] = state.chunks.size() - 1;
+                continue;
+            }
+        }
+
+        Chunk chunk;
+        chunk.offset = offset;
+        chunk.size = size;
+        chunk.consumer_count = 1;
+        chunk.done = false;
+        state.chunks.push_back(chunk);
+        state.chunk_ids[entry] = state.chunks.size() - 1;
+    }
+
+    p->thread = std::thread(
+        read_chunks,
+        p->state,
+        std::unique_ptr<io::BaseByteStream>(input_file->stream.clone()));
+}
+
+ReadAhead::~ReadAhead()
+{
+    {
+        std::unique_lock<std::mutex> lock(p->state->mutex);
+        p->state->stop = true;
+        p->state->condition.notify_all();
+    }
+    p->thread.join();
+}
+
+std::unique_ptr<io::BaseByteStream> ReadAhead::open(
+    const dec::ArchiveEntry &entry)
+{
+    auto &state = *p->state;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    const auto it = state.chunk_ids.find(&entry);
+    if (it == state.chunk_ids.end())
+        return nullptr;
+    const auto chunk_id = it->second;
+    state.chunk_ids.erase(it);
+
+    auto &chunk = state.chunks[chunk_id];
+    // when the reader is blocked on the budget, waiting could deadlock
+    state.condition.wait(lock, [&]()
+    {
+        return chunk.done || state.stop || state.is_reader_blocked();
+    });
+    if (!chunk.data)
+    {
+        state.release(chunk_id);
+        return nullptr;
+    }
+
+    return std::make_unique<PrefetchedByteStream>(
+        std::make_shared<Lease>(p->state, chunk_id),
+        chunk.data,
+        chunk.offset,
+        state.input_size,
+        state.input_file);
+}
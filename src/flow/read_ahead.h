@@ -0,0 +1,51 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "dec/base_archive_decoder.h"
+#include "io/file.h"
+
+namespace au {
+namespace flow {
+
+    // Reads byte ranges of upcoming archive entries on a background thread,
+    // merging nearby ranges into larger reads, so that decoding threads do
+    // not have to wait for the disk. At most budget bytes are held at once.
+    class ReadAhead final
+    {
+    public:
+        // entries need to be given in the order they are going to be opened
+        ReadAhead(
+            const std::shared_ptr<io::File> input_file,
+            const std::vector<const dec::ArchiveEntry*> &entries,
+            const size_t budget);
+        ~ReadAhead();
+
+        // returns nullptr if the entry could not be prefetched, in which
+        // case the caller should read it by itself
+        std::unique_ptr<io::BaseByteStream> open(
+            const dec::ArchiveEntry &entry);
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
@@ -0,0 +1,72 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/scheduling_policy.h"
+#include <algorithm>
+#include <limits>
+
+using namespace au;
+using namespace au::flow;
+
+static uoff_t get_size(const dec::ArchiveEntry &entry)
+{
+    dec::ArchiveEntryRange range;
+    return dec::get_entry_range(entry, range) ? range.size_orig : 0;
+}
+
+static uoff_t get_offset(const dec::ArchiveEntry &entry)
+{
+    dec::ArchiveEntryRange range;
+    return dec::get_entry_range(entry, range)
+        ? range.offset
+        : std::numeric_limits<uoff_t>::max();
+}
+
+std::vector<const dec::ArchiveEntry*> flow::order_entries(
+    const std::vector<const dec::ArchiveEntry*> &entries,
+    const SchedulingPolicy policy)
+{
+    std::vector<const dec::ArchiveEntry*> ordered_entries(
+        entries.begin(), entries.end());
+
+    if (policy == SchedulingPolicy::Default)
+    {
+        std::reverse(ordered_entries.begin(), ordered_entries.end());
+    }
+    else if (policy == SchedulingPolicy::LargestFirst)
+    {
+        std::stable_sort(
+            ordered_entries.begin(),
+            ordered_entries.end(),
+            [](const dec::ArchiveEntry *a, const dec::ArchiveEntry *b)
+            {
+                return get_size(*a) > get_size(*b);
+            });
+    }
+    else if (policy == SchedulingPolicy::OffsetOrder)
+    {
+        std::stable_sort(
+            ordered_entries.begin(),
+            ordered_entries.end(),
+            [](const dec::ArchiveEntry *a, const dec::ArchiveEntry *b)
+            {
+                return get_offset(*a) < get_offset(*b);
+            });
+    }
+
+    return ordered_entries;
+}
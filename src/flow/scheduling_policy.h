@@ -0,0 +1,38 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+#include "dec/base_archive_decoder.h"
+
+namespace au {
+namespace flow {
+
+    enum class SchedulingPolicy : u8
+    {
+        Default,      // last entry in the metadata starts first
+        LargestFirst, // shortens the tail when one entry dominates
+        OffsetOrder,  // keeps reads sequential on spinning disks
+    };
+
+    // returns the entries in the order they should start decoding
+    std::vector<const dec::ArchiveEntry*> order_entries(
+        const std::vector<const dec::ArchiveEntry*> &entries,
+        const SchedulingPolicy policy);
+
+} }
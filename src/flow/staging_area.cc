@@ -0,0 +1,109 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/staging_area.h"
+#include <map>
+#include <mutex>
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct StagedFile final
+    {
+        std::weak_ptr<io::File> file;
+        io::FileByteStream *stream;
+        io::path path;
+    };
+}
+
+struct StagingArea::Priv final
+{
+    Priv(const io::path &dir);
+
+    io::path dir;
+    std::mutex mutex;
+    std::map<const io::File*, StagedFile> staged_files;
+};
+
+StagingArea::Priv::Priv(const io::path &dir) : dir(dir)
+{
+}
+
+StagingArea::StagingArea(const io::path &dir) : p(new Priv(dir))
+{
+}
+
+StagingArea::~StagingArea()
+{
+}
+
+std::shared_ptr<io::File> StagingArea::create_file(
+    const io::path &path) const
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    for (auto it = p->staged_files.begin(); it != p->staged_files.end(); )
+    {
+        if (it->second.file.expired())
+            it = p->staged_files.erase(it);
+        else
+            ++it;
+    }
+
+    io::create_directories(p->dir);
+    StagedFile staged_file;
+    staged_file.path = io::unique_path(p->dir);
+    auto stream = std::make_unique<io::FileByteStream>(
+        staged_file.path, io::FileMode::Write);
+    staged_file.stream = stream.get();
+
+    const auto staged_path = staged_file.path;
+    const std::shared_ptr<io::File> file(
+        new io::File(path, std::move(stream)),
+        [staged_path](io::File *file)
+        {
+            delete file;
+            try
+            {
+                if (io::exists(staged_path))
+                    io::remove(staged_path);
+            }
+            catch (...)
+            {
+            }
+        });
+    staged_file.file = file;
+    p->staged_files[file.get()] = staged_file;
+    return file;
+}
+
+bool StagingArea::move(
+    const std::shared_ptr<io::File> file, const io::path &target_path) const
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    const auto it = p->staged_files.find(file.get());
+    if (it == p->staged_files.end() || it->second.file.lock() != file)
+        return false;
+    it->second.stream->flush();
+    if (!io::rename(it->second.path, target_path))
+        return false;
+    p->staged_files.erase(it);
+    return true;
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include "io/file.h"
+
+namespace au {
+namespace flow {
+
+    // Hands out files that are written straight to a temporary file in the
+    // given directory rather than to memory. Once complete, they're moved
+    // into place instead of being copied. Files that are never moved are
+    // removed together with their last reference.
+    class StagingArea final
+    {
+    public:
+        StagingArea(const io::path &dir);
+        ~StagingArea();
+
+        std::shared_ptr<io::File> create_file(const io::path &path) const;
+
+        // Returns false if the file doesn't come from this area or can't be
+        // moved, in which case it has to be copied.
+        bool move(
+            const std::shared_ptr<io::File> file,
+            const io::path &target_path) const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
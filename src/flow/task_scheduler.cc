@@ -27,10 +27,27 @@ using namespace au::flow;
 
 struct TaskScheduler::Priv final
 {
+    Priv();
+
+    bool can_admit(const size_t memory_estimate) const;
+
     std::deque<std::shared_ptr<ITask>> tasks;
     std::vector<std::unique_ptr<std::thread>> threads;
+    size_t memory_budget;
+    size_t memory_in_use;
 };
 
+TaskScheduler::Priv::Priv() : memory_budget(0), memory_in_use(0)
+{
+}
+
+bool TaskScheduler::Priv::can_admit(const size_t memory_estimate) const
+{
+    return !memory_budget
+        || !memory_in_use
+        || memory_in_use + memory_estimate <= memory_budget;
+}
+
 TaskScheduler::TaskScheduler() : p(new Priv())
 {
 }
@@ -51,6 +68,12 @@ void TaskScheduler::push_back(std::shared_ptr<ITask> task)
     p->tasks.push_back(task);
 }
 
+void TaskScheduler::set_memory_budget(const size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    p->memory_budget = bytes;
+}
+
 TaskSchedulerResult TaskScheduler::run(size_t number_of_threads)
 {
     if (!number_of_threads)
@@ -70,6 +93,7 @@ TaskSchedulerResult TaskScheduler::run(size_t number_of_threads)
             while (true)
             {
                 std::shared_ptr<ITask> task;
+                size_t memory_estimate;
 
                 {
                     std::unique_lock<std::mutex> lock(mutex);
@@ -84,8 +108,19 @@ TaskSchedulerResult TaskScheduler::run(size_t number_of_threads)
                         }
                         break;
                     }
+                    // the front task is never overtaken, so that large tasks
+                    // eventually get to run
+                    memory_estimate = p->tasks.front()->get_memory_estimate();
+                    if (!p->can_admit(memory_estimate))
+                    {
+                        lock.unlock();
+                        std::this_thread::sleep_for(
+                            std::chrono::milliseconds(10));
+                        continue;
+                    }
                     task = p->tasks.front();
                     p->tasks.pop_front();
+                    p->memory_in_use += memory_estimate;
                 }
 
                 const auto local_success = task->work();
@@ -94,6 +129,7 @@ TaskSchedulerResult TaskScheduler::run(size_t number_of_threads)
                     std::unique_lock<std::mutex> lock(mutex);
                     result.success_count += local_success;
                     result.error_count += !local_success;
+                    p->memory_in_use -= memory_estimate;
                     still_running = !p->tasks.empty();
                 }
             }
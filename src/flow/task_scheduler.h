@@ -28,6 +28,9 @@ namespace flow {
     public:
         virtual ~ITask() {}
         virtual bool work() const = 0;
+
+        // bytes the task is expected to hold while working
+        virtual size_t get_memory_estimate() const { return 0; }
     };
 
     struct TaskSchedulerResult final
@@ -42,6 +45,11 @@ namespace flow {
         TaskScheduler();
         ~TaskScheduler();
         TaskSchedulerResult run(const size_t number_of_threads = 0);
+
+        // tasks are started only while their estimates fit in the budget;
+        // a task that does not fit at all waits until it can run alone
+        void set_memory_budget(const size_t bytes);
+
         void push_front(std::shared_ptr<ITask> task);
         void push_back(std::shared_ptr<ITask> task);
         void join();
@@ -60,6 +60,11 @@ File::File(const io::path &path, const bstr &data) :
 {
 }
 
+File::File(const io::path &path, bstr &&data) :
+    File(path, std::make_unique<MemoryByteStream>(std::move(data)))
+{
+}
+
 File::File() : File("", std::make_unique<MemoryByteStream>())
 {
 }
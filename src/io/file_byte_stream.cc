@@ -75,6 +75,10 @@ struct FileByteStream::Priv final
                 throw err::IoError("Could not write full data");
         }
 
+        void flush()
+        {
+        }
+
         int fd;
     #else
         Priv(const path &path, FileMode mode) : path(path), mode(mode)
@@ -115,6 +119,12 @@ struct FileByteStream::Priv final
                 throw err::IoError("Could not write full data");
         }
 
+        void flush()
+        {
+            if (fflush(fd) != 0)
+                throw err::IoError("Could not flush data");
+        }
+
         FILE *fd;
     #endif
 
@@ -171,9 +181,17 @@ void FileByteStream::resize_impl(const uoff_t new_size)
     throw err::NotSupportedError("Truncating real files is not implemented");
 }
 
+void FileByteStream::flush()
+{
+    p->flush();
+}
+
 std::unique_ptr<io::BaseByteStream> FileByteStream::clone() const
 {
-    auto ret = std::make_unique<FileByteStream>(p->path, p->mode);
+    // reopening for writing would truncate the file
+    if (p->mode == FileMode::Write)
+        p->flush();
+    auto ret = std::make_unique<FileByteStream>(p->path, FileMode::Read);
     ret->seek(pos());
     return std::move(ret);
 }
@@ -40,6 +40,9 @@ namespace io {
         uoff_t size() const override;
         uoff_t pos() const override;
 
+        // Pushes buffered writes to the file system.
+        void flush();
+
         std::unique_ptr<BaseByteStream> clone() const override;
 
     protected:
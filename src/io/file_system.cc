@@ -46,6 +46,16 @@ path io::absolute(const path &p)
     return boost::filesystem::absolute(p.str()).string();
 }
 
+uoff_t io::file_size(const path &p)
+{
+    return boost::filesystem::file_size(p.str());
+}
+
+std::time_t io::last_write_time(const path &p)
+{
+    return boost::filesystem::last_write_time(p.str());
+}
+
 void io::create_directories(const path &p)
 {
     const auto bp = boost::filesystem::path(p.str());
@@ -57,3 +67,23 @@ void io::remove(const path &p)
 {
     boost::filesystem::remove(p.str());
 }
+
+bool io::create_hard_link(const path &target, const path &link)
+{
+    boost::system::error_code error;
+    boost::filesystem::create_hard_link(target.str(), link.str(), error);
+    return !error;
+}
+
+bool io::rename(const path &source, const path &target)
+{
+    boost::system::error_code error;
+    boost::filesystem::rename(source.str(), target.str(), error);
+    return !error;
+}
+
+path io::unique_path(const path &dir)
+{
+    const auto name = boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+    return dir / name.string();
+}
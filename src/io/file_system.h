@@ -17,8 +17,10 @@
 
 #pragma once
 
+#include <ctime>
 #include <boost/filesystem.hpp>
 #include "io/path.h"
+#include "types.h"
 
 namespace au {
 namespace io {
@@ -28,9 +30,16 @@ namespace io {
     bool is_directory(const path &p);
     bool is_regular_file(const path &p);
     path absolute(const path &p);
+    uoff_t file_size(const path &p);
+    std::time_t last_write_time(const path &p);
 
     void create_directories(const path &p);
     void remove(const path &p);
+    bool create_hard_link(const path &target, const path &link);
+    bool rename(const path &source, const path &target);
+
+    // random name within given directory that is unlikely to be taken
+    path unique_path(const path &dir);
 
     template<typename T> class BaseDirectoryRange final
     {
@@ -37,6 +37,11 @@ MemoryByteStream::MemoryByteStream(const bstr &buffer)
 {
 }
 
+MemoryByteStream::MemoryByteStream(bstr &&buffer)
+    : MemoryByteStream(std::make_shared<bstr>(std::move(buffer)))
+{
+}
+
 MemoryByteStream::MemoryByteStream(const char *buffer, const size_t buffer_size)
     : MemoryByteStream(std::make_shared<bstr>(buffer, buffer_size))
 {
@@ -31,6 +31,7 @@ namespace io {
         MemoryByteStream();
         MemoryByteStream(const char *buffer, const size_t buffer_size);
         MemoryByteStream(const bstr &buffer);
+        MemoryByteStream(bstr &&buffer);
         MemoryByteStream(BaseByteStream &other_stream, const size_t size);
         MemoryByteStream(BaseByteStream &other_stream);
         ~MemoryByteStream();
@@ -19,24 +19,46 @@
 #include <cstdarg>
 #include <iostream>
 #include <mutex>
+#include <vector>
 #include "algo/format.h"
 #include "algo/str.h"
 
 using namespace au;
 
+static const size_t max_buffer_size = 64 * 1024;
+
 static std::mutex mutex;
 
+namespace
+{
+    struct Message final
+    {
+        Logger::MessageType type;
+        std::string text;
+    };
+}
+
 struct Logger::Priv final
 {
     Priv(Logger &logger);
     void log(
         const MessageType type, const std::string fmt, std::va_list args) const;
+    void write(const MessageType type, const std::string &text) const;
+    void drain() const;
+    void write_buffer() const;
 
     Logger &logger;
     Color colors[6];
     int muted = 0;
     bool colors_enabled = true;
+    bool buffering_enabled = false;
     std::string prefix;
+
+    // a task's logger is also used by virtual file system lookups that run
+    // on other threads; taken before the global mutex
+    mutable std::mutex buffer_mutex;
+    mutable std::vector<Message> buffer;
+    mutable size_t buffer_size = 0;
 };
 
 Logger::Priv::Priv(Logger &logger) : logger(logger)
@@ -52,14 +74,57 @@ Logger::Priv::Priv(Logger &logger) : logger(logger)
 void Logger::Priv::log(
     const MessageType type, const std::string fmt, std::va_list args) const
 {
-    std::unique_lock<std::mutex> lock(mutex);
     if (muted & (1 << type))
         return;
+    const auto output = algo::format(fmt, args);
+
+    // only progress messages are held back - anything that may be
+    // interleaved with raw set_color() calls or needs attention goes out
+    // right away, after whatever this logger has buffered so far
+    std::unique_lock<std::mutex> buffer_lock(buffer_mutex);
+    if (buffering_enabled
+        && (type == MessageType::Info
+            || type == MessageType::Success
+            || type == MessageType::Debug))
+    {
+        buffer_size += output.size();
+        buffer.push_back({type, output});
+        if (buffer_size >= max_buffer_size)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            write_buffer();
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    write_buffer();
+    write(type, output);
+}
+
+void Logger::Priv::drain() const
+{
+    std::unique_lock<std::mutex> buffer_lock(buffer_mutex);
+    if (buffer.empty())
+        return;
+    std::unique_lock<std::mutex> lock(mutex);
+    write_buffer();
+}
+
+void Logger::Priv::write_buffer() const
+{
+    for (const auto &message : buffer)
+        write(message.type, message.text);
+    buffer.clear();
+    buffer_size = 0;
+}
+
+void Logger::Priv::write(const MessageType type, const std::string &text) const
+{
     auto *out = &std::cout;
     if (type == MessageType::Warning || type == MessageType::Error)
         out = &std::cerr;
-    const auto output = algo::format(fmt, args);
-    for (const auto line : algo::split(output, '\n', true))
+    for (const auto &line : algo::split(text, '\n', true))
     {
         (*out) << prefix;
         if (colors_enabled && colors[type] != Color::Original)
@@ -75,6 +140,7 @@ Logger::Logger(const Logger &other_logger) : p(new Priv(*this))
     p->muted = other_logger.p->muted;
     p->colors_enabled = other_logger.p->colors_enabled;
     p->prefix = other_logger.p->prefix;
+    p->buffering_enabled = other_logger.p->buffering_enabled;
 }
 
 Logger::Logger() : p(new Priv(*this))
@@ -84,6 +150,7 @@ Logger::Logger() : p(new Priv(*this))
 
 Logger::~Logger()
 {
+    p->drain();
 }
 
 void Logger::set_prefix(const std::string &prefix)
@@ -142,6 +209,7 @@ void Logger::debug(const std::string fmt, ...) const
 
 void Logger::flush() const
 {
+    p->drain();
     std::cout.flush();
     // stderr should be nonbuffered
 }
@@ -180,3 +248,19 @@ void Logger::enable_colors()
 {
     p->colors_enabled = true;
 }
+
+bool Logger::buffering_enabled() const
+{
+    return p->buffering_enabled;
+}
+
+void Logger::disable_buffering()
+{
+    p->drain();
+    p->buffering_enabled = false;
+}
+
+void Logger::enable_buffering()
+{
+    p->buffering_enabled = true;
+}
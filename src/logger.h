@@ -80,6 +80,10 @@ namespace au {
         void disable_colors();
         void enable_colors();
 
+        bool buffering_enabled() const;
+        void disable_buffering();
+        void enable_buffering();
+
     private:
         struct Priv;
         std::unique_ptr<Priv> p;
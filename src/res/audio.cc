@@ -25,6 +25,8 @@ Audio::Audio() :
     extra_codec_headers(""_b),
     channel_count(1),
     bits_per_sample(16),
+    block_align(0),
+    byte_rate(0),
     sample_rate(44100),
     samples(""_b)
 {
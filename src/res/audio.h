@@ -39,6 +39,8 @@ namespace res {
 
         size_t channel_count;
         size_t bits_per_sample;
+        size_t block_align; // 0 = derived from the two above
+        size_t byte_rate; // 0 = derived from the above and sample rate
         size_t sample_rate;
         std::vector<AudioLoopInfo> loops;
 
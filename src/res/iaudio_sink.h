@@ -0,0 +1,41 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "res/audio.h"
+
+namespace au {
+namespace res {
+
+    // Receives decoded audio piece by piece, so that the samples of a long
+    // track never need to be held in memory all at once.
+    class IAudioSink
+    {
+    public:
+        virtual ~IAudioSink() {}
+
+        // Called once before any samples. Everything but the samples of the
+        // passed audio describes the stream; the samples are ignored.
+        virtual void begin(const Audio &audio) = 0;
+
+        virtual void write(const bstr &samples) = 0;
+
+        virtual void end() = 0;
+    };
+
+} }
@@ -26,7 +26,7 @@ using namespace au::res;
 
 static const Pixel transparent_pixel = {0, 0, 0, 0};
 
-Image::Image(const Image &other) : Grid(other)
+Image::Image(const Image &other) : Grid(other), _palette(other._palette)
 {
 }
 
@@ -95,11 +95,11 @@ Image &Image::invert()
 Image &Image::flip_vertically()
 {
     for (const auto y : algo::range(_height >> 1))
-    for (const auto x : algo::range(_width))
     {
-        const auto t = at(x, _height - 1 - y);
-        at(x, _height - 1 - y) = at(x, y);
-        at(x, y) = t;
+        std::swap_ranges(
+            &content[y * _width],
+            &content[(y + 1) * _width],
+            &content[(_height - 1 - y) * _width]);
     }
     return *this;
 }
@@ -107,12 +107,7 @@ Image &Image::flip_vertically()
 Image &Image::flip_horizontally()
 {
     for (const auto y : algo::range(_height))
-    for (const auto x : algo::range(_width >> 1))
-    {
-        const auto t = at(_width - 1 - x, y);
-        at(_width - 1 - x, y) = at(x, y);
-        at(x, y) = t;
-    }
+        std::reverse(&content[y * _width], &content[(y + 1) * _width]);
     return *this;
 }
 
@@ -120,32 +115,25 @@ Image &Image::offset(const int x_offset, const int y_offset)
 {
     res::Image old_image(*this);
     crop(_width + x_offset, _height + y_offset);
-    for (auto &c : content)
-        c = transparent_pixel;
+    std::fill(content.begin(), content.end(), transparent_pixel);
     return overlay(old_image, x_offset, y_offset, OverlayKind::OverwriteAll);
 }
 
 Image &Image::crop(const size_t new_width, const size_t new_height)
 {
-    std::vector<Pixel> old_content(content.begin(), content.end());
     if (!new_width || !new_height)
         throw err::BadDataSizeError();
-    const auto old_width = _width;
-    const auto old_height = _height;
-    _width = new_width;
-    _height = new_height;
-    content.resize(new_width * new_height);
-    for (const auto y : algo::range(std::min(old_height, new_height)))
-    for (const auto x : algo::range(std::min(old_width, new_width)))
+    std::vector<Pixel> new_content(new_width * new_height, transparent_pixel);
+    const auto copy_width = std::min(_width, new_width);
+    for (const auto y : algo::range(std::min(_height, new_height)))
     {
-        content[y * new_width + x] = old_content[y * old_width + x];
+        const auto source_row = &content[y * _width];
+        std::copy(
+            source_row, source_row + copy_width, &new_content[y * new_width]);
     }
-    for (const auto y : algo::range(old_height, new_height))
-    for (const auto x : algo::range(new_width))
-        content[y * new_width + x] = transparent_pixel;
-    for (const auto y : algo::range(old_height))
-    for (const auto x : algo::range(old_width, new_width))
-        content[y * new_width + x] = transparent_pixel;
+    content.swap(new_content);
+    _width = new_width;
+    _height = new_height;
     return *this;
 }
 
@@ -153,14 +141,17 @@ Image &Image::apply_mask(const Image &other)
 {
     if (other.width() != _width || other.height() != _height)
         throw std::logic_error("Mask image size is different from image size");
-    for (const auto y : algo::range(_height))
-    for (const auto x : algo::range(_width))
-        at(x, y).a = other.at(x, y).r;
+    auto target_ptr = content.data();
+    const auto target_end = target_ptr + content.size();
+    auto source_ptr = other.begin();
+    while (target_ptr < target_end)
+        (target_ptr++)->a = (source_ptr++)->r;
     return *this;
 }
 
 Image &Image::apply_palette(const Palette &palette)
 {
+    _palette = std::make_shared<const Palette>(palette);
     const auto palette_size = palette.size();
     for (auto &c : content)
     {
@@ -172,6 +163,11 @@ Image &Image::apply_palette(const Palette &palette)
     return *this;
 }
 
+const Palette *Image::palette() const
+{
+    return _palette.get();
+}
+
 Image &Image::overlay(
     const Image &other,
     const OverlayKind overlay_kind)
@@ -189,39 +185,40 @@ Image &Image::overlay(
     const int x2 = std::min<int>(width(), target_x + other.width());
     const int y1 = std::max<int>(0, target_y);
     const int y2 = std::min<int>(height(), target_y + other.height());
-    const int source_x = -target_x;
-    const int source_y = -target_y;
-    if (overlay_kind == OverlayKind::OverwriteAll)
-    {
-        for (const auto y : algo::range(y1, y2))
-        for (const auto x : algo::range(x1, x2))
-            at(x, y) = other.at(source_x + x, source_y + y);
-    }
-    else if (overlay_kind == OverlayKind::OverwriteNonTransparent)
+    if (x1 >= x2 || y1 >= y2)
+        return *this;
+    const size_t row_size = x2 - x1;
+    const auto source_x = x1 - target_x;
+    for (const auto y : algo::range(y1, y2))
     {
-        for (const auto y : algo::range(y1, y2))
-        for (const auto x : algo::range(x1, x2))
+        const auto source_y = y - target_y;
+        const auto source_row = &other.at(source_x, source_y);
+        const auto target_row = &at(x1, y);
+        if (overlay_kind == OverlayKind::OverwriteAll)
         {
-            const auto &source_pixel = other.at(source_x + x, source_y + y);
-            if (source_pixel.a)
-                at(x, y) = source_pixel;
+            std::copy(source_row, source_row + row_size, target_row);
         }
-    }
-    else if (overlay_kind == OverlayKind::AddSimple)
-    {
-        for (const auto y : algo::range(y1, y2))
-        for (const auto x : algo::range(x1, x2))
+        else if (overlay_kind == OverlayKind::OverwriteNonTransparent)
         {
-            auto &target_pixel = at(x, y);
-            const auto &source_pixel = other.at(source_x + x, source_y + y);
-            target_pixel.r += source_pixel.r;
-            target_pixel.g += source_pixel.g;
-            target_pixel.b += source_pixel.b;
+            for (const auto x : algo::range(row_size))
+            {
+                if (source_row[x].a)
+                    target_row[x] = source_row[x];
+            }
+        }
+        else if (overlay_kind == OverlayKind::AddSimple)
+        {
+            for (const auto x : algo::range(row_size))
+            {
+                target_row[x].r += source_row[x].r;
+                target_row[x].g += source_row[x].g;
+                target_row[x].b += source_row[x].b;
+            }
+        }
+        else
+        {
+            throw std::logic_error("Unknown overlay kind");
         }
-    }
-    else
-    {
-        throw std::logic_error("Unknown overlay kind");
     }
     return *this;
 }
@@ -81,6 +81,14 @@ namespace res {
             const int target_x,
             const int target_y,
             const OverlayKind overlay_kind);
+
+        // Palette the image was last built from, if any. It's only a hint for
+        // encoders: the pixels can be changed afterwards, so they need to
+        // verify each pixel still has a palette entry.
+        const Palette *palette() const;
+
+    private:
+        std::shared_ptr<const Palette> _palette;
     };
 
 } }
@@ -0,0 +1,90 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/audio/adpcm.h"
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+static void compare_samples(
+    const bstr &actual, const std::vector<s16> &expected)
+{
+    REQUIRE(actual.size() == expected.size() * 2);
+    for (const auto i : algo::range(expected.size()))
+        REQUIRE(actual.get<s16>()[i] == expected[i]);
+}
+
+TEST_CASE("ADPCM decoding", "[algo]")
+{
+    SECTION("MS ADPCM")
+    {
+        const auto input =
+            "\x00\x01\x14\x00\x2C\x01\x64\x00\x18\xFC\x32\x00\x7C\xFC"
+            "\x17\x8F\x70\x3C"_b;
+        const std::vector<s16> expected
+            {50, -900, 100, -1000, 120, 1000, -16, 2281, 341, 3562, 707, 2527};
+
+        SECTION("Whole blocks")
+        {
+            compare_samples(
+                algo::audio::decode_ms_adpcm(input, 2, 18, ""_b), expected);
+        }
+
+        SECTION("Trailing partial block")
+        {
+            compare_samples(
+                algo::audio::decode_ms_adpcm(
+                    input + input.substr(0, 16), 2, 18, ""_b),
+                {50, -900, 100, -1000, 120, 1000, -16, 2281, 341, 3562, 707,
+                    2527, 50, -900, 100, -1000, 120, 1000, -16, 2281});
+        }
+
+        SECTION("Coefficients from codec headers")
+        {
+            const auto headers = "\x00\x00\x02\x00\x00\x01\x00\x00"
+                "\x00\x02\x00\xFF"_b;
+            compare_samples(
+                algo::audio::decode_ms_adpcm(input, 2, 18, headers),
+                expected);
+        }
+
+        SECTION("Invalid predictor")
+        {
+            const auto headers = "\x00\x00\x01\x00\x00\x01\x00\x00"_b;
+            REQUIRE_THROWS(
+                algo::audio::decode_ms_adpcm(input, 2, 18, headers));
+        }
+    }
+
+    SECTION("IMA ADPCM")
+    {
+        const auto input =
+            "\xE8\x03\x0A\x00\x30\xF8\x3C\x00"
+            "\x12\x9F\x07\x80\x44\xC3\x00\xFF"_b;
+        compare_samples(
+            algo::audio::decode_ima_adpcm(input, 2, 16),
+            {1000, -2000, 1011, 556, 1017, 3648, 987, 6557, 975, 3155,
+                1031, 3612, 1039, 4027, 1046, -1643, 1040, -13800});
+    }
+
+    SECTION("Invalid block alignment")
+    {
+        REQUIRE_THROWS(algo::audio::decode_ms_adpcm("\x00"_b, 2, 14, ""_b));
+        REQUIRE_THROWS(algo::audio::decode_ima_adpcm("\x00"_b, 2, 8));
+    }
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/audio/delta_pcm.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("Delta PCM decoding", "[algo]")
+{
+    SECTION("Resets and steps")
+    {
+        const auto output = algo::audio::decode_delta_pcm(
+            "\x85\x03\x43\x7F"_b, 1, 4, 1);
+        REQUIRE(output.size() == 8);
+        REQUIRE(output.get<s16>()[0] == 2560);
+        REQUIRE(output.get<s16>()[1] == 2566);
+        REQUIRE(output.get<s16>()[2] == 2560);
+        REQUIRE(output.get<s16>()[3] == 1560);
+    }
+
+    SECTION("Interleaved channels with multiplier")
+    {
+        const auto output = algo::audio::decode_delta_pcm(
+            "\x81\x82\x01\x41"_b, 2, 2, 3);
+        REQUIRE(output.size() == 8);
+        REQUIRE(output.get<s16>()[0] == 512);
+        REQUIRE(output.get<s16>()[1] == 1024);
+        REQUIRE(output.get<s16>()[2] == 518);
+        REQUIRE(output.get<s16>()[3] == 1018);
+    }
+
+    SECTION("Wrapping around")
+    {
+        const auto output = algo::audio::decode_delta_pcm(
+            "\xBF\x3F\x3F"_b, 1, 3, 2);
+        REQUIRE(output.get<s16>()[0] == 32256);
+        REQUIRE(output.get<s16>()[1] == -31280);
+        REQUIRE(output.get<s16>()[2] == -29280);
+    }
+
+    SECTION("Running out of input")
+    {
+        const auto output = algo::audio::decode_delta_pcm(
+            "\x81\x01\x02"_b, 2, 3, 1);
+        REQUIRE(output.size() == 12);
+        REQUIRE(output.get<s16>()[0] == 512);
+        REQUIRE(output.get<s16>()[1] == 2);
+        for (const auto i : {2, 3, 4, 5})
+            REQUIRE(output.get<s16>()[i] == 0);
+    }
+
+    SECTION("Decoding piece by piece")
+    {
+        algo::audio::DeltaPcmDecoder decoder(2, 3);
+        const auto output1 = decoder.decode("\x81\x82"_b);
+        const auto output2 = decoder.decode("\x01\x41\x41\x01\x01"_b);
+        REQUIRE(output1.size() == 4);
+        REQUIRE(output2.size() == 8);
+        REQUIRE(output1.get<s16>()[0] == 512);
+        REQUIRE(output1.get<s16>()[1] == 1024);
+        REQUIRE(output2.get<s16>()[0] == 518);
+        REQUIRE(output2.get<s16>()[1] == 1018);
+        REQUIRE(output2.get<s16>()[2] == 512);
+        REQUIRE(output2.get<s16>()[3] == 1024);
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/lazy.h"
+#include <atomic>
+#include <vector>
+#include "algo/parallel.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("Lazy values", "[algo]")
+{
+    SECTION("Computing on first use")
+    {
+        int calls = 0;
+        const algo::Lazy<std::vector<int>> table([&]()
+        {
+            calls++;
+            return std::vector<int>{1, 2, 3};
+        });
+        REQUIRE(calls == 0);
+        REQUIRE(table->size() == 3);
+        REQUIRE((*table)[2] == 3);
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("Computing once when accessed concurrently")
+    {
+        std::atomic<int> calls(0);
+        const algo::Lazy<int> value([&]()
+        {
+            calls++;
+            return 5;
+        });
+        std::atomic<int> sum(0);
+        algo::parallel_for(100, [&](const size_t)
+        {
+            sum += *value;
+        });
+        REQUIRE(sum == 500);
+        REQUIRE(calls == 1);
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/parallel.h"
+#include <atomic>
+#include <vector>
+#include "algo/range.h"
+#include "err.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("Parallel for", "[algo]")
+{
+    SECTION("Visiting every index once")
+    {
+        std::vector<std::atomic<int>> visits(1000);
+        for (auto &v : visits)
+            v = 0;
+        algo::parallel_for(visits.size(), [&](const size_t i)
+        {
+            visits[i]++;
+        });
+        for (const auto i : algo::range(visits.size()))
+            REQUIRE(visits[i] == 1);
+    }
+
+    SECTION("Nested calls")
+    {
+        std::vector<std::atomic<int>> visits(100 * 100);
+        for (auto &v : visits)
+            v = 0;
+        algo::parallel_for(100, [&](const size_t i)
+        {
+            algo::parallel_for(100, [&](const size_t j)
+            {
+                visits[i * 100 + j]++;
+            });
+        });
+        for (const auto i : algo::range(visits.size()))
+            REQUIRE(visits[i] == 1);
+    }
+
+    SECTION("Empty range")
+    {
+        algo::parallel_for(0, [](const size_t)
+        {
+            throw std::logic_error("Should not be called");
+        });
+    }
+
+    SECTION("Propagating exceptions")
+    {
+        REQUIRE_THROWS_AS(
+            algo::parallel_for(100, [](const size_t i)
+            {
+                if (i == 50)
+                    throw err::CorruptDataError("Test");
+            }),
+            err::CorruptDataError);
+    }
+}
@@ -104,6 +104,18 @@ TEST_CASE("ArgParser", "[core]")
         REQUIRE(ap.get_switch("--long") == "long2");
     }
 
+    SECTION("Repeated switches retain all values")
+    {
+        ArgParser ap;
+        ap.register_switch({"-s", "--long"});
+        ap.register_switch({"--unset"});
+        ap.parse(std::vector<std::string>{"--long=long1", "-s=short1"});
+        REQUIRE((ap.get_switch_values("--long")
+            == std::vector<std::string>{"long1", "short1"}));
+        REQUIRE(ap.get_switch_values("--unset").empty());
+        REQUIRE_THROWS(ap.get_switch_values("--undefined"));
+    }
+
     SECTION("Switches with values containing spaces")
     {
         ArgParser ap;
@@ -42,4 +42,23 @@ TEST_CASE("Alice Soft AJP images", "[dec]")
     {
         do_test("CG51478.ajp", "CG51478-out.png");
     }
+
+    SECTION("JPEG decoding options")
+    {
+        const auto decoder = AjpImageDecoder();
+        ArgParser arg_parser;
+        const auto decorators = decoder.get_arg_parser_decorators();
+        for (const auto &decorator : decorators)
+            decorator.register_cli_options(arg_parser);
+        arg_parser.parse(
+            std::vector<std::string>{"--jpeg-fast", "--jpeg-scale=2"});
+        for (const auto &decorator : decorators)
+            decorator.parse_cli_options(arg_parser);
+
+        const auto input_file = tests::file_from_path(dir + "CG51478.ajp");
+        const auto image = tests::decode(decoder, *input_file);
+        REQUIRE(image.width() == 200);
+        REQUIRE(image.height() == 100);
+        REQUIRE(tests::is_image_transparent(image));
+    }
 }
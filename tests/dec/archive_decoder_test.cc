@@ -229,3 +229,39 @@ TEST_CASE("Archive files get proper fallback names", "[dec]")
         test_naming_strategy<algo::NamingStrategy::Sibling>("test");
     }
 }
+
+TEST_CASE("Archive entry ranges", "[dec]")
+{
+    ArchiveEntryRange range;
+
+    SECTION("Plain entries")
+    {
+        PlainArchiveEntry entry;
+        entry.offset = 10;
+        entry.size = 20;
+        REQUIRE(get_entry_range(entry, range));
+        REQUIRE(range.offset == 10);
+        REQUIRE(range.size_stored == 20);
+        REQUIRE(range.size_orig == 20);
+        REQUIRE(!range.compressed);
+    }
+
+    SECTION("Compressed entries")
+    {
+        CompressedArchiveEntry entry;
+        entry.offset = 10;
+        entry.size_comp = 20;
+        entry.size_orig = 30;
+        REQUIRE(get_entry_range(entry, range));
+        REQUIRE(range.offset == 10);
+        REQUIRE(range.size_stored == 20);
+        REQUIRE(range.size_orig == 30);
+        REQUIRE(range.compressed);
+    }
+
+    SECTION("Entries of other kinds")
+    {
+        ArchiveEntry entry;
+        REQUIRE(!get_entry_range(entry, range));
+    }
+}
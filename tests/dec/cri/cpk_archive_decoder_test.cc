@@ -0,0 +1,76 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/cri/cpk_archive_decoder.h"
+#include "algo/range.h"
+#include "test_support/catch.h"
+#include "test_support/decoder_support.h"
+#include "test_support/file_support.h"
+
+using namespace au;
+using namespace au::dec::cri;
+
+static const std::string dir = "tests/dec/cri/files/cpk/";
+
+TEST_CASE("Cri CPK archives", "[dec]")
+{
+    const auto decoder = CpkArchiveDecoder();
+    const auto input_file = tests::file_from_path(dir + "test.cpk");
+
+    SECTION("Entries")
+    {
+        struct ExpectedEntry final
+        {
+            std::string path;
+            uoff_t offset;
+            size_t size;
+        };
+        const std::vector<ExpectedEntry> expected_entries
+        {
+            {"dir/a.txt", 0x800, 11},
+            {"b.bin", 0x810, 100},
+            {"dir/sub/c.txt", 0x880, 3},
+            {"dir/d.txt", 0x890, 20},
+        };
+
+        Logger dummy_logger;
+        const auto meta = decoder.read_meta(dummy_logger, *input_file);
+        REQUIRE(meta->entries.size() == expected_entries.size());
+        for (const auto i : algo::range(expected_entries.size()))
+        {
+            const auto entry = dynamic_cast<const dec::PlainArchiveEntry*>(
+                meta->entries[i].get());
+            REQUIRE(entry);
+            REQUIRE(entry->path == expected_entries[i].path);
+            REQUIRE(entry->offset == expected_entries[i].offset);
+            REQUIRE(entry->size == expected_entries[i].size);
+        }
+    }
+
+    SECTION("Contents")
+    {
+        const std::vector<std::shared_ptr<io::File>> expected_files
+        {
+            tests::stub_file("dir/a.txt", "hello world"_b),
+            tests::stub_file("b.bin", bstr(100, 'x')),
+            tests::stub_file("dir/sub/c.txt", "abc"_b),
+            tests::stub_file("dir/d.txt", "abc"_b),
+        };
+        const auto actual_files = tests::unpack(decoder, *input_file);
+        tests::compare_files(actual_files, expected_files, true);
+    }
+}
@@ -42,4 +42,9 @@ TEST_CASE("CRI HCA audio", "[dec]")
     {
         do_test("test.hca", "test-out.wav");
     }
+
+    SECTION("Silent blocks across a chunk boundary")
+    {
+        do_test("test-long.hca", "test-long-out.wav");
+    }
 }
@@ -0,0 +1,105 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/cri/layla.h"
+#include "err.h"
+#include "test_support/catch.h"
+#include "test_support/common.h"
+
+using namespace au;
+using namespace au::dec::cri;
+
+static void test(const bstr &input, const bstr &expected)
+{
+    REQUIRE(is_layla_compressed(input));
+    tests::compare_binary(layla_decompress(input), expected);
+}
+
+TEST_CASE("CRI LAYLA decompression", "[dec]")
+{
+    SECTION("Literals")
+    {
+        test(
+            "CRILAYLA"
+            "\x03\x00\x00\x00\x04\x00\x00\x00"
+            "\x20\x8C\x98\x31"_b,
+            "abc"_b);
+    }
+
+    SECTION("Overlapping repetitions")
+    {
+        test(
+            "CRILAYLA"
+            "\x09\x00\x00\x00\x06\x00\x00\x00"
+            "\x60\x00\x10\x4F\x1E\x3D"_b,
+            "xyzxyzxyz"_b);
+    }
+
+    SECTION("Repetitions with extended sizes")
+    {
+        test(
+            "CRILAYLA"
+            "\x39\x00\x00\x00\x08\x00\x00\x00"
+            "\x40\xE1\x7F\x00\x30\x8C\x98\x31"_b,
+            bstr("abcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabc"));
+    }
+
+    SECTION("Uncompressed prefix")
+    {
+        test(
+            "CRILAYLA"
+            "\x03\x00\x00\x00\x04\x00\x00\x00"
+            "\x20\x8C\x98\x31"
+            "prefix"_b,
+            "prefixabc"_b);
+    }
+
+    SECTION("Truncated input")
+    {
+        REQUIRE_THROWS_AS(
+            layla_decompress(
+                "CRILAYLA"
+                "\x04\x00\x00\x00\x04\x00\x00\x00"
+                "\x20\x8C\x98\x31"_b),
+            err::EofError);
+    }
+
+    SECTION("Repetitions reaching past decoded data")
+    {
+        REQUIRE_THROWS_AS(
+            layla_decompress(
+                "CRILAYLA"
+                "\x06\x00\x00\x00\x06\x00\x00\x00"
+                "\x80\x00\x30\x8C\x98\x31"_b),
+            err::CorruptDataError);
+    }
+
+    SECTION("Repetitions reaching past output")
+    {
+        REQUIRE_THROWS_AS(
+            layla_decompress(
+                "CRILAYLA"
+                "\x04\x00\x00\x00\x06\x00\x00\x00"
+                "\x00\x00\x30\x8C\x98\x31"_b),
+            err::CorruptDataError);
+    }
+
+    SECTION("Other data")
+    {
+        REQUIRE(!is_layla_compressed("CRILAYL"_b));
+    }
+}
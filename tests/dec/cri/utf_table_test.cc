@@ -0,0 +1,113 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "dec/cri/utf_table.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::dec::cri;
+
+static bstr make_packet()
+{
+    bstr text;
+    const auto add_text = [&](const std::string &str)
+    {
+        const auto offset = text.size();
+        text += bstr(str) + "\x00"_b;
+        return static_cast<u32>(offset);
+    };
+
+    io::MemoryByteStream schema_stream;
+    schema_stream.write<u8>(0x54).write_be<u32>(add_text("ID"));
+    schema_stream.write<u8>(0x5A).write_be<u32>(add_text("Name"));
+    schema_stream.write<u8>(0x32).write_be<u32>(add_text("Align"));
+    schema_stream.write_be<u16>(0x800);
+    schema_stream.write<u8>(0x14).write_be<u32>(add_text("Empty"));
+    schema_stream.write<u8>(0x5B).write_be<u32>(add_text("Blob"));
+    const auto table_name_offset = add_text("Table");
+
+    io::MemoryByteStream rows_stream;
+    rows_stream.write_be<u32>(5).write_be<u32>(add_text("first"));
+    rows_stream.write_be<u32>(0).write_be<u32>(3);
+    rows_stream.write_be<u32>(7).write_be<u32>(add_text("second"));
+    rows_stream.write_be<u32>(3).write_be<u32>(2);
+    const auto data = "abcde"_b;
+
+    const auto schema = schema_stream.seek(0).read_to_eof();
+    const auto rows = rows_stream.seek(0).read_to_eof();
+    const auto rows_offset = 24 + schema.size();
+    const auto text_offset = rows_offset + rows.size();
+    const auto data_offset = text_offset + text.size();
+
+    io::MemoryByteStream output_stream;
+    output_stream.write("@UTF"_b);
+    output_stream.write_be<u32>(data_offset + data.size());
+    output_stream.write_be<u32>(rows_offset);
+    output_stream.write_be<u32>(text_offset);
+    output_stream.write_be<u32>(data_offset);
+    output_stream.write_be<u32>(table_name_offset);
+    output_stream.write_be<u16>(5);
+    output_stream.write_be<u16>(16);
+    output_stream.write_be<u32>(2);
+    output_stream.write(schema);
+    output_stream.write(rows);
+    output_stream.write(text);
+    output_stream.write(data);
+    return output_stream.seek(0).read_to_eof();
+}
+
+TEST_CASE("Cri @UTF tables", "[dec]")
+{
+    const UtfTable table(make_packet());
+
+    SECTION("Schema")
+    {
+        REQUIRE(table.get_name() == "Table");
+        REQUIRE(table.get_row_count() == 2);
+        REQUIRE(table.has_column("ID"));
+        REQUIRE(!table.has_column("Nope"));
+        REQUIRE_THROWS(table.get_column("Nope"));
+        REQUIRE(table.get_column("ID").has_values());
+        REQUIRE(table.get_column("Align").has_values());
+        REQUIRE(!table.get_column("Empty").has_values());
+    }
+
+    SECTION("Per-row cells")
+    {
+        REQUIRE(table.get_column("ID").get_integer(0) == 5);
+        REQUIRE(table.get_column("ID").get_integer(1) == 7);
+        REQUIRE(table.get_column("Name").get_string(0) == "first");
+        REQUIRE(table.get_column("Name").get_string(1) == "second");
+        REQUIRE(table.get_column("Blob").get_data(0) == "abc"_b);
+        REQUIRE(table.get_column("Blob").get_data(1) == "de"_b);
+    }
+
+    SECTION("Constant cells")
+    {
+        REQUIRE(table.get_column("Align").get_integer(0) == 0x800);
+        REQUIRE(table.get_column("Align").get_integer(1) == 0x800);
+    }
+
+    SECTION("Invalid access")
+    {
+        REQUIRE_THROWS(table.get_column("ID").get_integer(2));
+        REQUIRE_THROWS(table.get_column("ID").get_string(0));
+        REQUIRE_THROWS(table.get_column("Empty").get_integer(0));
+    }
+}
@@ -51,3 +51,23 @@ TEST_CASE("JPEG 8-bit images", "[dec]")
     auto actual_image = tests::decode(decoder, *input_file);
     tests::compare_images(actual_image, *expected_file);
 }
+
+TEST_CASE("JPEG downscaled fast decoding", "[dec]")
+{
+    const auto input_file = tests::file_from_path(dir + "reimu_opaque.jpg");
+
+    auto decoder = JpegImageDecoder();
+    decoder.set_fast_mode(true);
+    decoder.set_scale_denominator(4);
+    const auto image = tests::decode(decoder, *input_file);
+    REQUIRE(image.width() == 256);
+    REQUIRE(image.height() == 256);
+
+    const auto color = image.at(50, 25);
+    REQUIRE(std::abs(color.r - 0x60) < 8);
+    REQUIRE(std::abs(color.g - 0x97) < 8);
+    REQUIRE(std::abs(color.b - 0xE7) < 8);
+    REQUIRE(static_cast<int>(color.a) == 0xFF);
+
+    REQUIRE_THROWS(decoder.set_scale_denominator(3));
+}
@@ -16,6 +16,8 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/kid/waf_audio_decoder.h"
+#include "algo/crypt/crc32.h"
+#include "enc/microsoft/wav_audio_sink.h"
 #include "test_support/audio_support.h"
 #include "test_support/catch.h"
 #include "test_support/decoder_support.h"
@@ -26,6 +28,17 @@ using namespace au::dec::kid;
 
 static const std::string dir = "tests/dec/kid/files/waf/";
 
+static std::unique_ptr<io::File> write_wav(
+    const WafAudioDecoder &decoder, io::File &input_file)
+{
+    auto output_file = std::make_unique<io::File>("test.wav", ""_b);
+    enc::microsoft::WavAudioSink sink(*output_file);
+    Logger dummy_logger;
+    dummy_logger.mute();
+    decoder.decode(dummy_logger, input_file, sink);
+    return output_file;
+}
+
 static void do_test(
     const std::string &input_path, const std::string &expected_path)
 {
@@ -38,7 +51,41 @@ static void do_test(
 
 TEST_CASE("KID WAF audio", "[dec]")
 {
-    do_test(
-        "CEP037.waf",
-        "CEP037-out.wav");
+    SECTION("Extracting ADPCM as is")
+    {
+        do_test(
+            "CEP037.waf",
+            "CEP037-out.wav");
+    }
+
+    SECTION("Keeping ADPCM header as is")
+    {
+        const auto decoder = WafAudioDecoder();
+        const auto input_file = tests::file_from_path(dir + "CEP037.waf");
+        const auto output_file = write_wav(decoder, *input_file);
+        output_file->stream.seek(28);
+        REQUIRE(output_file->stream.read_le<u32>() == 11130); // byte rate
+        REQUIRE(output_file->stream.read_le<u16>() == 512); // block align
+    }
+
+    SECTION("Decoding ADPCM")
+    {
+        auto decoder = WafAudioDecoder();
+        decoder.set_adpcm_decoding(true);
+        const auto input_file = tests::file_from_path(dir + "CEP037.waf");
+        const auto audio = tests::decode(decoder, *input_file);
+        REQUIRE(audio.codec == 1);
+        REQUIRE(audio.bits_per_sample == 16);
+        REQUIRE(audio.block_align == 0);
+        REQUIRE(audio.extra_codec_headers.empty());
+        REQUIRE(audio.channel_count == 1);
+        REQUIRE(audio.samples.size() == 7 * 1012 * 2);
+        // checksum of the output of an independent MS ADPCM decoder
+        REQUIRE(algo::crypt::crc32(audio.samples) == 0x7DEE727A);
+
+        const auto output_file = write_wav(decoder, *input_file);
+        output_file->stream.seek(28);
+        REQUIRE(output_file->stream.read_le<u32>() == 22000 * 2); // byte rate
+        REQUIRE(output_file->stream.read_le<u16>() == 2); // block align
+    }
 }
@@ -0,0 +1,72 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/kirikiri/cxdec.h"
+#include "algo/crypt/crc32.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::dec::kirikiri;
+
+static bstr make_control_block()
+{
+    bstr control_block(4096);
+    u32 x = 1;
+    for (auto &c : control_block)
+    {
+        x = x * 1103515245 + 12345;
+        c = x >> 16;
+    }
+    return control_block;
+}
+
+TEST_CASE("Kirikiri cxdec key derivation", "[dec]")
+{
+    // expected checksums were produced by the former bytecode interpreter
+    const std::vector<std::pair<u32, u32>> expected
+    {
+        {0x00000000, 0xE9539A71},
+        {0x00000001, 0x06C10F21},
+        {0x12345678, 0x7923A256},
+        {0x9ABCDEF0, 0xFAD79CA2},
+        {0xDEADBEEF, 0x1B0CCD81},
+        {0xFFFFFFFF, 0x2E5FC106},
+        {0x0BADF00D, 0xED95D326},
+        {0x7F7F7F7F, 0xAFCD5298},
+        {0x80000001, 0x835D7517},
+        {0x13579BDF, 0xF883BCDD},
+        {0x2468ACE0, 0xF8705EDA},
+        {0xCAFEBABE, 0xB437C40A},
+    };
+
+    const auto plugin = create_cxdec_plugin(
+        0x7FFF,
+        0x100,
+        {2, 0, 1},
+        {0, 7, 5, 6, 3, 1, 4, 2},
+        {4, 3, 2, 1, 5, 0},
+        make_control_block());
+    const auto decrypt = plugin.create_decrypt_func("dummy/arc.xp3");
+
+    for (const auto &kv : expected)
+    {
+        bstr data(0x10000);
+        decrypt(data, kv.first);
+        INFO("key " << kv.first);
+        REQUIRE(algo::crypt::crc32(data) == kv.second);
+    }
+}
@@ -16,6 +16,8 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/microsoft/dds_image_decoder.h"
+#include "algo/range.h"
+#include "io/memory_byte_stream.h"
 #include "test_support/catch.h"
 #include "test_support/decoder_support.h"
 #include "test_support/file_support.h"
@@ -36,6 +38,62 @@ static void do_test(
     tests::compare_images(actual_image, *expected_file);
 }
 
+static std::unique_ptr<io::File> create_dds_file(
+    const size_t width,
+    const size_t height,
+    const bstr &four_cc,
+    const u32 dxgi_format,
+    const bstr &data)
+{
+    io::MemoryByteStream output_stream;
+    output_stream.write("DDS\x20"_b);
+    output_stream.write_le<u32>(124);
+    output_stream.write_le<u32>(0x1007);
+    output_stream.write_le<u32>(height);
+    output_stream.write_le<u32>(width);
+    output_stream.write_le<u32>(0);
+    output_stream.write_le<u32>(0);
+    output_stream.write_le<u32>(0);
+    output_stream.write(bstr(4 * 11));
+    output_stream.write_le<u32>(32);
+    output_stream.write_le<u32>(4);
+    output_stream.write(four_cc);
+    output_stream.write(bstr(4 * 5));
+    output_stream.write(bstr(4 * 5));
+    if (four_cc == "DX10"_b)
+    {
+        output_stream.write_le<u32>(dxgi_format);
+        output_stream.write_le<u32>(3);
+        output_stream.write(bstr(4 * 3));
+    }
+    output_stream.write(data);
+    return std::make_unique<io::File>(
+        "test.dds", output_stream.seek(0).read_to_eof());
+}
+
+static res::Image decode_synthetic(
+    const bstr &four_cc, const u32 dxgi_format, const bstr &data)
+{
+    const auto decoder = DdsImageDecoder();
+    const auto input_file = create_dds_file(4, 4, four_cc, dxgi_format, data);
+    return tests::decode(decoder, *input_file);
+}
+
+// Expected pixels are stored as RGBA and come from an independent decoder.
+static void do_bc7_test(const bstr &block, const bstr &expected)
+{
+    const auto image = decode_synthetic("DX10"_b, 98, block);
+    for (const auto i : algo::range(16))
+    {
+        INFO("pixel " << i);
+        const auto &pixel = image.at(i & 3, i >> 2);
+        REQUIRE(pixel.r == expected[i * 4]);
+        REQUIRE(pixel.g == expected[i * 4 + 1]);
+        REQUIRE(pixel.b == expected[i * 4 + 2]);
+        REQUIRE(pixel.a == expected[i * 4 + 3]);
+    }
+}
+
 TEST_CASE("Microsoft DDS textures", "[dec]")
 {
     SECTION("DXT1")
@@ -57,4 +115,157 @@ TEST_CASE("Microsoft DDS textures", "[dec]")
     {
         do_test("koishi_7.dds", "koishi_7-out.png");
     }
+
+    SECTION("BC4")
+    {
+        const auto image = decode_synthetic(
+            "ATI1"_b, 0, "\xC8\x64\x88\xC6\xFA\x88\xC6\xFA"_b);
+        const u8 expected[8] = {200, 100, 185, 171, 157, 142, 128, 114};
+        for (const auto i : algo::range(16))
+        {
+            const auto &pixel = image.at(i & 3, i >> 2);
+            REQUIRE(pixel.r == expected[i & 7]);
+            REQUIRE(pixel.g == expected[i & 7]);
+            REQUIRE(pixel.b == expected[i & 7]);
+            REQUIRE(pixel.a == 0xFF);
+        }
+    }
+
+    SECTION("BC5")
+    {
+        const auto image = decode_synthetic(
+            "DX10"_b,
+            83,
+            "\xC8\x64\x88\xC6\xFA\x88\xC6\xFA"
+            "\x0A\x14\x88\xC6\xFA\x88\xC6\xFA"_b);
+        const u8 expected_r[8] = {200, 100, 185, 171, 157, 142, 128, 114};
+        const u8 expected_g[8] = {10, 20, 12, 14, 16, 18, 0, 255};
+        for (const auto i : algo::range(16))
+        {
+            const auto &pixel = image.at(i & 3, i >> 2);
+            REQUIRE(pixel.r == expected_r[i & 7]);
+            REQUIRE(pixel.g == expected_g[i & 7]);
+            REQUIRE(pixel.b == 0);
+            REQUIRE(pixel.a == 0xFF);
+        }
+    }
+
+    SECTION("BC7")
+    {
+        const auto image = decode_synthetic(
+            "DX10"_b,
+            98,
+            "\xC0\x3F\x00\xF0\x07\x02\xFF\xFF"
+            "\x11\x32\x54\x76\x98\xBA\xDC\xFE"_b);
+        REQUIRE((image.at(0, 0) == res::Pixel{0x81, 0x01, 0xFF, 0xFF}));
+        REQUIRE((image.at(1, 1) == res::Pixel{0x81, 0x54, 0xAC, 0xFF}));
+        REQUIRE((image.at(3, 3) == res::Pixel{0x81, 0xFF, 0x01, 0xFF}));
+    }
+
+    SECTION("BC7 mode 0")
+    {
+        do_bc7_test(
+            "\xDD\x04\x65\xAA\x1F\xAD\x1D\x5A"
+            "\xDA\xE5\xAC\x1B\x1E\x5F\x13\x70"_b,
+            "\x62\xE3\x26\xFF\x3C\xF6\xA2\xFF"
+            "\x5F\x7B\x72\xFF\x5F\x7B\x72\xFF"
+            "\x6B\xDE\x08\xFF\x30\x69\xBE\xFF"
+            "\x5F\x7B\x72\xFF\x49\xE4\x79\xFF"
+            "\x21\x63\xD6\xFF\x3F\x6F\xA5\xFF"
+            "\x54\xEB\x44\xFF\x49\xE4\x79\xFF"
+            "\x8C\x8C\x29\xFF\x31\xD6\xE7\xFF"
+            "\x54\xEB\x44\xFF\x37\xDA\xCC\xFF"_b);
+    }
+
+    SECTION("BC7 mode 1")
+    {
+        do_bc7_test(
+            "\x7A\x6C\xFD\x10\xFF\x19\xAF\x60"
+            "\x1D\x04\xAC\xB4\x1D\x02\x2B\x46"_b,
+            "\xC0\xD5\xA4\xFF\x30\xBE\x04\xFF"
+            "\x36\xC2\x04\xFF\x30\xBE\x04\xFF"
+            "\xC0\xD5\xA4\xFF\xC0\xD5\xA4\xFF"
+            "\xD5\x9D\xD5\xFF\x3C\xC5\x04\xFF"
+            "\x30\xBE\x04\xFF\xB1\xFD\x81\xFF"
+            "\xC6\xC6\xB2\xFF\xCB\xB8\xBD\xFF"
+            "\x30\xBE\x04\xFF\x23\xB7\x04\xFF"
+            "\x36\xC2\x04\xFF\xBB\xE2\x99\xFF"_b);
+    }
+
+    SECTION("BC7 mode 2")
+    {
+        do_bc7_test(
+            "\x7C\x73\x3A\xF2\xDF\x5F\xAE\xB7"
+            "\x08\x59\xD1\xEE\x39\x10\xCB\x48"_b,
+            "\xA3\xB9\x68\xFF\x4A\x29\xB5\xFF"
+            "\xCE\xFF\x42\xFF\xCE\xFF\x42\xFF"
+            "\xFF\xB5\xBD\xFF\x57\xD0\x2E\xFF"
+            "\xFF\xB5\xBD\xFF\x94\xF7\x6B\xFF"
+            "\xFF\xB5\xBD\xFF\x57\xD0\x2E\xFF"
+            "\xD3\x68\x64\xFF\x57\xD0\x2E\xFF"
+            "\xFF\xB5\xBD\xFF\x57\xD0\x2E\xFF"
+            "\xD3\x68\x64\xFF\x39\xBD\x10\xFF"_b);
+    }
+
+    SECTION("BC7 mode 3")
+    {
+        do_bc7_test(
+            "\x98\xB5\xCC\x89\x29\x11\xFF\x06"
+            "\xB6\x62\x2E\xDF\x3C\xF9\x35\xFD"_b,
+            "\x80\xAB\x5E\xFF\xCD\xF1\x63\xFF"
+            "\x80\xAB\x5E\xFF\xA8\xCF\x60\xFF"
+            "\x12\xDE\x5C\xFF\xCD\xF1\x63\xFF"
+            "\xCD\xF1\x63\xFF\xCD\xF1\x63\xFF"
+            "\x12\xDE\x5C\xFF\x80\xAB\x5E\xFF"
+            "\xCD\xF1\x63\xFF\x5B\x89\x5B\xFF"
+            "\x43\xBF\x67\xFF\xA6\x80\x7C\xFF"
+            "\xCD\xF1\x63\xFF\xCD\xF1\x63\xFF"_b);
+    }
+
+    SECTION("BC7 mode 4")
+    {
+        // rotation and index selection bits set
+        do_bc7_test(
+            "\xD0\x94\x28\xCA\x09\x7C\x44\xB3"
+            "\x02\x5E\x96\x5F\xB3\xEA\x6D\xAC"_b,
+            "\x6D\x8C\x93\x75\x80\xC3\xAF\x69"
+            "\x34\x53\x3D\x99\x21\x53\x21\xA5"
+            "\x46\x8C\x59\x8E\x34\x53\x3D\x99"
+            "\x59\x8C\x75\x82\x46\x8C\x59\x8E"
+            "\x80\x8C\xAF\x69\x46\xC3\x59\x8E"
+            "\x21\xC3\x21\xA5\x34\xC3\x3D\x99"
+            "\x34\x1C\x3D\x99\xA5\x1C\xE7\x52"
+            "\x6D\x53\x93\x75\x46\xC3\x59\x8E"_b);
+    }
+
+    SECTION("BC7 mode 5")
+    {
+        // rotation bits set
+        do_bc7_test(
+            "\xE0\x2D\x81\x6E\x69\xAF\xE0\xE6"
+            "\x87\x4C\x9C\x04\xE7\xD2\x36\x5D"_b,
+            "\x3E\x7F\xCD\xAD\x5A\x74\xCD\xED"
+            "\x5A\x74\xE4\xED\x3E\x7F\xF9\xAD"
+            "\x20\x8C\xE4\x6A\x3E\x7F\xB8\xAD"
+            "\x20\x8C\xCD\x6A\x5A\x74\xF9\xED"
+            "\x20\x8C\xE4\x6A\x04\x97\xCD\x2A"
+            "\x5A\x74\xF9\xED\x3E\x7F\xB8\xAD"
+            "\x20\x8C\xCD\x6A\x5A\x74\xF9\xED"
+            "\x5A\x74\xCD\xED\x20\x8C\xCD\x6A"_b);
+    }
+
+    SECTION("BC7 mode 7")
+    {
+        do_bc7_test(
+            "\x80\x60\xC9\xEA\xF4\x79\xF6\x86"
+            "\xA0\xEB\x93\x26\xE4\x62\x12\xD5"_b,
+            "\x5D\xD0\xBE\xA0\x51\x38\x00\x49"
+            "\xCB\x9A\x82\x38\x49\x6D\x4D\x64"
+            "\x5D\xD0\xBE\xA0\x51\x38\x00\x49"
+            "\xCB\x9A\x82\x38\x51\x38\x00\x49"
+            "\x5D\xD0\xBE\xA0\x40\xA6\x9E\x7F"
+            "\x28\xEB\xDB\xD3\x40\xA6\x9E\x7F"
+            "\x96\xB5\x9F\x6B\x40\xA6\x9E\x7F"
+            "\x96\xB5\x9F\x6B\x49\x6D\x4D\x64"_b);
+    }
 }
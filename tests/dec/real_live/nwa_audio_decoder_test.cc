@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/real_live/nwa_audio_decoder.h"
+#include "io/memory_byte_stream.h"
 #include "test_support/audio_support.h"
 #include "test_support/catch.h"
 #include "test_support/decoder_support.h"
@@ -47,4 +48,30 @@ TEST_CASE("RealLive NWA audio", "[dec]")
     {
         do_test("BATSWING-zlib.nwa", "BATSWING-zlib-out.wav");
     }
+
+    SECTION("Uncompressed")
+    {
+        const auto samples = "\x01\x00\x02\x00\xFF\xFF\x00\x80"_b;
+        io::MemoryByteStream input_stream;
+        input_stream.write_le<u16>(2);
+        input_stream.write_le<u16>(16);
+        input_stream.write_le<u32>(22050);
+        input_stream.write_le<u32>(0xFFFFFFFF);
+        input_stream.write_le<u32>(0);
+        input_stream.write_le<u32>(0);
+        input_stream.write_le<u32>(samples.size());
+        input_stream.write_le<u32>(0);
+        input_stream.write_le<u32>(samples.size() / 2);
+        input_stream.write_le<u32>(0);
+        input_stream.write_le<u32>(0);
+        input_stream.write(samples);
+        io::File input_file("test.nwa", input_stream.seek(0).read_to_eof());
+
+        const auto decoder = NwaAudioDecoder();
+        const auto audio = tests::decode(decoder, input_file);
+        REQUIRE(audio.channel_count == 2);
+        REQUIRE(audio.bits_per_sample == 16);
+        REQUIRE(audio.sample_rate == 22050);
+        REQUIRE(audio.samples == samples);
+    }
 }
@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/vorbis/packed_ogg_audio_decoder.h"
+#include "io/memory_byte_stream.h"
 #include "test_support/catch.h"
 #include "test_support/decoder_support.h"
 #include "test_support/file_support.h"
@@ -25,6 +26,22 @@ using namespace au::dec::vorbis;
 
 static const std::string dir = "tests/dec/vorbis/files/packed_ogg/";
 
+static bstr create_ogg_page(const u32 serial_number, const bstr &content)
+{
+    io::MemoryByteStream output_stream;
+    output_stream.write("OggS"_b);
+    output_stream.write<u8>(0);
+    output_stream.write<u8>(0);
+    output_stream.write("\x00\x00\x00\x00\x00\x00\x00\x00"_b);
+    output_stream.write_le<u32>(serial_number);
+    output_stream.write_le<u32>(0);
+    output_stream.write_le<u32>(0);
+    output_stream.write<u8>(1);
+    output_stream.write<u8>(content.size());
+    output_stream.write(content);
+    return output_stream.seek(0).read_to_eof();
+}
+
 static void do_test(
     const std::string &input_path, const std::string &expected_path)
 {
@@ -46,4 +63,27 @@ TEST_CASE("Vorbis packed OGG audio", "[dec]")
     {
         do_test("90WIF020_001.WAV", "90WIF020_001-out.ogg");
     }
+
+    SECTION("Extra logical streams")
+    {
+        const auto data
+            = create_ogg_page(1, "first"_b)
+            + create_ogg_page(2, "extra"_b)
+            + create_ogg_page(1, "second"_b);
+        io::File input_file("test.wav", ""_b);
+        input_file.stream.write("RIFF\x00\x00\x00\x00WAVEfmt\x20"_b);
+        input_file.stream.write_le<u32>(0);
+        input_file.stream.write("fact"_b);
+        input_file.stream.write_le<u32>(4);
+        input_file.stream.write_le<u32>(0);
+        input_file.stream.write("data"_b);
+        input_file.stream.write_le<u32>(data.size());
+        input_file.stream.write(data);
+        input_file.stream.seek(0);
+
+        const auto decoder = PackedOggAudioDecoder();
+        const auto actual_file = tests::decode(decoder, input_file);
+        REQUIRE(actual_file->stream.seek(0).read_to_eof()
+            == create_ogg_page(1, "first"_b) + create_ogg_page(1, "second"_b));
+    }
 }
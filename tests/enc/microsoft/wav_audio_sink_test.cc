@@ -0,0 +1,68 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "enc/microsoft/wav_audio_sink.h"
+#include "enc/microsoft/wav_audio_encoder.h"
+#include "test_support/catch.h"
+#include "test_support/common.h"
+
+using namespace au;
+using namespace au::enc::microsoft;
+
+static res::Audio create_test_audio()
+{
+    res::Audio audio;
+    audio.codec = 1;
+    audio.channel_count = 2;
+    audio.bits_per_sample = 16;
+    audio.sample_rate = 44100;
+    audio.samples = "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0A\x0B\x0C"_b;
+    return audio;
+}
+
+TEST_CASE("Microsoft WAV audio sink", "[enc]")
+{
+    Logger dummy_logger;
+    dummy_logger.mute();
+    const auto wav_encoder = WavAudioEncoder();
+
+    SECTION("Writing in chunks")
+    {
+        auto input_audio = create_test_audio();
+        SECTION("Without loops")
+        {
+        }
+        SECTION("With loops")
+        {
+            input_audio.loops.push_back(res::AudioLoopInfo {1, 2, 0});
+        }
+
+        io::File output_file("test.dat", ""_b);
+        WavAudioSink sink(output_file);
+        sink.begin(input_audio);
+        sink.write(input_audio.samples.substr(0, 4));
+        sink.write(input_audio.samples.substr(4));
+        sink.end();
+
+        const auto expected_file
+            = wav_encoder.encode(dummy_logger, input_audio, "test.dat");
+        REQUIRE(output_file.path == expected_file->path);
+        tests::compare_binary(
+            output_file.stream.seek(0).read_to_eof(),
+            expected_file->stream.seek(0).read_to_eof());
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "enc/png/png_image_encoder.h"
+#include "algo/range.h"
+#include "dec/png/png_image_decoder.h"
+#include "test_support/catch.h"
+#include "test_support/image_support.h"
+
+using namespace au;
+using namespace au::enc::png;
+
+static u8 get_color_type(io::File &png_file)
+{
+    return png_file.stream.seek(25).read<u8>();
+}
+
+TEST_CASE("PNG images encoding", "[enc]")
+{
+    Logger dummy_logger;
+    dummy_logger.mute();
+    const auto png_encoder = PngImageEncoder();
+    const auto png_decoder = dec::png::PngImageDecoder();
+
+    SECTION("Truecolor image")
+    {
+        const auto input_image = tests::get_transparent_test_image();
+        const auto output_file
+            = png_encoder.encode(dummy_logger, input_image, "test.dat");
+        REQUIRE(output_file->path.name() == "test.png");
+        REQUIRE(get_color_type(*output_file) == 6);
+        const auto output_image
+            = png_decoder.decode(dummy_logger, *output_file);
+        tests::compare_images(input_image, output_image);
+    }
+
+    SECTION("Indexed image")
+    {
+        const auto palette_image = tests::get_palette_test_image();
+        const auto &grid = std::get<1>(palette_image);
+        const auto &palette = std::get<2>(palette_image);
+        bstr indices;
+        for (const auto y : algo::range(grid.height()))
+        for (const auto x : algo::range(grid.width()))
+            indices += static_cast<u8>(grid.at(x, y));
+        const res::Image input_image(
+            grid.width(), grid.height(), indices, palette);
+
+        const auto output_file
+            = png_encoder.encode(dummy_logger, input_image, "test.dat");
+        REQUIRE(get_color_type(*output_file) == 3);
+        const auto output_image
+            = png_decoder.decode(dummy_logger, *output_file);
+        tests::compare_images(input_image, output_image);
+    }
+
+    SECTION("Indexed image with colors outside of its palette")
+    {
+        const auto palette_image = tests::get_palette_test_image();
+        const auto &palette = std::get<2>(palette_image);
+        res::Image input_image(2, 2, "\x00\x01\x02\x03"_b, palette);
+        input_image.at(1, 1).r ^= 0xFF;
+
+        const auto output_file
+            = png_encoder.encode(dummy_logger, input_image, "test.dat");
+        REQUIRE(get_color_type(*output_file) == 6);
+        const auto output_image
+            = png_decoder.decode(dummy_logger, *output_file);
+        tests::compare_images(input_image, output_image);
+    }
+}
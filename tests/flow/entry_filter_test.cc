@@ -0,0 +1,273 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/entry_filter.h"
+#include <algorithm>
+#include "dec/base_archive_decoder.h"
+#include "err.h"
+#include "flow/file_saver_callback.h"
+#include "flow/parallel_unpacker.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/catch.h"
+#include "test_support/common.h"
+#include "test_support/file_support.h"
+
+using namespace au;
+using namespace au::dec;
+using namespace au::flow;
+
+namespace
+{
+    class TestArchiveDecoder final : public BaseArchiveDecoder
+    {
+    public:
+        TestArchiveDecoder(std::vector<std::string> &read_names);
+
+        std::vector<std::string> get_linked_formats() const override;
+
+    protected:
+        bool is_recognized_impl(io::File &input_file) const override;
+
+        std::unique_ptr<ArchiveMeta> read_meta_impl(
+            const Logger &logger, io::File &input_file) const override;
+
+        std::unique_ptr<io::File> read_file_impl(
+            const Logger &logger,
+            io::File &input_file,
+            const ArchiveMeta &m,
+            const ArchiveEntry &e) const override;
+
+    private:
+        std::vector<std::string> &read_names;
+    };
+}
+
+static bstr make_archive(
+    std::initializer_list<std::shared_ptr<io::File>> input_files)
+{
+    io::MemoryByteStream tmp_stream;
+    for (auto &input_file : input_files)
+    {
+        const auto content = input_file->stream.seek(0).read_to_eof();
+        tmp_stream.write(input_file->path.str());
+        tmp_stream.write<u8>(0);
+        tmp_stream.write_le<u32>(content.size());
+        tmp_stream.write(content);
+    }
+    return tmp_stream.seek(0).read_to_eof();
+}
+
+TestArchiveDecoder::TestArchiveDecoder(std::vector<std::string> &read_names)
+    : read_names(read_names)
+{
+}
+
+std::vector<std::string> TestArchiveDecoder::get_linked_formats() const
+{
+    return {"test/test-archive"};
+}
+
+bool TestArchiveDecoder::is_recognized_impl(io::File &input_file) const
+{
+    return input_file.path.has_extension("arc");
+}
+
+std::unique_ptr<ArchiveMeta> TestArchiveDecoder::read_meta_impl(
+    const Logger &logger, io::File &input_file) const
+{
+    input_file.stream.seek(0);
+    auto meta = std::make_unique<ArchiveMeta>();
+    while (input_file.stream.left())
+    {
+        auto entry = std::make_unique<PlainArchiveEntry>();
+        entry->path = input_file.stream.read_to_zero().str();
+        entry->size = input_file.stream.read_le<u32>();
+        entry->offset = input_file.stream.pos();
+        input_file.stream.skip(entry->size);
+        meta->entries.push_back(std::move(entry));
+    }
+    return meta;
+}
+
+std::unique_ptr<io::File> TestArchiveDecoder::read_file_impl(
+    const Logger &logger,
+    io::File &input_file,
+    const ArchiveMeta &,
+    const ArchiveEntry &e) const
+{
+    const auto entry = static_cast<const PlainArchiveEntry*>(&e);
+    read_names.push_back(entry->path.str());
+    const auto data = input_file.stream.seek(entry->offset).read(entry->size);
+    return std::make_unique<io::File>(entry->path, data);
+}
+
+static std::vector<std::string> unpack(
+    io::File &input_file,
+    const EntryFilter &entry_filter,
+    std::vector<std::string> &read_names)
+{
+    auto registry = Registry::create_mock();
+    registry->add_decoder(
+        "test/test-archive",
+        [&]() { return std::make_shared<TestArchiveDecoder>(read_names); });
+
+    Logger dummy_logger;
+    dummy_logger.mute();
+
+    std::vector<std::string> saved_names;
+    const FileSaverCallback file_saver(
+        [&](std::shared_ptr<io::File> saved_file)
+        {
+            saved_names.push_back(saved_file->path.str());
+        });
+
+    ParallelUnpackerContext context(
+        dummy_logger,
+        file_saver,
+        *registry,
+        true,
+        {},
+        {"test/test-archive"});
+
+    ParallelUnpacker unpacker(context);
+    unpacker.set_entry_filter(entry_filter);
+    unpacker.add_input_file(
+        input_file.path,
+        [&]() { return std::make_shared<io::File>(input_file); });
+    unpacker.run(1);
+    std::sort(saved_names.begin(), saved_names.end());
+    std::sort(read_names.begin(), read_names.end());
+    return saved_names;
+}
+
+TEST_CASE("Entry filters", "[flow]")
+{
+    EntryFilter filter;
+
+    SECTION("No patterns select everything")
+    {
+        REQUIRE(filter.is_selected("a/b.txt"));
+        REQUIRE(filter.may_contain_selected("a/b.arc"));
+    }
+
+    SECTION("Globs without slash match file names")
+    {
+        filter.include("*.txt", PatternType::Glob);
+        REQUIRE(filter.is_selected("b.txt"));
+        REQUIRE(filter.is_selected("a/b.txt"));
+        REQUIRE(!filter.is_selected("a/b.png"));
+        REQUIRE(filter.may_contain_selected("a/b.arc"));
+    }
+
+    SECTION("Globs with slash match whole paths")
+    {
+        filter.include("data/*.txt", PatternType::Glob);
+        REQUIRE(filter.is_selected("data/b.txt"));
+        REQUIRE(!filter.is_selected("data/sub/b.txt"));
+        REQUIRE(!filter.is_selected("b.txt"));
+        REQUIRE(filter.may_contain_selected("data"));
+        REQUIRE(!filter.may_contain_selected("other"));
+        REQUIRE(!filter.may_contain_selected("data/sub"));
+    }
+
+    SECTION("Double asterisk crosses directories")
+    {
+        filter.include("data/**/b.txt", PatternType::Glob);
+        REQUIRE(filter.is_selected("data/b.txt"));
+        REQUIRE(filter.is_selected("data/x/y/b.txt"));
+        REQUIRE(!filter.is_selected("data/x/y/c.txt"));
+        REQUIRE(filter.may_contain_selected("data/x/y"));
+        REQUIRE(!filter.may_contain_selected("other"));
+    }
+
+    SECTION("Question mark")
+    {
+        filter.include("?.txt", PatternType::Glob);
+        REQUIRE(filter.is_selected("a.txt"));
+        REQUIRE(!filter.is_selected("ab.txt"));
+    }
+
+    SECTION("Selecting a directory selects its contents")
+    {
+        filter.include("data/sub", PatternType::Glob);
+        REQUIRE(filter.is_selected("data/sub/b.txt"));
+        REQUIRE(!filter.is_selected("data/other/b.txt"));
+    }
+
+    SECTION("Exclusion wins and prunes contents")
+    {
+        filter.include("*.txt", PatternType::Glob);
+        filter.exclude("secret", PatternType::Glob);
+        REQUIRE(filter.is_selected("a/b.txt"));
+        REQUIRE(!filter.is_selected("secret/b.txt"));
+        REQUIRE(!filter.may_contain_selected("secret"));
+    }
+
+    SECTION("Regexes")
+    {
+        filter.include("^data/.*\\.txt$", PatternType::Regex);
+        REQUIRE(filter.is_selected("data/x/b.txt"));
+        REQUIRE(!filter.is_selected("other/b.txt"));
+        REQUIRE(filter.may_contain_selected("other"));
+        REQUIRE_THROWS_AS(
+            filter.include("(", PatternType::Regex), err::UsageError);
+    }
+}
+
+TEST_CASE("Unpacking with entry filters", "[flow]")
+{
+    const auto inner_arc_content = make_archive(
+        {
+            tests::stub_file("wanted.txt", "1"_b),
+            tests::stub_file("unwanted.txt", "2"_b),
+        });
+
+    const auto outer_arc_content = make_archive(
+        {
+            tests::stub_file("image.png", "3"_b),
+            tests::stub_file("inner.arc", inner_arc_content),
+            tests::stub_file("other.arc", inner_arc_content),
+        });
+
+    io::File input_file("outer.arc", outer_arc_content);
+    EntryFilter filter;
+    std::vector<std::string> read_names;
+
+    SECTION("Entries that cannot lead to a match are not read")
+    {
+        filter.include("inner.arc/wanted.txt", PatternType::Glob);
+        const auto saved_names = unpack(input_file, filter, read_names);
+        REQUIRE((saved_names
+            == std::vector<std::string>{"outer.arc/inner.arc/wanted.txt"}));
+        REQUIRE((read_names
+            == std::vector<std::string>{"inner.arc", "wanted.txt"}));
+    }
+
+    SECTION("Excluded archives are not read")
+    {
+        filter.exclude("other.arc", PatternType::Glob);
+        filter.exclude("*.png", PatternType::Glob);
+        const auto saved_names = unpack(input_file, filter, read_names);
+        REQUIRE((saved_names == std::vector<std::string>{
+            "outer.arc/inner.arc/unwanted.txt",
+            "outer.arc/inner.arc/wanted.txt",
+        }));
+        REQUIRE((read_names == std::vector<std::string>{
+            "inner.arc", "unwanted.txt", "wanted.txt"
+        }));
+    }
+}
@@ -0,0 +1,176 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/entry_lister.h"
+#include <sstream>
+#include "dec/base_archive_decoder.h"
+#include "flow/file_saver_callback.h"
+#include "flow/parallel_unpacker.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/catch.h"
+#include "test_support/common.h"
+#include "test_support/file_support.h"
+
+using namespace au;
+using namespace au::dec;
+
+namespace
+{
+    class TestArchiveDecoder final : public BaseArchiveDecoder
+    {
+    public:
+        std::vector<std::string> get_linked_formats() const override;
+
+    protected:
+        bool is_recognized_impl(io::File &input_file) const override;
+
+        std::unique_ptr<ArchiveMeta> read_meta_impl(
+            const Logger &logger, io::File &input_file) const override;
+
+        std::unique_ptr<io::File> read_file_impl(
+            const Logger &logger,
+            io::File &input_file,
+            const ArchiveMeta &m,
+            const ArchiveEntry &e) const override;
+    };
+}
+
+static bstr make_archive(
+    std::initializer_list<std::shared_ptr<io::File>> input_files)
+{
+    io::MemoryByteStream tmp_stream;
+    for (auto &input_file : input_files)
+    {
+        const auto content = input_file->stream.seek(0).read_to_eof();
+        tmp_stream.write(input_file->path.str());
+        tmp_stream.write<u8>(0);
+        tmp_stream.write_le<u32>(content.size());
+        tmp_stream.write(content);
+    }
+    return tmp_stream.seek(0).read_to_eof();
+}
+
+std::vector<std::string> TestArchiveDecoder::get_linked_formats() const
+{
+    return {"test/test-archive"};
+}
+
+bool TestArchiveDecoder::is_recognized_impl(io::File &input_file) const
+{
+    return input_file.path.has_extension("arc");
+}
+
+std::unique_ptr<ArchiveMeta> TestArchiveDecoder::read_meta_impl(
+    const Logger &logger, io::File &input_file) const
+{
+    input_file.stream.seek(0);
+    auto meta = std::make_unique<ArchiveMeta>();
+    while (input_file.stream.left())
+    {
+        auto entry = std::make_unique<PlainArchiveEntry>();
+        entry->path = input_file.stream.read_to_zero().str();
+        entry->size = input_file.stream.read_le<u32>();
+        entry->offset = input_file.stream.pos();
+        input_file.stream.skip(entry->size);
+        meta->entries.push_back(std::move(entry));
+    }
+    return meta;
+}
+
+std::unique_ptr<io::File> TestArchiveDecoder::read_file_impl(
+    const Logger &logger,
+    io::File &input_file,
+    const ArchiveMeta &,
+    const ArchiveEntry &e) const
+{
+    const auto entry = static_cast<const PlainArchiveEntry*>(&e);
+    const auto data = input_file.stream.seek(entry->offset).read(entry->size);
+    return std::make_unique<io::File>(entry->path, data);
+}
+
+static std::string list_entries(
+    io::File &input_file, const bool enable_nested_decoding)
+{
+    auto registry = Registry::create_mock();
+    registry->add_decoder(
+        "test/test-archive",
+        []() { return std::make_shared<TestArchiveDecoder>(); });
+
+    Logger dummy_logger;
+    dummy_logger.mute();
+
+    size_t saved_file_count = 0;
+    const flow::FileSaverCallback file_saver(
+        [&](std::shared_ptr<io::File>) { saved_file_count++; });
+
+    flow::ParallelUnpackerContext context(
+        dummy_logger,
+        file_saver,
+        *registry,
+        enable_nested_decoding,
+        {},
+        {"test/test-archive"});
+
+    std::stringstream output;
+    flow::EntryLister entry_lister(output);
+    flow::ParallelUnpacker unpacker(context);
+    unpacker.set_entry_lister(entry_lister);
+    unpacker.add_input_file(
+        input_file.path,
+        [&]() { return std::make_shared<io::File>(input_file); });
+    REQUIRE(unpacker.run(1));
+    REQUIRE(saved_file_count == 0);
+    return output.str();
+}
+
+TEST_CASE("Listing archive entries", "[flow]")
+{
+    const auto inner_arc_content = make_archive(
+        {
+            tests::stub_file("nested/\"quoted\".txt", "text"_b),
+        });
+
+    const auto outer_arc_content = make_archive(
+        {
+            tests::stub_file("text.txt", "abc"_b),
+            tests::stub_file("inner.arc", inner_arc_content),
+        });
+
+    io::File input_file("outer.arc", outer_arc_content);
+
+    SECTION("Recursive")
+    {
+        REQUIRE(list_entries(input_file, true) ==
+            "{\"archive\":\"outer.arc\",\"decoder\":\"test/test-archive\","
+                "\"path\":\"text.txt\",\"offset\":13,\"size\":3}\n"
+            "{\"archive\":\"outer.arc\",\"decoder\":\"test/test-archive\","
+                "\"path\":\"inner.arc\",\"offset\":30,\"size\":28}\n"
+            "{\"archive\":\"outer.arc/inner.arc\","
+                "\"decoder\":\"test/test-archive\","
+                "\"path\":\"nested/\\\"quoted\\\".txt\","
+                "\"offset\":24,\"size\":4}\n");
+    }
+
+    SECTION("Non-recursive")
+    {
+        REQUIRE(list_entries(input_file, false) ==
+            "{\"archive\":\"outer.arc\",\"decoder\":\"test/test-archive\","
+                "\"path\":\"text.txt\",\"offset\":13,\"size\":3}\n"
+            "{\"archive\":\"outer.arc\",\"decoder\":\"test/test-archive\","
+                "\"path\":\"inner.arc\",\"offset\":30,\"size\":28}\n");
+    }
+}
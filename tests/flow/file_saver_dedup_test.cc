@@ -0,0 +1,65 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/file_saver_dedup.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+static bstr read_file(const io::path &path)
+{
+    io::FileByteStream file_stream(path, io::FileMode::Read);
+    return file_stream.read_to_eof();
+}
+
+TEST_CASE("FileSaverDedup", "[core]")
+{
+    const io::path dir = "dedup_test";
+    try
+    {
+        const flow::FileSaverDedup file_saver(dir, true);
+        file_saver.save(std::make_shared<io::File>("a.txt", "same"_b));
+        file_saver.save(std::make_shared<io::File>("b.txt", "other"_b));
+        file_saver.save(std::make_shared<io::File>("sub/c.txt", "same"_b));
+        const auto renamed_path = file_saver.save(
+            std::make_shared<io::File>("a.txt", "same"_b));
+        const auto staged_file = file_saver.create_file("d.txt");
+        staged_file->stream.write("same"_b);
+        file_saver.save(staged_file);
+
+        REQUIRE(file_saver.get_saved_file_count() == 5);
+        REQUIRE(file_saver.get_linked_file_count() == 3);
+        REQUIRE(renamed_path == dir / "a(1).txt");
+        REQUIRE(read_file(dir / "a.txt") == "same"_b);
+        REQUIRE(read_file(dir / "b.txt") == "other"_b);
+        REQUIRE(read_file(dir / "sub/c.txt") == "same"_b);
+        REQUIRE(read_file(dir / "a(1).txt") == "same"_b);
+        REQUIRE(read_file(dir / "d.txt") == "same"_b);
+        REQUIRE(boost::filesystem::hard_link_count(
+            (dir / "a.txt").str()) == 4);
+        REQUIRE(boost::filesystem::hard_link_count(
+            (dir / "b.txt").str()) == 1);
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(dir.str());
+        throw;
+    }
+    boost::filesystem::remove_all(dir.str());
+}
@@ -74,6 +74,20 @@ TEST_CASE("FileSaver", "[core]")
         do_test(u8"不用意な変換.out");
     }
 
+    SECTION("Files created by the saver")
+    {
+        const flow::FileSaverHdd file_saver(".", true);
+        const auto file = file_saver.create_file("test.out");
+        file->stream.write("test"_b);
+        file_saver.save(file);
+        REQUIRE(io::exists("test.out"));
+        {
+            io::FileByteStream file_stream("test.out", io::FileMode::Read);
+            REQUIRE(file_stream.read_to_eof() == "test"_b);
+        }
+        io::remove("test.out");
+    }
+
     SECTION("Two file savers overwrite the same file")
     {
         const flow::FileSaverHdd file_saver1(".", true);
@@ -0,0 +1,125 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/file_saver_pack.h"
+#include "algo/pack/zlib.h"
+#include "algo/range.h"
+#include "io/file_system.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+static bstr save_and_read(
+    const flow::PackFormat format,
+    const std::vector<std::shared_ptr<io::File>> &files)
+{
+    const io::path path = "test.pack";
+    {
+        flow::FileSaverPack file_saver(path, format);
+        for (const auto &file : files)
+            file_saver.save(file);
+        file_saver.finish();
+        REQUIRE(file_saver.get_saved_file_count() == files.size());
+    }
+    bstr data;
+    {
+        io::FileByteStream file_stream(path, io::FileMode::Read);
+        data = file_stream.read_to_eof();
+    }
+    io::remove(path);
+    return data;
+}
+
+TEST_CASE("FileSaverPack", "[core]")
+{
+    const auto long_name = std::string(120, 'x') + "/" + "name.txt";
+    const std::vector<std::shared_ptr<io::File>> files
+    {
+        std::make_shared<io::File>("dir/test.txt", "test"_b),
+        std::make_shared<io::File>("dir/test.txt", "again"_b),
+        std::make_shared<io::File>(long_name, bstr(1000, 'a')),
+    };
+
+    SECTION("Tar")
+    {
+        const auto data = save_and_read(flow::PackFormat::Tar, files);
+        REQUIRE(data.size() == 512 * 2 + 512 * 2 + 512 * 3 + 512 * 2);
+        io::MemoryByteStream stream(data);
+
+        REQUIRE(stream.seek(0).read_to_zero() == "dir/test.txt"_b);
+        REQUIRE(stream.seek(124).read_to_zero() == "00000000004"_b);
+        REQUIRE(stream.seek(257).read_to_zero() == "ustar"_b);
+        REQUIRE(stream.seek(512).read(4) == "test"_b);
+
+        REQUIRE(stream.seek(1024).read_to_zero() == "dir/test(1).txt"_b);
+        REQUIRE(stream.seek(1536).read(5) == "again"_b);
+
+        REQUIRE(stream.seek(2048).read_to_zero() == "name.txt"_b);
+        REQUIRE(stream.seek(2048 + 124).read_to_zero() == "00000001750"_b);
+        REQUIRE(stream.seek(2048 + 345).read_to_zero()
+            == bstr(std::string(120, 'x')));
+        REQUIRE(stream.seek(2560).read(1000) == bstr(1000, 'a'));
+
+        REQUIRE(stream.seek(3584).read(1024) == bstr(1024));
+    }
+
+    SECTION("Zip")
+    {
+        const auto data = save_and_read(flow::PackFormat::Zip, files);
+        io::MemoryByteStream stream(data);
+
+        REQUIRE(stream.seek(0).read_le<u32>() == 0x04034B50);
+        REQUIRE(stream.seek(8).read_le<u16>() == 0);
+        REQUIRE(stream.seek(26).read_le<u16>() == 12);
+        REQUIRE(stream.seek(30).read(12) == "dir/test.txt"_b);
+        REQUIRE(stream.read(4) == "test"_b);
+
+        stream.seek(data.size() - 22);
+        REQUIRE(stream.read_le<u32>() == 0x06054B50);
+        stream.skip(4);
+        REQUIRE(stream.read_le<u16>() == 3);
+        REQUIRE(stream.read_le<u16>() == 3);
+        stream.skip(4);
+        const auto directory_offset = stream.read_le<u32>();
+
+        stream.seek(directory_offset);
+        for (const auto i : algo::range(2))
+        {
+            REQUIRE(stream.read_le<u32>() == 0x02014B50);
+            stream.seek(stream.pos() + 24);
+            const auto name_size = stream.read_le<u16>();
+            stream.skip(12);
+            stream.skip(4 + name_size);
+        }
+        REQUIRE(stream.read_le<u32>() == 0x02014B50);
+        stream.skip(6);
+        REQUIRE(stream.read_le<u16>() == 8);
+        stream.skip(8);
+        const auto compressed_size = stream.read_le<u32>();
+        REQUIRE(stream.read_le<u32>() == 1000);
+        stream.skip(14);
+        const auto offset = stream.read_le<u32>();
+        REQUIRE(stream.read(long_name.size()) == bstr(long_name));
+
+        stream.seek(offset + 30 + long_name.size());
+        REQUIRE(algo::pack::zlib_inflate(
+                stream.read(compressed_size),
+                algo::pack::ZlibKind::RawDeflate)
+            == bstr(1000, 'a'));
+    }
+}
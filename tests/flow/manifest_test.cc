@@ -0,0 +1,121 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/manifest.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+static void write_file(const io::path &path, const bstr &content)
+{
+    io::FileByteStream(path, io::FileMode::Write).write(content);
+}
+
+TEST_CASE("Manifest", "[core]")
+{
+    const io::path dir = "manifest_test";
+    const auto manifest_path = dir / "manifest.txt";
+    const auto input_path = dir / "input.arc";
+    const auto output_path = dir / "output.txt";
+
+    io::create_directories(dir);
+    try
+    {
+        write_file(input_path, "input"_b);
+        write_file(output_path, "output"_b);
+        {
+            flow::Manifest manifest(manifest_path, dir, "");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+            manifest.begin_input(input_path);
+            manifest.set_decoder(input_path, "test/arc");
+            manifest.add_output(input_path, output_path);
+            manifest.save();
+        }
+
+        SECTION("Unchanged input")
+        {
+            flow::Manifest manifest(manifest_path, dir, "");
+            REQUIRE(manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Touched input with the same contents")
+        {
+            boost::filesystem::last_write_time(
+                input_path.str(), io::last_write_time(input_path) - 100);
+            flow::Manifest manifest(manifest_path, dir, "");
+            REQUIRE(manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Changed input")
+        {
+            write_file(input_path, "INPUT"_b);
+            boost::filesystem::last_write_time(
+                input_path.str(), io::last_write_time(input_path) - 100);
+            flow::Manifest manifest(manifest_path, dir, "");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Other options")
+        {
+            flow::Manifest manifest(manifest_path, dir, "--include=*.txt");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Other output directory")
+        {
+            flow::Manifest manifest(manifest_path, dir / "other", "");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Unpacking again with other options")
+        {
+            flow::Manifest manifest(manifest_path, dir, "--dedup");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+            manifest.begin_input(input_path);
+            manifest.add_output(input_path, output_path);
+            REQUIRE(manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Missing output")
+        {
+            io::remove(output_path);
+            flow::Manifest manifest(manifest_path, dir, "");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+        }
+
+        SECTION("Failed input is not remembered")
+        {
+            {
+                flow::Manifest manifest(manifest_path, dir, "");
+                manifest.begin_input(input_path);
+                manifest.mark_failed(input_path);
+                REQUIRE(!manifest.is_up_to_date(input_path));
+                manifest.save();
+            }
+            flow::Manifest manifest(manifest_path, dir, "");
+            REQUIRE(!manifest.is_up_to_date(input_path));
+        }
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(dir.str());
+        throw;
+    }
+    boost::filesystem::remove_all(dir.str());
+}
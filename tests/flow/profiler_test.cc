@@ -0,0 +1,70 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/profiler.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::flow;
+
+TEST_CASE("Profiler", "[flow]")
+{
+    const io::path path = "profiler_test.json";
+    Profiler profiler;
+    const auto begin = Profiler::Clock::now();
+    profiler.add(
+        "test/\"quoted\"",
+        ProfileStage::Recognition,
+        begin,
+        begin + std::chrono::microseconds(1500),
+        123);
+    {
+        ProfileScope scope(nullptr, "test/ignored", ProfileStage::Decode);
+        ProfileScope other_scope(&profiler, "test/other", ProfileStage::Save);
+        other_scope.set_bytes(456);
+    }
+
+    Logger dummy_logger;
+    dummy_logger.mute();
+    profiler.print_summary(dummy_logger);
+
+    try
+    {
+        profiler.save_trace(path);
+        const auto trace = io::FileByteStream(path, io::FileMode::Read)
+            .read_to_eof().str();
+        REQUIRE(trace.find(
+            "{\"name\":\"recognize\",\"cat\":\"test/\\\"quoted\\\"\","
+                "\"ph\":\"X\",")
+            != std::string::npos);
+        REQUIRE(trace.find("\"dur\":1500,\"pid\":1,\"tid\":0,"
+                "\"args\":{\"bytes\":123}}")
+            != std::string::npos);
+        REQUIRE(trace.find("\"name\":\"save\",\"cat\":\"test/other\"")
+            != std::string::npos);
+        REQUIRE(trace.find("\"bytes\":456") != std::string::npos);
+        REQUIRE(trace.find("test/ignored") == std::string::npos);
+    }
+    catch (...)
+    {
+        io::remove(path);
+        throw;
+    }
+    io::remove(path);
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/read_ahead.h"
+#include "algo/range.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::flow;
+
+static std::unique_ptr<dec::PlainArchiveEntry> make_entry(
+    const uoff_t offset, const size_t size)
+{
+    auto entry = std::make_unique<dec::PlainArchiveEntry>();
+    entry->offset = offset;
+    entry->size = size;
+    return entry;
+}
+
+TEST_CASE("ReadAhead", "[flow]")
+{
+    const io::path path = "read_ahead_test.dat";
+    bstr content(300000);
+    for (const auto i : algo::range(content.size()))
+        content[i] = i * 7;
+    {
+        io::FileByteStream output_stream(path, io::FileMode::Write);
+        output_stream.write(content);
+    }
+
+    try
+    {
+        const auto input_file
+            = std::make_shared<io::File>(path, io::FileMode::Read);
+
+        std::vector<std::unique_ptr<dec::PlainArchiveEntry>> entries;
+        entries.push_back(make_entry(0, 1000));
+        entries.push_back(make_entry(1000, 5000));
+        entries.push_back(make_entry(200000, 100000));
+        entries.push_back(make_entry(6000, 0));
+        std::vector<const dec::ArchiveEntry*> entry_ptrs;
+        for (const auto &entry : entries)
+            entry_ptrs.push_back(entry.get());
+
+        SECTION("Entries are served from prefetched data")
+        {
+            size_t budget = 0;
+            SECTION("Large budget") { budget = 1000000; }
+            SECTION("Budget smaller than any entry") { budget = 10; }
+
+            ReadAhead read_ahead(input_file, entry_ptrs, budget);
+            for (const auto i : algo::range(3))
+            {
+                const auto &entry = *entries[i];
+                auto stream = read_ahead.open(entry);
+                REQUIRE(stream);
+                REQUIRE(stream->size() == content.size());
+                REQUIRE(stream->seek(entry.offset).read(entry.size)
+                    == content.substr(entry.offset, entry.size));
+                REQUIRE(stream->seek(0).read(10) == content.substr(0, 10));
+                REQUIRE(stream->clone()->read(10) == content.substr(10, 10));
+            }
+        }
+
+        SECTION("Entries without data or not given are not prefetched")
+        {
+            dec::PlainArchiveEntry other_entry;
+            other_entry.offset = 0;
+            other_entry.size = 10;
+            ReadAhead read_ahead(input_file, entry_ptrs, 1000000);
+            REQUIRE(!read_ahead.open(*entries[3]));
+            REQUIRE(!read_ahead.open(other_entry));
+        }
+
+        SECTION("Opening out of order with a full budget does not block")
+        {
+            ReadAhead read_ahead(input_file, entry_ptrs, 10);
+            auto stream = read_ahead.open(*entries[2]);
+            if (stream)
+            {
+                REQUIRE(stream->seek(200000).read(100000)
+                    == content.substr(200000, 100000));
+            }
+            REQUIRE(read_ahead.open(*entries[0]));
+        }
+    }
+    catch (...)
+    {
+        io::remove(path);
+        throw;
+    }
+    io::remove(path);
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/scheduling_policy.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::flow;
+
+static std::vector<std::string> get_names(
+    const std::vector<const dec::ArchiveEntry*> &entries)
+{
+    std::vector<std::string> names;
+    for (const auto entry : entries)
+        names.push_back(entry->path.str());
+    return names;
+}
+
+TEST_CASE("Scheduling policies", "[flow]")
+{
+    dec::PlainArchiveEntry entry1;
+    entry1.path = "1";
+    entry1.offset = 50;
+    entry1.size = 10;
+
+    dec::CompressedArchiveEntry entry2;
+    entry2.path = "2";
+    entry2.offset = 100;
+    entry2.size_orig = 1000;
+    entry2.size_comp = 5;
+
+    dec::PlainArchiveEntry entry3;
+    entry3.path = "3";
+    entry3.offset = 200;
+    entry3.size = 50;
+
+    dec::ArchiveEntry entry4;
+    entry4.path = "4";
+
+    const std::vector<const dec::ArchiveEntry*> entries
+        = {&entry1, &entry2, &entry3, &entry4};
+
+    SECTION("Default")
+    {
+        REQUIRE((get_names(order_entries(entries, SchedulingPolicy::Default))
+            == std::vector<std::string>{"4", "3", "2", "1"}));
+    }
+
+    SECTION("Largest first")
+    {
+        REQUIRE((get_names(
+                order_entries(entries, SchedulingPolicy::LargestFirst))
+            == std::vector<std::string>{"2", "3", "1", "4"}));
+    }
+
+    SECTION("Offset order")
+    {
+        REQUIRE((get_names(
+                order_entries(entries, SchedulingPolicy::OffsetOrder))
+            == std::vector<std::string>{"1", "2", "3", "4"}));
+    }
+}
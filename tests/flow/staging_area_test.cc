@@ -0,0 +1,85 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/staging_area.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+static size_t count_files(const io::path &dir)
+{
+    size_t count = 0;
+    for (const auto &path : io::directory_range(dir))
+        count++;
+    return count;
+}
+
+static bstr read_file(const io::path &path)
+{
+    io::FileByteStream file_stream(path, io::FileMode::Read);
+    return file_stream.read_to_eof();
+}
+
+TEST_CASE("StagingArea", "[core]")
+{
+    const io::path dir = "staging_test";
+    try
+    {
+        const flow::StagingArea staging_area(dir);
+
+        SECTION("Files are written to disk and moved into place")
+        {
+            const auto file = staging_area.create_file("a.txt");
+            file->stream.write("test"_b);
+            REQUIRE(file->path == io::path("a.txt"));
+            REQUIRE(count_files(dir) == 1);
+            REQUIRE(staging_area.move(file, dir / "a.txt"));
+            REQUIRE(count_files(dir) == 1);
+            REQUIRE(read_file(dir / "a.txt") == "test"_b);
+        }
+
+        SECTION("Files that aren't moved are removed")
+        {
+            staging_area.create_file("a.txt")->stream.write("test"_b);
+            REQUIRE(count_files(dir) == 0);
+        }
+
+        SECTION("Copies of files can be read before they're moved")
+        {
+            const auto file = staging_area.create_file("a.txt");
+            file->stream.write("test"_b);
+            io::File file_copy(*file);
+            REQUIRE(file_copy.stream.seek(0).read_to_eof() == "test"_b);
+            REQUIRE(file->stream.seek(0).read_to_eof() == "test"_b);
+        }
+
+        SECTION("Other files are not moved")
+        {
+            const auto file = std::make_shared<io::File>("a.txt", "test"_b);
+            REQUIRE(!staging_area.move(file, dir / "a.txt"));
+            REQUIRE(!io::exists(dir / "a.txt"));
+        }
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(dir.str());
+        throw;
+    }
+    boost::filesystem::remove_all(dir.str());
+}
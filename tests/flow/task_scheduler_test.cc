@@ -0,0 +1,111 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct Usage final
+    {
+        std::mutex mutex;
+        size_t current = 0;
+        size_t peak = 0;
+        size_t concurrent_with_large = 0;
+        bool large_running = false;
+    };
+
+    class TestTask final : public ITask
+    {
+    public:
+        TestTask(Usage &usage, const size_t memory_estimate);
+        bool work() const override;
+        size_t get_memory_estimate() const override;
+
+    private:
+        Usage &usage;
+        const size_t memory_estimate;
+    };
+}
+
+static const size_t large_size = 1000;
+
+TestTask::TestTask(Usage &usage, const size_t memory_estimate)
+    : usage(usage), memory_estimate(memory_estimate)
+{
+}
+
+bool TestTask::work() const
+{
+    {
+        std::unique_lock<std::mutex> lock(usage.mutex);
+        usage.current += memory_estimate;
+        usage.peak = std::max(usage.peak, usage.current);
+        if (memory_estimate == large_size)
+            usage.large_running = true;
+        if (usage.large_running && usage.current != large_size)
+            usage.concurrent_with_large++;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    {
+        std::unique_lock<std::mutex> lock(usage.mutex);
+        usage.current -= memory_estimate;
+        if (memory_estimate == large_size)
+            usage.large_running = false;
+    }
+    return true;
+}
+
+size_t TestTask::get_memory_estimate() const
+{
+    return memory_estimate;
+}
+
+TEST_CASE("TaskScheduler", "[flow]")
+{
+    Usage usage;
+    TaskScheduler task_scheduler;
+    for (const auto i : algo::range(20))
+        task_scheduler.push_back(std::make_shared<TestTask>(usage, 40));
+    task_scheduler.push_back(std::make_shared<TestTask>(usage, large_size));
+    for (const auto i : algo::range(20))
+        task_scheduler.push_back(std::make_shared<TestTask>(usage, 40));
+
+    SECTION("Without memory budget")
+    {
+        const auto result = task_scheduler.run(4);
+        REQUIRE(result.success_count == 41);
+        REQUIRE(result.error_count == 0);
+    }
+
+    SECTION("With memory budget")
+    {
+        task_scheduler.set_memory_budget(100);
+        const auto result = task_scheduler.run(4);
+        REQUIRE(result.success_count == 41);
+        REQUIRE(result.error_count == 0);
+        REQUIRE(usage.peak == large_size);
+        REQUIRE(usage.concurrent_with_large == 0);
+    }
+}
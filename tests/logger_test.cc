@@ -0,0 +1,147 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "logger.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+namespace
+{
+    class CoutCapture final
+    {
+    public:
+        CoutCapture() : old_buffer(std::cout.rdbuf(stream.rdbuf()))
+        {
+        }
+
+        ~CoutCapture()
+        {
+            std::cout.rdbuf(old_buffer);
+        }
+
+        std::string str() const
+        {
+            return stream.str();
+        }
+
+    private:
+        std::stringstream stream;
+        std::streambuf *old_buffer;
+    };
+}
+
+TEST_CASE("Logger", "[core]")
+{
+    SECTION("Unbuffered messages are written right away")
+    {
+        CoutCapture capture;
+        Logger logger;
+        logger.disable_colors();
+        logger.set_prefix("prefix: ");
+        logger.info("%d\n", 1);
+        REQUIRE(capture.str() == "prefix: 1\n");
+    }
+
+    SECTION("Muted messages are not written")
+    {
+        CoutCapture capture;
+        Logger logger;
+        logger.disable_colors();
+        logger.mute(Logger::MessageType::Info);
+        logger.info("muted\n");
+        logger.success("unmuted\n");
+        REQUIRE(capture.str() == "unmuted\n");
+    }
+
+    SECTION("Buffered messages are written on flush")
+    {
+        CoutCapture capture;
+        Logger logger1;
+        Logger logger2;
+        logger1.disable_colors();
+        logger2.disable_colors();
+        logger1.enable_buffering();
+        logger1.info("1a ");
+        logger2.info("2\n");
+        logger1.success("1b\n");
+        REQUIRE(capture.str() == "2\n");
+        logger1.flush();
+        REQUIRE(capture.str() == "2\n1a 1b\n");
+    }
+
+    SECTION("Buffered messages are written on destruction")
+    {
+        CoutCapture capture;
+        {
+            Logger logger;
+            logger.disable_colors();
+            logger.enable_buffering();
+            logger.info("message\n");
+            REQUIRE(capture.str() == "");
+        }
+        REQUIRE(capture.str() == "message\n");
+    }
+
+    SECTION("Summaries flush buffered messages first")
+    {
+        CoutCapture capture;
+        Logger logger;
+        logger.disable_colors();
+        logger.enable_buffering();
+        logger.info("1\n");
+        logger.log(Logger::MessageType::Summary, "2\n");
+        REQUIRE(capture.str() == "1\n2\n");
+    }
+
+    SECTION("Buffering loggers can be shared between threads")
+    {
+        CoutCapture capture;
+        {
+            Logger logger;
+            logger.disable_colors();
+            logger.enable_buffering();
+            std::vector<std::thread> threads;
+            for (const auto i : algo::range(4))
+            {
+                threads.push_back(std::thread([&]()
+                {
+                    for (const auto j : algo::range(1000))
+                        logger.info("message\n");
+                }));
+            }
+            for (auto &thread : threads)
+                thread.join();
+        }
+        REQUIRE(capture.str().size() == 4 * 1000 * 8);
+    }
+
+    SECTION("Copies inherit buffering")
+    {
+        Logger logger;
+        logger.enable_buffering();
+        REQUIRE(Logger(logger).buffering_enabled());
+        logger.disable_buffering();
+        REQUIRE(!Logger(logger).buffering_enabled());
+    }
+}
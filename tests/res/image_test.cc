@@ -269,3 +269,88 @@ TEST_CASE("Image offsetting", "[res]")
         }
     }
 }
+
+TEST_CASE("Image overlay kinds", "[res]")
+{
+    SECTION("Overwriting non-transparent pixels")
+    {
+        auto overlay = create_test_image(5, 5);
+        for (const auto x : algo::range(overlay.width()))
+        for (const auto y : algo::range(overlay.height()))
+            overlay.at(x, y).a = x & 1 ? 0xFF : 0;
+        res::Image base(5, 5);
+        for (auto &c : base)
+            c = {1, 2, 3, 4};
+        base.overlay(
+            overlay, res::Image::OverlayKind::OverwriteNonTransparent);
+        for (const auto x : algo::range(base.width()))
+        for (const auto y : algo::range(base.height()))
+        {
+            if (x & 1)
+                REQUIRE(base.at(x, y) == overlay.at(x, y));
+            else
+                REQUIRE((base.at(x, y) == res::Pixel{1, 2, 3, 4}));
+        }
+    }
+
+    SECTION("Adding pixels")
+    {
+        const auto overlay = create_test_image(5, 5);
+        res::Image base(5, 5);
+        for (auto &c : base)
+            c = {1, 2, 0xFF, 4};
+        base.overlay(overlay, 1, 0, res::Image::OverlayKind::AddSimple);
+        for (const auto y : algo::range(base.height()))
+        {
+            REQUIRE((base.at(0, y) == res::Pixel{1, 2, 0xFF, 4}));
+            for (const auto x : algo::range(1, base.width()))
+            {
+                REQUIRE(base.at(x, y).b == 1);
+                REQUIRE(base.at(x, y).g == ((2 + y) & 0xFF));
+                REQUIRE(base.at(x, y).r == ((0xFF + x - 1) & 0xFF));
+                REQUIRE(base.at(x, y).a == 4);
+            }
+        }
+    }
+}
+
+TEST_CASE("Image flipping", "[res]")
+{
+    SECTION("Vertical")
+    {
+        auto image = create_test_image(4, 5);
+        image.flip_vertically();
+        for (const auto x : algo::range(image.width()))
+        for (const auto y : algo::range(image.height()))
+        {
+            REQUIRE(image.at(x, y).r == x);
+            REQUIRE(image.at(x, y).g == image.height() - 1 - y);
+        }
+    }
+
+    SECTION("Horizontal")
+    {
+        auto image = create_test_image(5, 4);
+        image.flip_horizontally();
+        for (const auto x : algo::range(image.width()))
+        for (const auto y : algo::range(image.height()))
+        {
+            REQUIRE(image.at(x, y).r == image.width() - 1 - x);
+            REQUIRE(image.at(x, y).g == y);
+        }
+    }
+}
+
+TEST_CASE("Image masking", "[res]")
+{
+    auto image = create_test_image(5, 4);
+    const auto mask = create_test_image(5, 4);
+    image.apply_mask(mask);
+    for (const auto x : algo::range(image.width()))
+    for (const auto y : algo::range(image.height()))
+    {
+        REQUIRE(image.at(x, y).r == x);
+        REQUIRE(image.at(x, y).a == x);
+    }
+    REQUIRE_THROWS(image.apply_mask(create_test_image(4, 4)));
+}